@@ -9,6 +9,9 @@ rgb888_t blue888 =  {"Blue",  0, 0, 255};
 rgb565_t yellow565 = {"Yellow", 31, 63, 0};
 rgb565_t purple565 = {"Purple", 31, 0, 31};
 
+void printColor(rgb888_t color);
+void printColor(rgb565_t color);
+
 void setup() {
   Serial.begin(9600);
   
@@ -36,16 +39,16 @@ void setup() {
   Serial.println("Similarity between Yellow and Purple (RGB565): " + String(similarity));
 
   // Obtener colores por nombre
-  rgb888_t colorByName = get_color_by_name("Blue", COLORS);
+  rgb888_t colorByName = get_color_by_name("Blue");
   Serial.print("Color by Name (Blue): ");
   printColor(colorByName);
 
   // Obtener colores similares de la lista de colores predefinidos
-  rgb888_t similarColor888 = get_similar_color888(blue888, COLORS);
+  rgb888_t similarColor888 = get_similar_color888(blue888, COLORS, COLORS_COUNT);
   Serial.print("Most Similar Color to Blue (RGB888): ");
   printColor(similarColor888);
 
-  rgb565_t similarColor565 = get_similar_color565(purple565, COLORS);
+  rgb565_t similarColor565 = get_similar_color565(purple565, COLORS, COLORS_COUNT);
   Serial.print("Most Similar Color to Purple (RGB565): ");
   printColor(similarColor565);
 }
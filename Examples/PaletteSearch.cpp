@@ -0,0 +1,79 @@
+#include <ColorsPalette.h>
+
+// Compara la busqueda lineal del color mas parecido con el k-d tree en paletas de distintos tamanos
+
+// Tamanos de paleta a medir (las paletas grandes solo caben en el host)
+#if defined(__AVR__)
+const uint32_t PALETTE_SIZES[] = {16, 64, 256};
+const uint16_t QUERIES = 200;
+#else
+const uint32_t PALETTE_SIZES[] = {16, 64, 256, 1024, 4096, 16384, 100000};
+const uint16_t QUERIES = 2000;
+#endif
+
+void benchmark(uint32_t size);
+rgb24_t random_color();
+
+void setup() {
+  Serial.begin(9600);
+  Serial.println("Palette size, linear us/query, k-d tree us/query, tree build us, tree bytes, mismatches");
+  for (uint8_t i = 0; i < sizeof(PALETTE_SIZES) / sizeof(PALETTE_SIZES[0]); i++) {
+    benchmark(PALETTE_SIZES[i]);
+  }
+}
+
+void loop() {
+  // Nada en el loop
+}
+
+// Mide ambas busquedas con las mismas consultas aleatorias y cuenta las respuestas distintas
+void benchmark(uint32_t size) {
+  rgb24_t* colors = (rgb24_t*)malloc(size * sizeof(rgb24_t));
+  rgb24_t* queries = (rgb24_t*)malloc(QUERIES * sizeof(rgb24_t));
+  palette_size_t* expected = (palette_size_t*)malloc(QUERIES * sizeof(palette_size_t));
+  if (colors == nullptr || queries == nullptr || expected == nullptr) {
+    Serial.println("Not enough memory for palette size " + String((unsigned long)size));
+    free(colors);
+    free(queries);
+    free(expected);
+    return;
+  }
+  for (uint32_t i = 0; i < size; i++) colors[i] = random_color();
+  for (uint16_t i = 0; i < QUERIES; i++) queries[i] = random_color();
+
+  palette_t palette(colors, (palette_size_t)size);
+
+  // Busqueda lineal
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < QUERIES; i++) expected[i] = palette.nearest_index(queries[i]);
+  uint32_t linear_time = micros() - start;
+
+  // k-d tree
+  palette.build_index(PALETTE_INDEX_KDTREE);
+  uint16_t mismatches = 0;
+  start = micros();
+  for (uint16_t i = 0; i < QUERIES; i++) {
+    if (palette.nearest_index(queries[i]) != expected[i]) mismatches++;
+  }
+  uint32_t tree_time = micros() - start;
+
+  Serial.print(String((unsigned long)size) + ", ");
+  Serial.print(String((float)linear_time / QUERIES, 3) + ", ");
+  Serial.print(String((float)tree_time / QUERIES, 3) + ", ");
+  Serial.print(String((unsigned long)palette.kdtree().build_time_us()) + ", ");
+  Serial.print(String((unsigned long)palette.kdtree().memory_usage()) + ", ");
+  Serial.println(String(mismatches));
+
+  free(colors);
+  free(queries);
+  free(expected);
+}
+
+// Color aleatorio reproducible (xorshift32)
+rgb24_t random_color() {
+  static uint32_t state = 2463534242UL;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return rgb24_t(state & 0xFFFFFF);
+}
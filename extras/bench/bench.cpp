@@ -0,0 +1,629 @@
+// bench.cpp
+
+// Creator: JDFraire-P
+
+// Description: Host microbenchmarks of the ColorsUtils public functions (ns/op and heap allocations/op)
+
+/*  Method
+1. Each benchmark runs a warm up pass, then doubles its iteration count until a run takes at least the minimum time (20 ms by default).
+2. The reported time is the best of three runs of that length, divided by the iterations (ns/op) and by the items of the op (ns/item).
+3. Heap allocations are counted by wrapping malloc, calloc and realloc (glibc hosts), String growth and the palette structures included.
+4. Inputs come from a fixed xorshift32 sequence, so runs are comparable before and after a change.
+Usage: colors_bench [filter] [min_ms], filter keeps the benchmarks whose name contains it.
+*/
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsUtils.h>
+#include <ColorsPalette.h>
+#include <ColorsLab.h>
+#include <ColorsDither.h>
+#include <ColorsQuantize.h>
+#include <ColorsParallel.h>
+#include <ColorsBlend.h>
+#include <ColorsGradient.h>
+#include <ColorsHsv.h>
+#include <ColorsFormat.h>
+#include <ColorsCorrection.h>
+#include <ColorsDelta.h>
+#include <ColorsStats.h>
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/* ALLOCATION COUNTER */
+
+static unsigned long allocation_count = 0;
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+extern "C" void* malloc(size_t size){
+  allocation_count++;
+  return __libc_malloc(size);
+}
+extern "C" void* calloc(size_t count, size_t size){
+  allocation_count++;
+  return __libc_calloc(count, size);
+}
+extern "C" void* realloc(void* pointer, size_t size){
+  allocation_count++;
+  return __libc_realloc(pointer, size);
+}
+extern "C" void free(void* pointer){
+  __libc_free(pointer);
+}
+#define ALLOCATIONS_COUNTED 1
+#else
+#define ALLOCATIONS_COUNTED 0
+#endif
+
+/* HARNESS */
+
+// Keep a value alive without letting the compiler fold the benchmarked call
+template <typename T> static inline void keep(const T& value){
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+static const char* name_filter = nullptr;
+static double min_seconds = 0.02;
+
+// Nanoseconds of iterations calls of op
+template <typename OP> static double run(OP& op, uint64_t iterations){
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < iterations; i++) op(i);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Measure op (called with the iteration number) and print a result row, items is the work of one op (pixels, queries)
+template <typename OP> static void benchmark(const char* name, size_t size, size_t items, OP op){
+  if (name_filter != nullptr && strstr(name, name_filter) == nullptr) return;
+
+  // warm up (also builds the structures created on first use) and allocations of a single op
+  op(0);
+  unsigned long allocations = allocation_count;
+  op(1);
+  allocations = allocation_count - allocations;
+
+  uint64_t iterations = 1;
+  double time = run(op, iterations);
+  while (time < min_seconds * 1e9 && iterations < (1ULL << 40)){
+    iterations *= 2;
+    time = run(op, iterations);
+  }
+  for (int repeat = 0; repeat < 2; repeat++){
+    double again = run(op, iterations);
+    if (again < time) time = again;
+  }
+
+  double ns_op = time / (double)iterations;
+  printf("%-44s %8zu %12.2f %12.3f", name, size, ns_op, ns_op / (double)(items > 0 ? items : 1));
+  if (ALLOCATIONS_COUNTED) printf(" %10lu\n", allocations);
+  else printf(" %10s\n", "n/a");
+  fflush(stdout);
+}
+
+/* INPUTS */
+
+// Reproducible pseudo random numbers (xorshift32)
+static uint32_t random_state = 2463534242UL;
+static uint32_t random_u32(){
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+static rgb24_t random_color(){
+  return rgb24_t(random_u32() & 0xFFFFFF);
+}
+
+// Mask of a power of two sized input table
+#define INPUTS 1024
+#define INPUT(table, i) (table[(i) & (INPUTS - 1)])
+
+// Palette sizes of the list lookups
+static const size_t PALETTE_SIZES[] = {16, 50, 256, 1024, 4096};
+// Span lengths of the batch functions
+static const size_t BATCH_SIZES[] = {16, 256, 4096, 65536};
+
+/* BENCHMARKS */
+
+// Constructors of the named color types
+static void bench_constructors(){
+  std::vector<uint32_t> codes(INPUTS);
+  for (size_t i = 0; i < INPUTS; i++) codes[i] = random_u32() & 0xFFFFFF;
+
+  benchmark("rgb24_t(hex)", 1, 1, [&](uint64_t i){ keep(rgb24_t(INPUT(codes, i))); });
+  benchmark("rgb16_t(r,g,b)", 1, 1, [&](uint64_t i){ uint32_t code = INPUT(codes, i); keep(rgb16_t((uint8_t)(code >> 16), (uint8_t)(code >> 8), (uint8_t)code)); });
+  benchmark("rgb888_t()", 1, 1, [&](uint64_t){ rgb888_t color; keep(color.value); });
+  benchmark("rgb888_t(int)", 1, 1, [&](uint64_t i){ rgb888_t color((int)INPUT(codes, i)); keep(color.value); });
+  benchmark("rgb888_t(r,g,b)", 1, 1, [&](uint64_t i){ uint32_t code = INPUT(codes, i); rgb888_t color((uint8_t)(code >> 16), (uint8_t)(code >> 8), (uint8_t)code); keep(color.value); });
+  benchmark("rgb888_t(name,hex)", 1, 1, [&](uint64_t i){ rgb888_t color("Turquoise", INPUT(codes, i)); keep(color.value); });
+  benchmark("rgb888_t(name,r,g,b)", 1, 1, [&](uint64_t i){ uint32_t code = INPUT(codes, i); rgb888_t color("Turquoise", (uint8_t)(code >> 16), (uint8_t)(code >> 8), (uint8_t)code); keep(color.value); });
+  benchmark("rgb888_t(rgb24_t)", 1, 1, [&](uint64_t i){ rgb888_t color{rgb24_t(INPUT(codes, i))}; keep(color.value); });
+  benchmark("rgb565_t()", 1, 1, [&](uint64_t){ rgb565_t color; keep(color.value); });
+  benchmark("rgb565_t(int)", 1, 1, [&](uint64_t i){ rgb565_t color((int)(INPUT(codes, i) & 0xFFFF)); keep(color.value); });
+  benchmark("rgb565_t(r,g,b)", 1, 1, [&](uint64_t i){ uint32_t code = INPUT(codes, i); rgb565_t color((uint8_t)(code >> 16), (uint8_t)(code >> 8), (uint8_t)code); keep(color.value); });
+  benchmark("rgb565_t(name,hex)", 1, 1, [&](uint64_t i){ rgb565_t color("Turquoise", (uint16_t)INPUT(codes, i)); keep(color.value); });
+  benchmark("rgb565_t(name,r,g,b)", 1, 1, [&](uint64_t i){ uint32_t code = INPUT(codes, i); rgb565_t color("Turquoise", (uint8_t)(code >> 16), (uint8_t)(code >> 8), (uint8_t)code); keep(color.value); });
+  benchmark("rgb565_t(rgb16_t)", 1, 1, [&](uint64_t i){ rgb565_t color{rgb16_t((uint16_t)INPUT(codes, i))}; keep(color.value); });
+}
+
+// Single color conversions and formatters
+static void bench_conversions(){
+  std::vector<rgb888_t> colors888;
+  std::vector<rgb565_t> colors565;
+  for (size_t i = 0; i < INPUTS; i++){
+    colors888.push_back(rgb888_t(random_color()));
+    colors565.push_back(rgb565_t(rgb16_t((uint16_t)random_u32())));
+  }
+
+  benchmark("rgb888_to_rgb565(rgb24_t)", 1, 1, [&](uint64_t i){ keep(rgb888_to_rgb565((rgb24_t)INPUT(colors888, i)).value); });
+  benchmark("rgb565_to_rgb888(rgb16_t)", 1, 1, [&](uint64_t i){ keep(rgb565_to_rgb888((rgb16_t)INPUT(colors565, i)).red); });
+  benchmark("rgb888_to_rgb565(rgb888_t)", 1, 1, [&](uint64_t i){ rgb565_t color = rgb888_to_rgb565(INPUT(colors888, i)); keep(color.value); });
+  benchmark("rgb565_to_rgb888(rgb565_t)", 1, 1, [&](uint64_t i){ rgb888_t color = rgb565_to_rgb888(INPUT(colors565, i)); keep(color.value); });
+  benchmark("rgb888_to_String", 1, 1, [&](uint64_t i){ String text = rgb888_to_String(INPUT(colors888, i)); keep(text.length()); });
+  benchmark("rgb565_to_String", 1, 1, [&](uint64_t i){ String text = rgb565_to_String(INPUT(colors565, i)); keep(text.length()); });
+}
+
+// Color string formatters and parsers
+static void bench_strings(){
+  std::vector<rgb24_t> colors(INPUTS);
+  std::vector<String> texts(INPUTS);
+  for (size_t i = 0; i < INPUTS; i++){
+    colors[i] = random_color();
+    char text[COLOR_STRING_SIZE];
+    format_color(colors[i], text, sizeof(text), COLOR_FORMAT_CSS);
+    texts[i] = text;
+  }
+  char buffer[COLOR_STRING_SIZE];
+
+  benchmark("format_color(rgb24_t,HEX)", 1, 1, [&](uint64_t i){ keep(format_color(INPUT(colors, i), buffer, sizeof(buffer))); });
+  benchmark("format_color(rgb24_t,CSS_SHORT)", 1, 1, [&](uint64_t i){ keep(format_color(INPUT(colors, i), buffer, sizeof(buffer), COLOR_FORMAT_CSS_SHORT)); });
+  benchmark("format_color(rgb16_t)", 1, 1, [&](uint64_t i){ keep(format_color(rgb888_to_rgb565(INPUT(colors, i)), buffer, sizeof(buffer))); });
+  benchmark("parse_color(#rrggbb)", 1, 1, [&](uint64_t i){ rgb24_t color; keep(parse_color(INPUT(texts, i).c_str(), &color)); keep(color); });
+  benchmark("parse_color(name)", 1, 1, [&](uint64_t){ rgb24_t color; keep(parse_color("Turquoise", &color)); keep(color); });
+
+  // compact manifest (vector kernel) and the same colors with spaces after the commas (scalar parser)
+  for (size_t n : BATCH_SIZES){
+    String compact;
+    String spaced;
+    compact.reserve((unsigned int)(8 * n));
+    spaced.reserve((unsigned int)(9 * n));
+    for (size_t i = 0; i < n; i++){
+      compact += INPUT(texts, i);
+      compact += (i % 16 == 15) ? '\n' : ',';
+      spaced += INPUT(texts, i);
+      spaced += (i % 16 == 15) ? "\n" : ", ";
+    }
+    std::vector<rgb24_t> parsed(n);
+    benchmark("parse_colors(compact)", n, n, [&](uint64_t){ keep(parse_colors(compact.c_str(), compact.length(), parsed.data(), n)); });
+    benchmark("parse_colors(spaced)", n, n, [&](uint64_t){ keep(parse_colors(spaced.c_str(), spaced.length(), parsed.data(), n)); });
+  }
+}
+
+// Bulk span conversions
+static void bench_bulk(){
+  size_t largest = BATCH_SIZES[sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]) - 1];
+  std::vector<uint8_t> rgb888(largest * 3);
+  std::vector<uint32_t> rgbx(largest);
+  std::vector<uint16_t> rgb565(largest);
+  for (size_t i = 0; i < largest; i++){
+    rgbx[i] = random_u32() & 0xFFFFFF;
+    rgb888[3 * i] = (uint8_t)(rgbx[i] >> 16);
+    rgb888[3 * i + 1] = (uint8_t)(rgbx[i] >> 8);
+    rgb888[3 * i + 2] = (uint8_t)rgbx[i];
+    rgb565[i] = (uint16_t)random_u32();
+  }
+  std::vector<uint16_t> out565(largest);
+  std::vector<uint8_t> out888(largest * 3);
+  std::vector<uint32_t> outx(largest);
+
+  for (size_t n : BATCH_SIZES){
+    benchmark("convert_rgb888_to_rgb565(uint8_t)", n, n, [&](uint64_t){ convert_rgb888_to_rgb565(rgb888.data(), out565.data(), n); keep(out565[0]); });
+    benchmark("convert_rgb888_to_rgb565(uint32_t)", n, n, [&](uint64_t){ convert_rgb888_to_rgb565(rgbx.data(), out565.data(), n); keep(out565[0]); });
+    benchmark("convert_rgb565_to_rgb888(uint8_t)", n, n, [&](uint64_t){ convert_rgb565_to_rgb888(rgb565.data(), out888.data(), n); keep(out888[0]); });
+    benchmark("convert_rgb565_to_rgb888(uint32_t)", n, n, [&](uint64_t){ convert_rgb565_to_rgb888(rgb565.data(), outx.data(), n); keep(outx[0]); });
+  }
+}
+
+// Pixel format span conversions (convert<SRC, DST>)
+static void bench_formats(){
+  size_t largest = BATCH_SIZES[sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]) - 1];
+  std::vector<uint8_t> rgb888(largest * 3);
+  std::vector<uint16_t> rgb565(largest);
+  for (size_t i = 0; i < largest; i++){
+    uint32_t value = random_u32();
+    rgb888[3 * i] = (uint8_t)(value >> 16);
+    rgb888[3 * i + 1] = (uint8_t)(value >> 8);
+    rgb888[3 * i + 2] = (uint8_t)value;
+    rgb565[i] = (uint16_t)random_u32();
+  }
+  std::vector<uint8_t> out(largest * 4);
+
+  for (size_t n : BATCH_SIZES){
+    benchmark("convert<rgb888, rgb565_swapped>", n, n, [&](uint64_t){ convert<format_rgb888, format_rgb565_swapped>(rgb888.data(), out.data(), n); keep(out[0]); });
+    benchmark("convert<rgb888, bgr565>", n, n, [&](uint64_t){ convert<format_rgb888, format_bgr565>(rgb888.data(), out.data(), n); keep(out[0]); });
+    benchmark("convert<rgb888, rgb666>", n, n, [&](uint64_t){ convert<format_rgb888, format_rgb666>(rgb888.data(), out.data(), n); keep(out[0]); });
+    benchmark("convert<rgb888, rgb444>", n, n, [&](uint64_t){ convert<format_rgb888, format_rgb444>(rgb888.data(), out.data(), n); keep(out[0]); });
+    benchmark("convert<rgb888, rgb332>", n, n, [&](uint64_t){ convert<format_rgb888, format_rgb332>(rgb888.data(), out.data(), n); keep(out[0]); });
+    benchmark("convert<rgb888, grb888>", n, n, [&](uint64_t){ convert<format_rgb888, format_grb888>(rgb888.data(), out.data(), n); keep(out[0]); });
+    benchmark("convert<rgb565, bgr565>", n, n, [&](uint64_t){ convert<format_rgb565, format_bgr565>(rgb565.data(), out.data(), n); keep(out[0]); });
+    benchmark("convert<rgb565, argb8888>", n, n, [&](uint64_t){ convert<format_rgb565, format_argb8888>(rgb565.data(), out.data(), n); keep(out[0]); });
+  }
+}
+
+// Color correction tables, separate pass and fused into the packing
+static void bench_correction(){
+  size_t largest = BATCH_SIZES[sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]) - 1];
+  std::vector<rgb24_t> colors(largest);
+  for (size_t i = 0; i < largest; i++) colors[i] = rgb24_t(random_u32() & 0xFFFFFF);
+  std::vector<rgb24_t> corrected(largest);
+  std::vector<uint16_t> out565(largest);
+  std::vector<uint8_t> grb(largest * 3);
+
+  color_correction_t correction;
+  benchmark("color_correction_t::apply_gamma", 1, 1, [&](uint64_t){ correction.reset(); correction.apply_gamma(2.2); keep(correction.table(0)[128]); });
+  benchmark("color_correction_t::apply_brightness", 1, 1, [&](uint64_t){ correction.apply_brightness(250); keep(correction.table(0)[128]); });
+  correction.reset();
+  correction.apply_gamma(2.2);
+  correction.apply_white_point(rgb24_t(255, 224, 140));
+  correction.apply_brightness(128);
+
+  for (size_t n : BATCH_SIZES){
+    benchmark("correct + convert_rgb888_to_rgb565", n, n, [&](uint64_t){
+      correction.correct(colors.data(), corrected.data(), n);
+      convert_rgb888_to_rgb565((const uint8_t*)corrected.data(), out565.data(), n);
+      keep(out565[0]);
+    });
+    benchmark("color_correction_t::convert_rgb565", n, n, [&](uint64_t){ correction.convert_rgb565((const uint8_t*)colors.data(), out565.data(), n); keep(out565[0]); });
+    benchmark("color_correction_t::convert<grb888>", n, n, [&](uint64_t){ correction.convert<format_grb888>(colors.data(), grb.data(), n); keep(grb[0]); });
+  }
+}
+
+// RGB565 blending and compositing spans
+static void bench_blend(){
+  size_t largest = BATCH_SIZES[sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]) - 1];
+  std::vector<uint16_t> background(largest);
+  std::vector<uint16_t> foreground(largest);
+  std::vector<uint8_t> mask(largest);
+  std::vector<uint8_t> rgba(largest * 4);
+  for (size_t i = 0; i < largest; i++){
+    background[i] = (uint16_t)random_u32();
+    foreground[i] = (uint16_t)random_u32();
+    // glyph like coverage: mostly empty or solid, antialiased edges
+    uint32_t coverage = random_u32() % 4;
+    mask[i] = coverage == 0 ? (uint8_t)random_u32() : (coverage == 1 ? 255 : 0);
+    for (uint8_t c = 0; c < 4; c++) rgba[4 * i + c] = (uint8_t)random_u32();
+  }
+  std::vector<uint16_t> dst(largest);
+
+  benchmark("blend565(rgb16_t)", 1, 1, [&](uint64_t i){ keep(blend565(rgb16_t(INPUT(background, i)), rgb16_t(INPUT(foreground, i)), (uint8_t)i)); });
+  for (size_t n : BATCH_SIZES){
+    benchmark("blend565(span)", n, n, [&](uint64_t){ blend565(dst.data(), foreground.data(), n, 100); keep(dst[0]); });
+    benchmark("blend565(fill)", n, n, [&](uint64_t){ blend565(dst.data(), rgb16_t(0xF81F), n, 100); keep(dst[0]); });
+    benchmark("blend565_mask", n, n, [&](uint64_t){ blend565_mask(dst.data(), mask.data(), rgb16_t(0xFFFF), n); keep(dst[0]); });
+    benchmark("blend_rgba8888_over_rgb565", n, n, [&](uint64_t){ blend_rgba8888_over_rgb565(dst.data(), rgba.data(), n); keep(dst[0]); });
+    benchmark("add565(span)", n, n, [&](uint64_t){ add565(dst.data(), foreground.data(), n); keep(dst[0]); });
+    benchmark("multiply565(span)", n, n, [&](uint64_t){ multiply565(dst.data(), foreground.data(), n); keep(dst[0]); });
+  }
+}
+
+// Gradient spans, color at t and 2D fills
+static void bench_gradients(){
+  size_t largest = BATCH_SIZES[sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]) - 1];
+  std::vector<rgb24_t> colors(largest);
+  std::vector<uint16_t> words(largest);
+  std::vector<uint8_t> leds(largest * 3);
+  const gradient_stop_t stops[] = {{0, rgb24_t(0xFF0000)}, {21845, rgb24_t(0xFFFF00)}, {43690, rgb24_t(0x00C0FF)}, {65535, rgb24_t(0x400080)}};
+  const char* names[] = {"rgb", "hsv", "oklab"};
+
+  for (uint8_t s = 0; s < 3; s++){
+    gradient_t gradient(stops, 4, (gradient_space_t)s);
+    char name[48];
+    snprintf(name, sizeof(name), "gradient_t::color_at(%s)", names[s]);
+    benchmark(name, 1, 1, [&](uint64_t i){ keep(gradient.color_at((uint16_t)(i * 40503)).value()); });
+    for (size_t n : BATCH_SIZES){
+      snprintf(name, sizeof(name), "gradient_t::fill(%s)", names[s]);
+      benchmark(name, n, n, [&](uint64_t){ gradient.fill(colors.data(), n); keep(colors[0].red); });
+      snprintf(name, sizeof(name), "gradient_t::fill_rgb565(%s)", names[s]);
+      benchmark(name, n, n, [&](uint64_t){ gradient.fill_rgb565(words.data(), n); keep(words[0]); });
+      snprintf(name, sizeof(name), "gradient_t::fill_grb(%s)", names[s]);
+      benchmark(name, n, n, [&](uint64_t){ gradient.fill_grb(leds.data(), n); keep(leds[0]); });
+    }
+  }
+
+  // 320x240 display frames
+  gradient_t gradient(stops, 4, GRADIENT_OKLAB);
+  std::vector<uint16_t> frame(320 * 240);
+  benchmark("gradient_t::fill_linear(320x240)", 320 * 240, 320 * 240, [&](uint64_t){ gradient.fill_linear(frame.data(), 320, 240, 0, 20, 10, 300, 230); keep(frame[0]); });
+  benchmark("gradient_t::fill_radial(320x240)", 320 * 240, 320 * 240, [&](uint64_t){ gradient.fill_radial(frame.data(), 320, 240, 0, 160, 120, 200); keep(frame[0]); });
+}
+
+// Distances and color_similarity overloads
+static void bench_similarity(){
+  std::vector<rgb888_t> colors888;
+  std::vector<rgb565_t> colors565;
+  for (size_t i = 0; i < INPUTS; i++){
+    colors888.push_back(rgb888_t(random_color()));
+    colors565.push_back(rgb565_t(rgb16_t((uint16_t)random_u32())));
+  }
+
+  benchmark("color_distance_sq(rgb24_t)", 1, 1, [&](uint64_t i){ keep(color_distance_sq((rgb24_t)INPUT(colors888, i), (rgb24_t)INPUT(colors888, i + 1))); });
+  benchmark("color_distance_sq(rgb16_t)", 1, 1, [&](uint64_t i){ keep(color_distance_sq((rgb16_t)INPUT(colors565, i), (rgb16_t)INPUT(colors565, i + 1))); });
+  benchmark("color_distance_redmean_sq", 1, 1, [&](uint64_t i){ keep(color_distance_redmean_sq((rgb24_t)INPUT(colors888, i), (rgb24_t)INPUT(colors888, i + 1))); });
+  benchmark("color_similarity(888,888)", 1, 1, [&](uint64_t i){ keep(color_similarity(INPUT(colors888, i), INPUT(colors888, i + 1))); });
+  benchmark("color_similarity(565,565)", 1, 1, [&](uint64_t i){ keep(color_similarity(INPUT(colors565, i), INPUT(colors565, i + 1))); });
+  benchmark("color_similarity(888,565)", 1, 1, [&](uint64_t i){ keep(color_similarity(INPUT(colors888, i), INPUT(colors565, i))); });
+  benchmark("color_similarity(565,888)", 1, 1, [&](uint64_t i){ keep(color_similarity(INPUT(colors565, i), INPUT(colors888, i))); });
+}
+
+// Lookups in the named colors list
+static void bench_named_colors(){
+  std::vector<const char*> names(INPUTS);
+  std::vector<char> name_storage(COLORS_COUNT * COLOR_NAME_SIZE);
+  for (uint8_t i = 0; i < COLORS_COUNT; i++) get_color_name(i, &name_storage[i * COLOR_NAME_SIZE], COLOR_NAME_SIZE);
+  std::vector<uint32_t> codes(INPUTS);
+  for (size_t i = 0; i < INPUTS; i++){
+    uint8_t index = (uint8_t)(random_u32() % COLORS_COUNT);
+    names[i] = &name_storage[index * COLOR_NAME_SIZE];
+    codes[i] = COLORS[index].value();
+  }
+
+  benchmark("find_color_by_name", COLORS_COUNT, 1, [&](uint64_t i){ keep(find_color_by_name(INPUT(names, i))); });
+  benchmark("find_color_by_hex", COLORS_COUNT, 1, [&](uint64_t i){ keep(find_color_by_hex(INPUT(codes, i))); });
+  benchmark("get_named_color", COLORS_COUNT, 1, [&](uint64_t i){ rgb888_t color = get_named_color((uint8_t)(i % COLORS_COUNT)); keep(color.value); });
+  benchmark("get_color_by_name(name)", COLORS_COUNT, 1, [&](uint64_t i){ rgb888_t color = get_color_by_name(INPUT(names, i)); keep(color.value); });
+  benchmark("get_color_by_hex(COLORS)", COLORS_COUNT, 1, [&](uint64_t i){ rgb888_t color = get_color_by_hex((int)INPUT(codes, i), COLORS, COLORS_COUNT); keep(color.value); });
+}
+
+// List lookups over palettes of each size
+static void bench_lists(){
+  std::vector<rgb888_t> queries888;
+  std::vector<rgb565_t> queries565;
+  for (size_t i = 0; i < INPUTS; i++){
+    queries888.push_back(rgb888_t(random_color()));
+    queries565.push_back(rgb565_t(rgb16_t((uint16_t)random_u32())));
+  }
+
+  for (size_t size : PALETTE_SIZES){
+    std::vector<rgb24_t> packed(size);
+    std::vector<rgb888_t> named(size);
+    std::vector<String> names(size);
+    for (size_t i = 0; i < size; i++){
+      packed[i] = random_color();
+      names[i] = "Color " + String((unsigned long)i);
+      named[i] = rgb888_t(names[i].c_str(), packed[i].value());
+    }
+    std::vector<const char*> query_names(INPUTS);
+    std::vector<int> query_codes(INPUTS);
+    for (size_t i = 0; i < INPUTS; i++){
+      size_t index = random_u32() % size;
+      query_names[i] = names[index].c_str();
+      query_codes[i] = (int)packed[index].value();
+    }
+
+    benchmark("get_color_by_name(rgb888_t*)", size, 1, [&](uint64_t i){ rgb888_t color = get_color_by_name(INPUT(query_names, i), named.data(), size); keep(color.value); });
+    benchmark("get_color_by_hex(rgb888_t*)", size, 1, [&](uint64_t i){ rgb888_t color = get_color_by_hex(INPUT(query_codes, i), named.data(), size); keep(color.value); });
+    benchmark("get_color_by_hex(rgb24_t*)", size, 1, [&](uint64_t i){ rgb888_t color = get_color_by_hex(INPUT(query_codes, i), packed.data(), size); keep(color.value); });
+    benchmark("get_similar_color888(rgb888_t*)", size, 1, [&](uint64_t i){ rgb888_t color = get_similar_color888(INPUT(queries888, i), named.data(), size); keep(color.value); });
+    benchmark("get_similar_color565(rgb888_t*)", size, 1, [&](uint64_t i){ rgb565_t color = get_similar_color565(INPUT(queries565, i), named.data(), size); keep(color.value); });
+    benchmark("get_similar_color888(rgb24_t*)", size, 1, [&](uint64_t i){ rgb888_t color = get_similar_color888(INPUT(queries888, i), packed.data(), size); keep(color.value); });
+    benchmark("get_similar_color565(rgb24_t*)", size, 1, [&](uint64_t i){ rgb565_t color = get_similar_color565(INPUT(queries565, i), packed.data(), size); keep(color.value); });
+  }
+}
+
+// Palette searches with each search structure
+static void bench_palettes(){
+  std::vector<rgb24_t> queries(INPUTS);
+  for (size_t i = 0; i < INPUTS; i++) queries[i] = random_color();
+
+  for (size_t size : PALETTE_SIZES){
+    std::vector<rgb24_t> colors(size);
+    for (size_t i = 0; i < size; i++) colors[i] = random_color();
+
+    palette_t linear(colors.data(), (palette_size_t)size);
+    palette_t grid(colors.data(), (palette_size_t)size, PALETTE_INDEX_GRID);
+    palette_t kdtree(colors.data(), (palette_size_t)size, PALETTE_INDEX_KDTREE);
+    benchmark("palette_t::nearest_index", size, 1, [&](uint64_t i){ keep(linear.nearest_index(INPUT(queries, i))); });
+    benchmark("palette_t::nearest_index(grid)", size, 1, [&](uint64_t i){ keep(grid.nearest_index(INPUT(queries, i))); });
+    benchmark("palette_t::nearest_index(kdtree)", size, 1, [&](uint64_t i){ keep(kdtree.nearest_index(INPUT(queries, i))); });
+    benchmark("palette_t::nearest_index(OKLAB)", size, 1, [&](uint64_t i){ keep(linear.nearest_index(INPUT(queries, i), COLOR_METRIC_OKLAB)); });
+    if (size <= 256){
+      palette_t lut(colors.data(), (palette_size_t)size, PALETTE_INDEX_LUT565);
+      benchmark("palette_t::nearest_index(lut565)", size, 1, [&](uint64_t i){ keep(lut.nearest_index(rgb888_to_rgb565(INPUT(queries, i)))); });
+      uint8_t pixels[INPUTS];
+      uint16_t line[INPUTS];
+      for (size_t i = 0; i < INPUTS; i++) pixels[i] = (uint8_t)(random_u32() % size);
+      benchmark("palette_t::expand_rgb565(1024 pixels)", size, INPUTS, [&](uint64_t){ linear.expand_rgb565(pixels, line, INPUTS); keep(line[0]); });
+    }
+
+    palette_size_t indexes[4 * INPUTS];
+    benchmark("top_k(k=4, 1024 queries)", size, INPUTS, [&](uint64_t){ keep(top_k(queries.data(), INPUTS, linear, 4, indexes)); });
+
+    // cached RGB565 colors (get_similar_color565(rgb24_t*) converts each entry per query)
+    benchmark("palette_t::nearest_index_rgb565", size, 1, [&](uint64_t i){ keep(linear.nearest_index_rgb565(rgb888_to_rgb565(INPUT(queries, i)))); });
+    benchmark("palette_t::nearest_luminance", size, 1, [&](uint64_t i){ keep(linear.nearest_luminance(INPUT(queries, i).green)); });
+  }
+}
+
+// Perceptual conversions and distances
+static void bench_lab(){
+  std::vector<rgb24_t> colors(INPUTS);
+  std::vector<lab_t> labs(INPUTS);
+  for (size_t i = 0; i < INPUTS; i++){
+    colors[i] = random_color();
+    labs[i] = rgb888_to_lab(colors[i]);
+  }
+
+  benchmark("rgb888_to_lab", 1, 1, [&](uint64_t i){ keep(rgb888_to_lab(INPUT(colors, i))); });
+  benchmark("rgb888_to_oklab", 1, 1, [&](uint64_t i){ keep(rgb888_to_oklab(INPUT(colors, i))); });
+  benchmark("lab_to_rgb888", 1, 1, [&](uint64_t i){ keep(lab_to_rgb888(INPUT(labs, i))); });
+  benchmark("delta_e76_sq", 1, 1, [&](uint64_t i){ keep(delta_e76_sq(INPUT(labs, i), INPUT(labs, i + 1))); });
+  benchmark("delta_e2000", 1, 1, [&](uint64_t i){ keep(delta_e2000(INPUT(labs, i), INPUT(labs, i + 1))); });
+}
+
+// HSV and HSL conversions, hue rotation and rainbows
+static void bench_hsv(){
+  size_t largest = BATCH_SIZES[sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]) - 1];
+  std::vector<rgb24_t> colors(largest);
+  std::vector<hsv_t> hsvs(largest);
+  std::vector<hsl_t> hsls(largest);
+  for (size_t i = 0; i < largest; i++){
+    colors[i] = random_color();
+    hsvs[i] = rgb888_to_hsv(colors[i]);
+    hsls[i] = rgb888_to_hsl(colors[i]);
+  }
+  std::vector<rgb24_t> dst(largest);
+  std::vector<uint16_t> words(largest);
+  std::vector<uint8_t> leds(largest * 3);
+
+  benchmark("rgb888_to_hsv", 1, 1, [&](uint64_t i){ keep(rgb888_to_hsv(INPUT(colors, i))); });
+  benchmark("hsv_to_rgb888", 1, 1, [&](uint64_t i){ keep(hsv_to_rgb888(INPUT(hsvs, i))); });
+  benchmark("rgb888_to_hsl", 1, 1, [&](uint64_t i){ keep(rgb888_to_hsl(INPUT(colors, i))); });
+  benchmark("hsl_to_rgb888", 1, 1, [&](uint64_t i){ keep(hsl_to_rgb888(INPUT(hsls, i))); });
+  benchmark("hsv8_to_rgb888", 1, 1, [&](uint64_t i){ keep(hsv8_to_rgb888((uint8_t)i, 200, (uint8_t)(i >> 3))); });
+  for (size_t n : BATCH_SIZES){
+    benchmark("convert_rgb888_to_hsv", n, n, [&](uint64_t){ convert_rgb888_to_hsv(colors.data(), hsvs.data(), n); keep(hsvs[0]); });
+    benchmark("convert_hsv_to_rgb888", n, n, [&](uint64_t){ convert_hsv_to_rgb888(hsvs.data(), dst.data(), n); keep(dst[0]); });
+    benchmark("convert_hsv_to_rgb565", n, n, [&](uint64_t){ convert_hsv_to_rgb565(hsvs.data(), words.data(), n); keep(words[0]); });
+    benchmark("convert_hsl_to_rgb888", n, n, [&](uint64_t){ convert_hsl_to_rgb888(hsls.data(), dst.data(), n); keep(dst[0]); });
+    benchmark("rotate_hue", n, n, [&](uint64_t i){ rotate_hue(colors.data(), dst.data(), n, (int16_t)i); keep(dst[0]); });
+    benchmark("fill_rainbow_grb", n, n, [&](uint64_t i){ fill_rainbow_grb(leds.data(), n, (uint16_t)i, 300); keep(leds[0]); });
+  }
+}
+
+// Frame dithering and palette generation
+static void bench_frames(){
+  const size_t width = 320;
+  const size_t height = 240;
+  std::vector<rgb24_t> frame(width * height);
+  for (size_t y = 0; y < height; y++){
+    for (size_t x = 0; x < width; x++) frame[y * width + x] = rgb24_t((uint8_t)(x * 255 / width), (uint8_t)(y * 255 / height), (uint8_t)(random_u32() & 0x3F));
+  }
+  std::vector<uint16_t> out565(width * height);
+  std::vector<uint8_t> indexes(width * height);
+  palette_t palette(COLORS, COLORS_COUNT, PALETTE_INDEX_GRID);
+
+  benchmark("dither_rgb888_to_rgb565(FS)", width * height, width * height, [&](uint64_t){ keep(dither_rgb888_to_rgb565(frame.data(), out565.data(), width, height, DITHER_FLOYD_STEINBERG)); });
+  benchmark("dither_rgb888_to_rgb565(BAYER8)", width * height, width * height, [&](uint64_t){ keep(dither_rgb888_to_rgb565(frame.data(), out565.data(), width, height, DITHER_BAYER8)); });
+  benchmark("dither_rgb888_to_palette(FS)", width * height, width * height, [&](uint64_t){ keep(dither_rgb888_to_palette(frame.data(), indexes.data(), width, height, palette, DITHER_FLOYD_STEINBERG)); });
+
+  quantizer_t quantizer;
+  rgb24_t colors[16];
+  benchmark("quantizer_t::add", width * height, width * height, [&](uint64_t){ quantizer.add(frame.data(), frame.size()); });
+  benchmark("quantizer_t::build(16)", quantizer.color_count(), 1, [&](uint64_t){ keep(quantizer.build(colors, 16)); });
+}
+
+// Frame diffing and RLE565 coding of a 320x240 UI frame (flat panels, a text line and a progress bar change between frames)
+static void bench_delta(){
+  const size_t width = 320;
+  const size_t height = 240;
+  std::vector<uint16_t> previous(width * height);
+  for (size_t y = 0; y < height; y++){
+    for (size_t x = 0; x < width; x++) previous[y * width + x] = y < 24 ? 0x001F : (x < 80 ? 0x39E7 : 0xFFFF);
+  }
+  std::vector<uint16_t> current = previous;
+  for (size_t y = 100; y < 116; y++){
+    for (size_t x = 120; x < 280; x++) current[y * width + x] = (random_u32() & 3) ? 0xFFFF : 0x0000; // text
+  }
+  for (size_t y = 200; y < 210; y++){
+    for (size_t x = 100; x < 180; x++) current[y * width + x] = 0x07E0; // progress bar
+  }
+  std::vector<uint8_t> encoded(rle565_bound(width) * height);
+  std::vector<uint16_t> decoded(width * height);
+  dirty_span_t spans[16];
+  dirty_rect_t rects[8];
+  size_t bytes = 0;
+  for (size_t y = 0; y < height; y++) bytes += rle565_encode(&current[y * width], &previous[y * width], width, &encoded[bytes], encoded.size() - bytes);
+
+  benchmark("diff565_spans", width * height, width * height, [&](uint64_t){
+    size_t count = 0;
+    for (size_t y = 0; y < height; y++) count += diff565_spans(&previous[y * width], &current[y * width], width, spans, 16, 8);
+    keep(count);
+  });
+  benchmark("diff565_rects", width * height, width * height, [&](uint64_t){ keep(diff565_rects(previous.data(), current.data(), width, height, 0, rects, 8)); });
+  benchmark("rle565_encode(delta)", width * height, width * height, [&](uint64_t){
+    size_t length = 0;
+    for (size_t y = 0; y < height; y++) length += rle565_encode(&current[y * width], &previous[y * width], width, &encoded[length], encoded.size() - length);
+    keep(length);
+  });
+  benchmark("rle565_decode(delta)", width * height, width * height, [&](uint64_t){
+    size_t position = 0;
+    for (size_t y = 0; y < height; y++) position += rle565_decode(&encoded[position], bytes - position, &previous[y * width], &decoded[y * width], width);
+    keep(position);
+  });
+  rle565_encoder_t encoder(width);
+  benchmark("rle565_encoder_t::encode", width * height, width * height, [&](uint64_t){
+    size_t length = 0;
+    encoder.reset();
+    for (size_t y = 0; y < height; y++) length += encoder.encode(&current[y * width], &encoded[length], encoded.size() - length);
+    keep(length);
+  });
+}
+
+// Parallel image conversion from 1 thread to one per hardware thread (batch of 8 images of 1024x768)
+static void bench_parallel(){
+  const size_t width = 1024;
+  const size_t height = 768;
+  const size_t images = 8;
+  std::vector<rgb24_t> frame(width * height);
+  for (size_t y = 0; y < height; y++){
+    for (size_t x = 0; x < width; x++) frame[y * width + x] = rgb24_t((uint8_t)(x * 255 / width), (uint8_t)(y * 255 / height), (uint8_t)(random_u32() & 0x3F));
+  }
+  std::vector<uint16_t> out(width * height * images);
+  std::vector<image_job_t> jobs;
+  for (size_t i = 0; i < images; i++) jobs.push_back(image_job_t{frame.data(), 0, out.data() + i * width * height, 0, width, height});
+  palette_t palette(COLORS, COLORS_COUNT, PALETTE_INDEX_GRID);
+
+  // 1, 2, 4, ... threads and one per hardware thread
+  unsigned hardware = std::thread::hardware_concurrency();
+  if (hardware == 0) hardware = 1;
+  for (unsigned threads = 1; threads <= hardware; threads = (threads * 2 > hardware && threads < hardware) ? hardware : threads * 2){
+    image_converter_t rgb565(threads);
+    rgb565.set_gamma(2.2f);
+    rgb565.set_dither(DITHER_BAYER8);
+    image_converter_t fs(threads);
+    fs.set_palette(&palette);
+    fs.set_dither(DITHER_FLOYD_STEINBERG);
+    char name[64];
+    snprintf(name, sizeof(name), "image_converter_t(gamma,BAYER8,565) x%u", threads);
+    benchmark(name, width * height * images, width * height * images, [&](uint64_t){ keep(rgb565.convert(jobs.data(), jobs.size())); });
+    snprintf(name, sizeof(name), "image_converter_t(FS,palette) x%u", threads);
+    benchmark(name, width * height * images, width * height * images, [&](uint64_t){ keep(fs.convert(jobs.data(), jobs.size())); });
+  }
+}
+
+int main(int argc, char** argv){
+  if (argc > 1) name_filter = argv[1];
+  if (argc > 2) min_seconds = atof(argv[2]) / 1000.0;
+
+  printf("ColorsUtils benchmarks, conversion backend: %s\n", get_conversion_backend());
+  printf("%-44s %8s %12s %12s %10s\n", "benchmark", "size", "ns/op", "ns/item", "allocs/op");
+  bench_constructors();
+  bench_conversions();
+  bench_strings();
+  bench_bulk();
+  bench_formats();
+  bench_correction();
+  bench_blend();
+  bench_gradients();
+  bench_similarity();
+  bench_named_colors();
+  bench_lists();
+  bench_palettes();
+  bench_lab();
+  bench_hsv();
+  bench_frames();
+  bench_delta();
+  bench_parallel();
+
+  // instrumented builds (-DCOLORSUTILS_STATS=ON) add the counters of the whole run
+  if (colors_stats_enabled()) colors_stats_dump([](const char* line, void*){ fprintf(stderr, "%s\n", line); });
+  return 0;
+}
@@ -0,0 +1,541 @@
+// colors_convert.cpp
+
+// Creator: JDFraire-P
+
+// Description: Host command line converter of PPM/PAM/raw RGB888 images to RGB565 or palette indexes (binary file or C header with PROGMEM arrays)
+
+/*  Streaming conversion
+1. The input file is memory-mapped read-only and the RGB888 pixels are converted in place (PPM, PAM with depth 3 and raw files are used
+   without copying, PAM RGB_ALPHA rows are copied without their alpha).
+2. The image is converted in chunks of rows (a multiple of 8 rows, so Bayer patterns line up), each chunk is written out as soon as it is done
+   and its input pages are dropped, so files larger than the memory are converted with a few MiB of buffers.
+3. RGB565, nearest palette color and ordered dithering chunks run on image_converter_t (--threads workers). Error diffusion carries errors from
+   row to row, so Floyd-Steinberg and Atkinson run row by row on dither_t in one thread (the same output as image_converter_t).
+4. The palette is read from a file of colors (parse_colors), taken from the named colors list or built by the quantizer in a first pass over the file.
+5. The time of each stage (map, palette, convert, write) is printed on stderr.
+*/
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsUtils.h>
+#include <ColorsPalette.h>
+#include <ColorsDither.h>
+#include <ColorsQuantize.h>
+#include <ColorsParallel.h>
+#include <ColorsCorrection.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* OPTIONS */
+
+static const char USAGE[] =
+  "usage: colors_convert [options] input output\n"
+  "  input              PPM (P6), PAM (P7, RGB or RGB_ALPHA) or raw RGB888 file (--raw), maximum value 255\n"
+  "  output             binary file (RGB565 words or packed palette indexes), C header with --header, - for stdout\n"
+  "  --raw WxH          input is raw RGB888 of W x H pixels\n"
+  "  --rgb565           RGB565 words, native byte order (default)\n"
+  "  --rgb565be         RGB565 words, most significant byte first (SPI displays)\n"
+  "  --palette FILE     palette indexes, colors read from FILE (#rrggbb, 0xrrggbb, rgb(r, g, b) or names, one per line or comma separated)\n"
+  "  --palette named    palette indexes, colors of the named colors list\n"
+  "  --colors N         palette indexes, palette of N colors built from the image (median cut and k-means)\n"
+  "  --bits B           bits per palette index: 1, 2, 4 or 8 (default: smallest that fits the palette)\n"
+  "  --dither METHOD    none (default), fs, atkinson, bayer4 or bayer8\n"
+  "  --gamma G          power law applied before quantization (out = 255 * (in / 255) ^ G)\n"
+  "  --threads N        conversion threads (default: one per hardware thread)\n"
+  "  --header           write a C header with PROGMEM arrays instead of binary data\n"
+  "  --name NAME        array name in the C header (default: from the output file name)\n";
+
+// Output of the conversion
+enum output_mode_t : uint8_t{
+  OUTPUT_RGB565,
+  OUTPUT_INDEX
+};
+
+// Palette sources
+enum palette_source_t : uint8_t{
+  PALETTE_NONE,
+  PALETTE_FILE,
+  PALETTE_NAMED,
+  PALETTE_QUANTIZED
+};
+
+// Command line options
+struct options_t{
+  const char* input = nullptr;
+  const char* output = nullptr;
+  size_t raw_width = 0;
+  size_t raw_height = 0;
+  output_mode_t mode = OUTPUT_RGB565;
+  bool big_endian = false;
+  palette_source_t palette = PALETTE_NONE;
+  const char* palette_file = nullptr;
+  unsigned colors = 0;
+  uint8_t index_bits = 0;
+  dither_method_t dither = DITHER_NONE;
+  float gamma = 1.0f;
+  unsigned threads = 0;
+  bool header = false;
+  std::string name;
+};
+
+// Print an error, returns the exit code
+static int fail(const char* message, const char* detail = nullptr){
+  if (detail != nullptr) fprintf(stderr, "colors_convert: %s: %s\n", message, detail);
+  else fprintf(stderr, "colors_convert: %s\n", message);
+  return 1;
+}
+
+// Parse a dithering method name, false if unknown
+static bool parse_dither(const char* text, dither_method_t& method){
+  static const struct{ const char* name; dither_method_t method; } METHODS[] = {
+    {"none", DITHER_NONE}, {"fs", DITHER_FLOYD_STEINBERG}, {"atkinson", DITHER_ATKINSON}, {"bayer4", DITHER_BAYER4}, {"bayer8", DITHER_BAYER8}
+  };
+  for (const auto& entry : METHODS){
+    if (strcmp(text, entry.name) == 0){
+      method = entry.method;
+      return true;
+    }
+  }
+  return false;
+}
+
+// C identifier from the stem of a file name
+static std::string identifier_from_path(const char* path){
+  const char* base = strrchr(path, '/');
+  base = base != nullptr ? base + 1 : path;
+  std::string name;
+  for (const char* c = base; *c != '\0' && *c != '.'; c++) name += isalnum((unsigned char)*c) ? *c : '_';
+  if (name.empty() || isdigit((unsigned char)name[0])) name = "image_" + name;
+  return name;
+}
+
+// Parse the command line, false (after printing the reason) if invalid
+static bool parse_options(int argc, char** argv, options_t& options){
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; i++){
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    bool takes_value = strcmp(arg, "--raw") == 0 || strcmp(arg, "--palette") == 0 || strcmp(arg, "--colors") == 0 || strcmp(arg, "--bits") == 0
+      || strcmp(arg, "--dither") == 0 || strcmp(arg, "--gamma") == 0 || strcmp(arg, "--threads") == 0 || strcmp(arg, "--name") == 0;
+    if (takes_value){
+      if (value == nullptr){
+        fail("missing value of", arg);
+        return false;
+      }
+      i++;
+    }
+    if (strcmp(arg, "--raw") == 0){
+      if (sscanf(value, "%zux%zu", &options.raw_width, &options.raw_height) != 2 || options.raw_width == 0 || options.raw_height == 0){
+        fail("invalid size", value);
+        return false;
+      }
+    }
+    else if (strcmp(arg, "--rgb565") == 0){ options.mode = OUTPUT_RGB565; options.big_endian = false; }
+    else if (strcmp(arg, "--rgb565be") == 0){ options.mode = OUTPUT_RGB565; options.big_endian = true; }
+    else if (strcmp(arg, "--palette") == 0){
+      options.mode = OUTPUT_INDEX;
+      options.palette = strcmp(value, "named") == 0 ? PALETTE_NAMED : PALETTE_FILE;
+      options.palette_file = value;
+    }
+    else if (strcmp(arg, "--colors") == 0){
+      options.mode = OUTPUT_INDEX;
+      options.palette = PALETTE_QUANTIZED;
+      options.colors = (unsigned)strtoul(value, nullptr, 10);
+      if (options.colors < 1 || options.colors > 256){
+        fail("--colors must be 1 to 256, got", value);
+        return false;
+      }
+    }
+    else if (strcmp(arg, "--bits") == 0){
+      options.index_bits = (uint8_t)strtoul(value, nullptr, 10);
+      if (options.index_bits != 1 && options.index_bits != 2 && options.index_bits != 4 && options.index_bits != 8){
+        fail("--bits must be 1, 2, 4 or 8, got", value);
+        return false;
+      }
+    }
+    else if (strcmp(arg, "--dither") == 0){
+      if (!parse_dither(value, options.dither)){
+        fail("unknown dithering method", value);
+        return false;
+      }
+    }
+    else if (strcmp(arg, "--gamma") == 0){
+      options.gamma = strtof(value, nullptr);
+      if (!(options.gamma > 0.0f)){
+        fail("invalid gamma", value);
+        return false;
+      }
+    }
+    else if (strcmp(arg, "--threads") == 0) options.threads = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--header") == 0) options.header = true;
+    else if (strcmp(arg, "--name") == 0) options.name = value;
+    else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0){
+      fputs(USAGE, stdout);
+      exit(0);
+    }
+    else if (arg[0] == '-' && arg[1] != '\0'){
+      fail("unknown option", arg);
+      return false;
+    }
+    else files.push_back(arg);
+  }
+  if (files.size() != 2){
+    fputs(USAGE, stderr);
+    return false;
+  }
+  options.input = files[0];
+  options.output = files[1];
+  if (options.name.empty()) options.name = identifier_from_path(strcmp(options.output, "-") == 0 ? options.input : options.output);
+  return true;
+}
+
+/* INPUT */
+
+// Memory-mapped input image
+struct image_t{
+  void* map = MAP_FAILED;
+  size_t map_size = 0;
+  const uint8_t* pixels = nullptr; // first pixel in the mapping
+  size_t width = 0;
+  size_t height = 0;
+  size_t depth = 3; // bytes per pixel (3: RGB, 4: RGB and alpha)
+
+  ~image_t(){ if (map != MAP_FAILED) munmap(map, map_size); }
+};
+
+// Next header token of a PPM file (comments skipped), false at the end of the data
+static bool ppm_token(const uint8_t* data, size_t size, size_t& position, char* token, size_t token_size){
+  while (position < size){
+    if (data[position] == '#'){
+      while (position < size && data[position] != '\n') position++;
+    }
+    else if (isspace(data[position])) position++;
+    else break;
+  }
+  size_t length = 0;
+  while (position < size && !isspace(data[position]) && length + 1 < token_size) token[length++] = (char)data[position++];
+  token[length] = '\0';
+  return length > 0;
+}
+
+// Read the PPM (P6) header, false if invalid
+static bool read_ppm_header(const uint8_t* data, size_t size, image_t& image, size_t& offset){
+  char token[32];
+  size_t position = 2;
+  unsigned long values[3];
+  for (unsigned long& value : values){
+    if (!ppm_token(data, size, position, token, sizeof(token))) return false;
+    value = strtoul(token, nullptr, 10);
+  }
+  if (values[2] != 255 || position >= size) return false; // 16-bit samples are not supported
+  image.width = values[0];
+  image.height = values[1];
+  image.depth = 3;
+  offset = position + 1; // a single whitespace byte ends the header
+  return true;
+}
+
+// Read the PAM (P7) header, false if invalid
+static bool read_pam_header(const uint8_t* data, size_t size, image_t& image, size_t& offset){
+  size_t position = 2;
+  unsigned long maximum = 0;
+  image.depth = 0;
+  while (position < size){
+    size_t end = position;
+    while (end < size && data[end] != '\n') end++;
+    std::string line((const char*)data + position, end - position);
+    position = end + 1;
+    char key[16];
+    unsigned long value = 0;
+    if (line == "ENDHDR"){
+      offset = position;
+      return image.width > 0 && image.height > 0 && (image.depth == 3 || image.depth == 4) && maximum == 255 && offset <= size;
+    }
+    if (sscanf(line.c_str(), "%15s %lu", key, &value) != 2) continue; // TUPLTYPE and comments
+    if (strcmp(key, "WIDTH") == 0) image.width = value;
+    else if (strcmp(key, "HEIGHT") == 0) image.height = value;
+    else if (strcmp(key, "DEPTH") == 0) image.depth = value;
+    else if (strcmp(key, "MAXVAL") == 0) maximum = value;
+  }
+  return false;
+}
+
+// Map the input file and read its header, returns 0 or the exit code
+static int open_image(const options_t& options, image_t& image){
+  int file = open(options.input, O_RDONLY);
+  if (file < 0) return fail("cannot open", options.input);
+  struct stat info;
+  if (fstat(file, &info) != 0 || info.st_size == 0){
+    close(file);
+    return fail("empty or unreadable input", options.input);
+  }
+  image.map_size = (size_t)info.st_size;
+  image.map = mmap(nullptr, image.map_size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (image.map == MAP_FAILED) return fail("cannot map", options.input);
+  madvise(image.map, image.map_size, MADV_SEQUENTIAL);
+
+  const uint8_t* data = (const uint8_t*)image.map;
+  size_t offset = 0;
+  if (options.raw_width != 0){
+    image.width = options.raw_width;
+    image.height = options.raw_height;
+    image.depth = 3;
+  }
+  else if (image.map_size > 2 && data[0] == 'P' && data[1] == '6'){
+    if (!read_ppm_header(data, image.map_size, image, offset)) return fail("invalid or unsupported PPM header", options.input);
+  }
+  else if (image.map_size > 2 && data[0] == 'P' && data[1] == '7'){
+    if (!read_pam_header(data, image.map_size, image, offset)) return fail("invalid or unsupported PAM header", options.input);
+  }
+  else return fail("not a PPM or PAM file (use --raw WxH for raw RGB888)", options.input);
+
+  if (image.width == 0 || image.height == 0 || offset > image.map_size || (image.map_size - offset) / image.depth / image.width < image.height){
+    return fail("image size does not match the file", options.input);
+  }
+  image.pixels = data + offset;
+  return 0;
+}
+
+// Drop the mapped pages of rows [first, last) once they are converted
+static void release_rows(const image_t& image, size_t first, size_t last){
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  uintptr_t begin = (uintptr_t)(image.pixels + first * image.width * image.depth);
+  uintptr_t end = (uintptr_t)(image.pixels + last * image.width * image.depth);
+  begin = (begin + page - 1) & ~(uintptr_t)(page - 1);
+  end &= ~(uintptr_t)(page - 1);
+  if (end > begin) madvise((void*)begin, end - begin, MADV_DONTNEED);
+}
+
+// RGB888 pixels of rows [first, last) (the mapping itself, or the rows copied without alpha into scratch)
+static const rgb24_t* image_rows(const image_t& image, size_t first, size_t last, std::vector<rgb24_t>& scratch){
+  const uint8_t* src = image.pixels + first * image.width * image.depth;
+  if (image.depth == 3) return (const rgb24_t*)src;
+  size_t n = (last - first) * image.width;
+  scratch.resize(n);
+  for (size_t i = 0; i < n; i++, src += 4) scratch[i] = rgb24_t(src[0], src[1], src[2]);
+  return scratch.data();
+}
+
+/* OUTPUT */
+
+// Binary file or C header writer
+class output_t{
+public:
+  output_t(const options_t& options) : options(options) {}
+  ~output_t(){ if (file != nullptr && file != stdout) fclose(file); }
+
+  // Open the output and write the header of the C arrays, false if the file cannot be created
+  bool open(const image_t& image, const rgb24_t* palette, size_t palette_size, uint8_t index_bits){
+    file = strcmp(options.output, "-") == 0 ? stdout : fopen(options.output, "wb");
+    if (file == nullptr) return false;
+    if (!options.header) return true;
+    const char* name = options.name.c_str();
+    std::string macro = options.name;
+    for (char& c : macro) c = (char)toupper((unsigned char)c);
+    fprintf(file, "// %s: %zu x %zu pixels, ", name, image.width, image.height);
+    if (options.mode == OUTPUT_RGB565) fprintf(file, "RGB565%s\n", options.big_endian ? " (bytes swapped)" : "");
+    else fprintf(file, "%u-bit palette indexes (first pixel in the high bits, rows rounded to whole bytes)\n", index_bits);
+    fprintf(file, "// Generated by colors_convert from %s\n\n#pragma once\n\n#include <Arduino.h>\n\n", options.input);
+    fprintf(file, "#define %s_WIDTH %zu\n#define %s_HEIGHT %zu\n", macro.c_str(), image.width, macro.c_str(), image.height);
+    if (options.mode == OUTPUT_INDEX){
+      fprintf(file, "#define %s_INDEX_BITS %u\n#define %s_PALETTE_SIZE %zu\n\n", macro.c_str(), index_bits, macro.c_str(), palette_size);
+      fprintf(file, "// Palette colors (0xRRGGBB)\nconst uint32_t %s_palette[%zu] PROGMEM = {", name, palette_size);
+      for (size_t i = 0; i < palette_size; i++) fprintf(file, "%s0x%06lX,", i % 8 == 0 ? "\n  " : " ", (unsigned long)palette[i].value());
+      fputs("\n};\n", file);
+    }
+    if (options.mode == OUTPUT_RGB565) fprintf(file, "\nconst uint16_t %s[%zu] PROGMEM = {", name, image.width * image.height);
+    else fprintf(file, "\nconst uint8_t %s[%zu] PROGMEM = {", name, (image.width * index_bits + 7) / 8 * image.height);
+    return true;
+  }
+
+  // Write a chunk of output bytes (RGB565 words in memory order or packed indexes), false on write errors
+  bool write(const uint8_t* data, size_t size){
+    if (!options.header) return fwrite(data, 1, size, file) == size;
+    // Hex items written by hand (snprintf per item is the bottleneck of large headers)
+    static const char DIGITS[] = "0123456789ABCDEF";
+    bool words = options.mode == OUTPUT_RGB565;
+    uint8_t digits = words ? 4 : 2;
+    size_t per_line = words ? 12 : 16;
+    text.resize((size / (words ? 2 : 1)) * 10);
+    char* out = &text[0];
+    for (size_t i = 0; i + (words ? 1 : 0) < size; i += words ? 2 : 1, items++){
+      uint16_t value = data[i];
+      if (words) memcpy(&value, data + i, sizeof(value));
+      if (items % per_line == 0){
+        *out++ = '\n';
+        *out++ = ' ';
+      }
+      *out++ = ' ';
+      *out++ = '0';
+      *out++ = 'x';
+      for (int8_t shift = (int8_t)(4 * (digits - 1)); shift >= 0; shift -= 4) *out++ = DIGITS[(value >> shift) & 0xF];
+      *out++ = ',';
+    }
+    size_t length = (size_t)(out - text.data());
+    return fwrite(text.data(), 1, length, file) == length;
+  }
+
+  // Close the C array and flush, false on write errors
+  bool finish(){
+    if (options.header) fputs("\n};\n", file);
+    return fflush(file) == 0 && !ferror(file);
+  }
+
+private:
+  const options_t& options;
+  FILE* file = nullptr;
+  size_t items = 0;
+  std::string text; // C header text of a chunk
+};
+
+/* CONVERSION */
+
+// Stage timer (milliseconds)
+struct stage_timer_t{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  double lap(){
+    auto now = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(now - start).count();
+    start = now;
+    return ms;
+  }
+};
+
+// Rows of a chunk (a multiple of 8 rows of about 4 MiB of input)
+static size_t chunk_rows(const image_t& image){
+  size_t rows = ((size_t)4 << 20) / (image.width * image.depth);
+  rows = rows < 8 ? 8 : rows & ~(size_t)7;
+  return rows;
+}
+
+// Pack 8-bit indexes to bits per index (first pixel in the high bits, the row rounded to whole bytes)
+static void pack_indexes(const uint8_t* indexes, uint8_t* dst, size_t n, uint8_t bits){
+  uint8_t per_byte = (uint8_t)(8 / bits);
+  for (size_t i = 0; i < n; i += per_byte){
+    uint8_t byte = 0;
+    for (uint8_t j = 0; j < per_byte; j++) byte = (uint8_t)((byte << bits) | (i + j < n ? indexes[i + j] : 0));
+    *dst++ = byte;
+  }
+}
+
+int main(int argc, char** argv){
+  options_t options;
+  if (!parse_options(argc, argv, options)) return 2;
+  stage_timer_t timer;
+  double times[4] = {0, 0, 0, 0}; // map, palette, convert, write
+
+  image_t image;
+  int status = open_image(options, image);
+  if (status != 0) return status;
+  times[0] = timer.lap();
+
+  // Palette
+  std::vector<rgb24_t> palette_colors;
+  std::vector<rgb24_t> scratch;
+  size_t rows_per_chunk = chunk_rows(image);
+  if (options.palette == PALETTE_NAMED) palette_colors.assign(COLORS, COLORS + COLORS_COUNT);
+  else if (options.palette == PALETTE_FILE){
+    FILE* file = fopen(options.palette_file, "rb");
+    if (file == nullptr) return fail("cannot open palette", options.palette_file);
+    std::string text;
+    char buffer[4096];
+    for (size_t length; (length = fread(buffer, 1, sizeof(buffer), file)) > 0;) text.append(buffer, length);
+    fclose(file);
+    palette_colors.resize(257);
+    size_t invalid = 0;
+    palette_colors.resize(parse_colors(text.c_str(), text.size(), palette_colors.data(), palette_colors.size(), &invalid));
+    if (invalid != 0) fprintf(stderr, "colors_convert: %zu invalid entries in %s stored as black\n", invalid, options.palette_file);
+    if (palette_colors.empty() || palette_colors.size() > 256) return fail("palettes need 1 to 256 colors", options.palette_file);
+  }
+  else if (options.palette == PALETTE_QUANTIZED){
+    quantizer_t quantizer(5, 6, 5);
+    if (!quantizer.ready()) return fail("cannot allocate the quantizer histogram");
+    for (size_t y = 0; y < image.height; y += rows_per_chunk){
+      size_t last = y + rows_per_chunk < image.height ? y + rows_per_chunk : image.height;
+      quantizer.add(image_rows(image, y, last, scratch), (last - y) * image.width);
+    }
+    palette_colors.resize(options.colors);
+    palette_colors.resize(quantizer.build(palette_colors.data(), (palette_size_t)options.colors, 4));
+    if (palette_colors.empty()) return fail("cannot build the palette");
+  }
+  uint8_t index_bits = options.index_bits;
+  if (options.mode == OUTPUT_INDEX){
+    if (index_bits == 0) index_bits = palette_colors.size() <= 2 ? 1 : palette_colors.size() <= 4 ? 2 : palette_colors.size() <= 16 ? 4 : 8;
+    if (palette_colors.size() > ((size_t)1 << index_bits)) return fail("the palette does not fit in --bits");
+  }
+  palette_t palette(palette_colors.data(), (palette_size_t)palette_colors.size(), PALETTE_INDEX_GRID);
+  times[1] = timer.lap();
+
+  // Gamma table (the same table on both paths)
+  color_correction_t correction;
+  if (options.gamma != 1.0f) correction.apply_gamma(options.gamma);
+
+  output_t output(options);
+  if (!output.open(image, palette_colors.data(), palette_colors.size(), index_bits)) return fail("cannot create", options.output);
+  times[3] += timer.lap();
+
+  size_t row_bytes = options.mode == OUTPUT_RGB565 ? image.width * sizeof(uint16_t) : (image.width * index_bits + 7) / 8;
+  std::vector<uint8_t> chunk(rows_per_chunk * row_bytes);
+  bool diffusion = options.dither == DITHER_FLOYD_STEINBERG || options.dither == DITHER_ATKINSON;
+  image_converter_t converter(options.threads);
+  dither_t ditherer(diffusion ? options.dither : DITHER_NONE, image.width);
+  if (!ditherer.ready()) return fail("cannot allocate the dithering line buffers");
+  std::vector<rgb24_t> corrected(diffusion ? image.width : 0);
+  std::vector<uint8_t> indexes(diffusion && options.mode == OUTPUT_INDEX ? image.width : 0);
+  if (!diffusion){
+    if (options.gamma != 1.0f) converter.set_gamma_lut(correction.table(0));
+    if (options.mode == OUTPUT_RGB565) converter.set_rgb565(options.big_endian);
+    else converter.set_palette(&palette, index_bits);
+    converter.set_dither(options.dither);
+  }
+  else if (options.threads > 1) fprintf(stderr, "colors_convert: error diffusion runs row by row in one thread\n");
+
+  for (size_t y = 0; y < image.height; y += rows_per_chunk){
+    size_t last = y + rows_per_chunk < image.height ? y + rows_per_chunk : image.height;
+    const rgb24_t* rows = image_rows(image, y, last, scratch);
+    if (!diffusion){
+      image_job_t job = {rows, 0, chunk.data(), row_bytes, image.width, last - y};
+      if (!converter.convert(job)) return fail("conversion failed (out of memory)");
+    }
+    else{
+      for (size_t row = 0; row < last - y; row++){
+        correction.correct(rows + row * image.width, corrected.data(), image.width);
+        uint8_t* dst = chunk.data() + row * row_bytes;
+        if (options.mode == OUTPUT_RGB565) ditherer.row_to_rgb565(corrected.data(), (uint16_t*)dst, options.big_endian);
+        else if (index_bits == 8) ditherer.row_to_palette(corrected.data(), palette, dst);
+        else{
+          ditherer.row_to_palette(corrected.data(), palette, indexes.data());
+          pack_indexes(indexes.data(), dst, image.width, index_bits);
+        }
+      }
+    }
+    release_rows(image, y, last);
+    times[2] += timer.lap();
+    if (!output.write(chunk.data(), (last - y) * row_bytes)) return fail("cannot write", options.output);
+    times[3] += timer.lap();
+  }
+  if (!output.finish()) return fail("cannot write", options.output);
+  times[3] += timer.lap();
+
+  // Stage timing
+  double total = times[0] + times[1] + times[2] + times[3];
+  double megabytes = (double)(image.width * image.height * image.depth) / (1 << 20);
+  fprintf(stderr, "%s: %zu x %zu pixels, threads: %u\n", options.input, image.width, image.height, diffusion ? 1 : converter.threads());
+  fprintf(stderr, "  map      %10.3f ms\n", times[0]);
+  fprintf(stderr, "  palette  %10.3f ms (%zu colors)\n", times[1], palette_colors.size());
+  fprintf(stderr, "  convert  %10.3f ms (%.1f MiB/s)\n", times[2], times[2] > 0 ? megabytes / (times[2] / 1000.0) : 0.0);
+  fprintf(stderr, "  write    %10.3f ms\n", times[3]);
+  fprintf(stderr, "  total    %10.3f ms\n", total);
+  return 0;
+}
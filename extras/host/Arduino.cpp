@@ -0,0 +1,274 @@
+// Arduino.cpp
+
+// Creator: JDFraire-P
+
+// Description: Minimal Arduino core stand-in for host builds (String, Serial and timing)
+
+// Libraries
+#include <Arduino.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <chrono>
+#include <thread>
+
+/* STRING */
+
+String::String(const char* text) : String(){
+  if (text != nullptr) copy(text, (unsigned int)strlen(text));
+}
+
+String::String(const String& other) : String(){
+  if (other.buffer != nullptr) copy(other.buffer, other.len);
+}
+
+String::String(char c) : String(){
+  copy(&c, 1);
+}
+
+// Digits of value in base (2 to 36), as utoa/ultoa of the Arduino core
+static unsigned int format_unsigned(unsigned long value, unsigned char base, char* digits){
+  if (base < 2 || base > 36) base = 10;
+  char reversed[8 * sizeof(unsigned long)];
+  unsigned int count = 0;
+  do{
+    unsigned int digit = (unsigned int)(value % base);
+    reversed[count++] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    value /= base;
+  } while (value != 0);
+  for (unsigned int i = 0; i < count; i++) digits[i] = reversed[count - 1 - i];
+  digits[count] = '\0';
+  return count;
+}
+
+// Digits of a signed value, negative only in base 10 (as itoa/ltoa of the Arduino core)
+static unsigned int format_signed(long value, unsigned char base, char* digits){
+  if (base == 10 && value < 0){
+    digits[0] = '-';
+    return 1 + format_unsigned(0UL - (unsigned long)value, base, digits + 1);
+  }
+  return format_unsigned((unsigned long)value, base, digits);
+}
+
+String::String(unsigned char value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(int value, unsigned char base) : String(){
+  char digits[8 * sizeof(long) + 2];
+  // int is 16 bits on AVR, the digits of negative values in other bases follow the host width
+  copy(digits, format_signed(base == 10 ? (long)value : (long)(unsigned int)value, base, digits));
+}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(long value, unsigned char base) : String(){
+  char digits[8 * sizeof(long) + 2];
+  copy(digits, format_signed(value, base, digits));
+}
+String::String(unsigned long value, unsigned char base) : String(){
+  char digits[8 * sizeof(long) + 1];
+  copy(digits, format_unsigned(value, base, digits));
+}
+String::String(float value, unsigned char decimals) : String((double)value, decimals) {}
+String::String(double value, unsigned char decimals) : String(){
+  char digits[64];
+  int size = snprintf(digits, sizeof(digits), "%.*f", (int)decimals, value);
+  copy(digits, size < 0 ? 0 : (size < (int)sizeof(digits) ? (unsigned int)size : (unsigned int)sizeof(digits) - 1));
+}
+
+String::~String(){
+  free(buffer);
+}
+
+String& String::operator=(const String& other){
+  if (this == &other) return *this;
+  if (other.buffer == nullptr){
+    len = 0;
+    if (buffer != nullptr) buffer[0] = '\0';
+    return *this;
+  }
+  return copy(other.buffer, other.len);
+}
+
+String& String::operator=(String&& other){
+  if (this == &other) return *this;
+  free(buffer);
+  buffer = other.buffer;
+  capacity = other.capacity;
+  len = other.len;
+  other.buffer = nullptr;
+  other.capacity = 0;
+  other.len = 0;
+  return *this;
+}
+
+String& String::operator=(const char* text){
+  if (text == nullptr){
+    len = 0;
+    if (buffer != nullptr) buffer[0] = '\0';
+    return *this;
+  }
+  return copy(text, (unsigned int)strlen(text));
+}
+
+// Grow the buffer to hold size characters (exact size, one realloc as in the Arduino core)
+bool String::reserve(unsigned int size){
+  if (buffer != nullptr && capacity >= size) return true;
+  char* grown = (char*)realloc(buffer, (size_t)size + 1);
+  if (grown == nullptr) return false;
+  if (buffer == nullptr) grown[0] = '\0';
+  buffer = grown;
+  capacity = size;
+  return true;
+}
+
+String& String::copy(const char* text, unsigned int size){
+  if (!reserve(size)){
+    free(buffer);
+    buffer = nullptr;
+    capacity = 0;
+    len = 0;
+    return *this;
+  }
+  memmove(buffer, text, size);
+  buffer[size] = '\0';
+  len = size;
+  return *this;
+}
+
+bool String::concat(const char* text, unsigned int size){
+  if (text == nullptr) return false;
+  if (size == 0) return true;
+  // text may point into this string
+  size_t offset = buffer != nullptr && text >= buffer && text < buffer + len ? (size_t)(text - buffer) : SIZE_MAX;
+  if (!reserve(len + size)) return false;
+  memmove(buffer + len, offset != SIZE_MAX ? buffer + offset : text, size);
+  len += size;
+  buffer[len] = '\0';
+  return true;
+}
+
+bool String::equalsIgnoreCase(const String& other) const{
+  return len == other.len && strcasecmp(c_str(), other.c_str()) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const{
+  if (from >= len) return -1;
+  const char* found = strchr(buffer + from, c);
+  return found == nullptr ? -1 : (int)(found - buffer);
+}
+
+String String::substring(unsigned int from, unsigned int to) const{
+  if (from > to){
+    unsigned int swap = from;
+    from = to;
+    to = swap;
+  }
+  String result;
+  if (from >= len) return result;
+  if (to > len) to = len;
+  result.copy(buffer + from, to - from);
+  return result;
+}
+
+void String::toUpperCase(){
+  for (unsigned int i = 0; i < len; i++) buffer[i] = (char)toupper((unsigned char)buffer[i]);
+}
+
+void String::toLowerCase(){
+  for (unsigned int i = 0; i < len; i++) buffer[i] = (char)tolower((unsigned char)buffer[i]);
+}
+
+long String::toInt() const{
+  return atol(c_str());
+}
+
+float String::toFloat() const{
+  return (float)atof(c_str());
+}
+
+String operator+(const String& left, const String& right){
+  String result(left);
+  result += right;
+  return result;
+}
+
+String operator+(const String& left, const char* right){
+  String result(left);
+  result += right;
+  return result;
+}
+
+String operator+(const char* left, const String& right){
+  String result(left);
+  result += right;
+  return result;
+}
+
+String operator+(const String& left, char right){
+  String result(left);
+  result += right;
+  return result;
+}
+
+/* TIMING */
+
+// Time of the first timing call
+static std::chrono::steady_clock::time_point start_time(){
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return start;
+}
+
+unsigned long micros(){
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time()).count();
+}
+
+unsigned long millis(){
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time()).count();
+}
+
+void delay(unsigned long ms){
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us){
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+/* SERIAL */
+
+size_t Print::write(uint8_t byte){
+  (void)byte;
+  return 0;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size){
+  size_t count = 0;
+  while (count < size && write(buffer[count]) == 1) count++;
+  return count;
+}
+
+size_t Print::print(long value, int base){
+  char digits[8 * sizeof(long) + 2];
+  return write((const uint8_t*)digits, format_signed(value, (unsigned char)base, digits));
+}
+
+size_t Print::print(unsigned long value, int base){
+  char digits[8 * sizeof(long) + 1];
+  return write((const uint8_t*)digits, format_unsigned(value, (unsigned char)base, digits));
+}
+
+size_t Print::print(double value, int digits){
+  char text[64];
+  int size = snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write((const uint8_t*)text, size < 0 ? 0 : (size < (int)sizeof(text) ? (size_t)size : sizeof(text) - 1));
+}
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t byte){
+  return fputc(byte, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size){
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush(){
+  fflush(stdout);
+}
@@ -0,0 +1,117 @@
+// Arduino.h
+
+// Creator: JDFraire-P
+
+// Description: Minimal Arduino core stand-in for host builds (types, PROGMEM access, String, Serial and timing)
+
+/*  Host shim
+1. Only the parts of the Arduino core used by the library and its examples are provided, the library sources build unchanged.
+2. PROGMEM data is ordinary read-only memory on the host, the pgm_read_* and *_P functions read it directly.
+3. String keeps the Arduino layout (heap buffer grown with realloc, no small string buffer), so heap allocations counted on the host match the board.
+4. Serial writes to the standard output, micros and millis count from the first call.
+*/
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// Libraries
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <WString.h>
+
+/* CONSTANTS */
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define HEX 16
+#define DEC 10
+#define OCT 8
+#define BIN 2
+
+/* PROGRAM MEMORY */
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_float(address) (*(const float*)(address))
+#define pgm_read_ptr(address) (*(const void* const*)(address))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strcasecmp_P strcasecmp
+
+/* TIMING */
+
+// Microseconds since the first timing call
+unsigned long micros();
+// Milliseconds since the first timing call
+unsigned long millis();
+// Wait ms milliseconds
+void delay(unsigned long ms);
+// Wait us microseconds
+void delayMicroseconds(unsigned int us);
+
+/* SERIAL */
+
+// Text output of Serial (print and println of the Arduino Print class)
+class Print{
+public:
+  virtual ~Print() {}
+
+  // Write one byte
+  virtual size_t write(uint8_t byte);
+  // Write size bytes
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* text) { return text == nullptr ? 0 : write((const uint8_t*)text, strlen(text)); }
+
+  size_t print(const __FlashStringHelper* text) { return write((const char*)text); }
+  size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.length()); }
+  size_t print(const char* text) { return write(text); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+  template <typename T> size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+// Serial port written to the standard output
+class HardwareSerial : public Print{
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+  void flush();
+  int available() { return 0; }
+  int read() { return -1; }
+  operator bool() const { return true; }
+
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+/* SKETCH */
+
+void setup();
+void loop();
+
+#endif
@@ -0,0 +1,94 @@
+// WString.h
+
+// Creator: JDFraire-P
+
+// Description: Arduino String stand-in for host builds (same buffer growth as the Arduino core)
+
+/*  Host String
+1. The buffer is allocated with realloc to the exact length plus terminator, as the Arduino core does, so every growth is one heap allocation.
+2. Numbers are formatted with the same bases and decimals as the Arduino constructors (String(value, HEX), String(value, decimals)).
+3. Only the members used by the library, its examples and the host tools are provided.
+*/
+
+#ifndef WSTRING_H
+#define WSTRING_H
+
+// Libraries
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Flash string marker of F() (plain read-only memory on the host)
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+class String{
+public:
+  // Empty string (no allocation)
+  String() : buffer(nullptr), capacity(0), len(0) {}
+  String(const char* text);
+  String(const __FlashStringHelper* text) : String(reinterpret_cast<const char*>(text)) {}
+  String(const String& other);
+  String(String&& other) : buffer(other.buffer), capacity(other.capacity), len(other.len) { other.buffer = nullptr; other.capacity = 0; other.len = 0; }
+  explicit String(char c);
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimals = 2);
+  explicit String(double value, unsigned char decimals = 2);
+  ~String();
+
+  String& operator=(const String& other);
+  String& operator=(String&& other);
+  String& operator=(const char* text);
+
+  // Grow the buffer to hold size characters, false if out of memory
+  bool reserve(unsigned int size);
+  unsigned int length() const { return len; }
+  const char* c_str() const { return buffer != nullptr ? buffer : ""; }
+
+  bool concat(const String& other) { return concat(other.buffer, other.len); }
+  bool concat(const char* text) { return text != nullptr && concat(text, (unsigned int)strlen(text)); }
+  bool concat(const char* text, unsigned int size);
+  bool concat(char c) { return concat(&c, 1); }
+
+  String& operator+=(const String& other) { concat(other); return *this; }
+  String& operator+=(const char* text) { concat(text); return *this; }
+  String& operator+=(char c) { concat(c); return *this; }
+
+  bool equals(const String& other) const { return len == other.len && strcmp(c_str(), other.c_str()) == 0; }
+  bool equals(const char* text) const { return strcmp(c_str(), text != nullptr ? text : "") == 0; }
+  bool equalsIgnoreCase(const String& other) const;
+  bool operator==(const String& other) const { return equals(other); }
+  bool operator==(const char* text) const { return equals(text); }
+  bool operator!=(const String& other) const { return !equals(other); }
+  bool operator!=(const char* text) const { return !equals(text); }
+
+  char operator[](unsigned int index) const { return index < len ? buffer[index] : '\0'; }
+  char charAt(unsigned int index) const { return (*this)[index]; }
+  int indexOf(char c, unsigned int from = 0) const;
+  String substring(unsigned int from, unsigned int to) const;
+  String substring(unsigned int from) const { return substring(from, len); }
+  void toUpperCase();
+  void toLowerCase();
+
+  long toInt() const;
+  float toFloat() const;
+
+private:
+  char* buffer; // heap buffer (nullptr while empty)
+  unsigned int capacity; // characters that fit in the buffer (without terminator)
+  unsigned int len; // characters in use
+
+  // Copy size characters of text, replacing the contents
+  String& copy(const char* text, unsigned int size);
+};
+
+String operator+(const String& left, const String& right);
+String operator+(const String& left, const char* right);
+String operator+(const char* left, const String& right);
+String operator+(const String& left, char right);
+
+#endif
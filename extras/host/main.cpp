@@ -0,0 +1,15 @@
+// main.cpp
+
+// Creator: JDFraire-P
+
+// Description: Host entry point of Arduino sketches, runs setup() and then loop() once
+
+// Libraries
+#include <Arduino.h>
+
+int main(){
+  setup();
+  loop();
+  Serial.flush();
+  return 0;
+}
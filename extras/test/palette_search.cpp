@@ -0,0 +1,168 @@
+// palette_search.cpp
+
+// Creator: JDFraire-P
+
+// Description: Host test of the palette search structures (grid, k-d tree, inverse colormap, top_k) against brute force searches
+
+/*  Method
+1. Palettes of 1 to 1000 random colors, plus clustered palettes with repeated colors (ties between indexes are the hard case).
+2. Each palette is searched linearly, through the candidate grid, through the k-d tree and with both structures built.
+3. Random queries and the corners of the RGB cube compare nearest_index, k_nearest (k = 1, 5 and the palette size) and radius_search
+   with a brute force ranking by squared distance then index, and top_k with the same ranking for every RGB metric.
+4. Palettes of up to 256 colors compare the inverse colormap for all 65536 RGB565 colors with a brute force search in RGB565 space.
+Exit status 0 if every structure returns exactly what the brute force search returns, 1 otherwise (first mismatches are printed).
+*/
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsUtils.h>
+#include <ColorsPalette.h>
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+static unsigned long failures = 0;
+
+// Report a mismatch (the first ones)
+static void mismatch(const char* structure, const char* check, size_t size, uint32_t query, uint32_t expected, uint32_t actual){
+  if (failures++ < 10) printf("%s %s (palette of %lu): query 0x%06lX expected %lu got %lu\n", structure, check, (unsigned long)size, (unsigned long)query, (unsigned long)expected, (unsigned long)actual);
+}
+
+// Deterministic pseudo-random numbers (xorshift32)
+static uint32_t seed = 2463534242UL;
+static uint32_t next_random(){
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+// Palette indexes ranked by distance then index with a metric
+static std::vector<palette_size_t> ranking(const std::vector<rgb24_t>& colors, rgb24_t query, color_metric_t metric){
+  std::vector<palette_size_t> order(colors.size());
+  for (size_t i = 0; i < colors.size(); i++) order[i] = (palette_size_t)i;
+  std::stable_sort(order.begin(), order.end(), [&](palette_size_t a, palette_size_t b){
+    return color_distance_sq(query, colors[a], metric) < color_distance_sq(query, colors[b], metric);
+  });
+  return order;
+}
+
+// Queries of a palette test: random colors, the cube corners and the palette colors themselves
+static std::vector<rgb24_t> make_queries(const std::vector<rgb24_t>& colors, size_t count){
+  std::vector<rgb24_t> queries;
+  for (uint32_t corner = 0; corner < 8; corner++) queries.push_back(rgb24_t(corner & 4 ? 255 : 0, corner & 2 ? 255 : 0, corner & 1 ? 255 : 0));
+  for (size_t i = 0; i < colors.size() && i < count / 4; i++) queries.push_back(colors[i]);
+  while (queries.size() < count) queries.push_back(rgb24_t(next_random() & 0xFFFFFF));
+  return queries;
+}
+
+// nearest_index, k_nearest and radius_search of a palette against the brute force ranking
+static void check_structure(const char* structure, const std::vector<rgb24_t>& colors, uint8_t index_flags, const std::vector<rgb24_t>& queries){
+  palette_t palette(colors.data(), (palette_size_t)colors.size(), index_flags);
+  size_t size = colors.size();
+  std::vector<palette_size_t> indexes(size);
+  std::vector<uint32_t> distances(size);
+  const palette_size_t ks[] = {1, 5, (palette_size_t)size};
+
+  for (rgb24_t query : queries){
+    std::vector<palette_size_t> order = ranking(colors, query, COLOR_METRIC_EUCLIDEAN);
+    palette_size_t nearest = palette.nearest_index(query);
+    if (nearest != order[0]) mismatch(structure, "nearest_index", size, query.value(), order[0], nearest);
+
+    for (palette_size_t k : ks){
+      palette_size_t expected_count = k < size ? k : (palette_size_t)size;
+      palette_size_t found = palette.k_nearest(query, k, indexes.data(), distances.data());
+      if (found != expected_count) mismatch(structure, "k_nearest count", size, query.value(), expected_count, found);
+      for (palette_size_t i = 0; i < found && i < expected_count; i++){
+        if (indexes[i] != order[i]) mismatch(structure, "k_nearest index", size, query.value(), order[i], indexes[i]);
+        uint32_t distance = color_distance_sq(query, colors[order[i]]);
+        if (distances[i] != distance) mismatch(structure, "k_nearest distance", size, query.value(), distance, distances[i]);
+      }
+    }
+
+    // radius of the 3rd nearest color, the structures may return the indexes in any order
+    uint32_t radius_sq = color_distance_sq(query, colors[order[size > 2 ? 2 : size - 1]]);
+    std::vector<palette_size_t> expected;
+    for (size_t i = 0; i < size; i++) if (color_distance_sq(query, colors[i]) <= radius_sq) expected.push_back((palette_size_t)i);
+    palette_size_t found = palette.radius_search(query, radius_sq, indexes.data(), (palette_size_t)size);
+    std::sort(indexes.begin(), indexes.begin() + (found < size ? found : size));
+    if (found != expected.size()) mismatch(structure, "radius_search count", size, query.value(), (uint32_t)expected.size(), found);
+    else if (!std::equal(expected.begin(), expected.end(), indexes.begin())) mismatch(structure, "radius_search indexes", size, query.value(), 0, 1);
+  }
+
+  // a structure that failed to build would silently test the linear search
+  if ((index_flags & PALETTE_INDEX_GRID) && !palette.grid().ready()) mismatch(structure, "grid build", size, 0, 1, 0);
+  if ((index_flags & PALETTE_INDEX_KDTREE) && !palette.kdtree().ready()) mismatch(structure, "kdtree build", size, 0, 1, 0);
+}
+
+// top_k of every RGB metric against the brute force ranking (queries repeated to exercise the result reuse)
+static void check_top_k(const std::vector<rgb24_t>& colors, const std::vector<rgb24_t>& queries){
+  palette_t palette(colors.data(), (palette_size_t)colors.size());
+  size_t size = colors.size();
+  const palette_size_t k = 5;
+  palette_size_t found = k < size ? k : (palette_size_t)size;
+  std::vector<rgb24_t> batch(queries);
+  batch.insert(batch.end(), queries.begin(), queries.begin() + queries.size() / 2);
+  std::vector<palette_size_t> indexes(batch.size() * k);
+  const color_metric_t metrics[] = {COLOR_METRIC_EUCLIDEAN, COLOR_METRIC_WEIGHTED, COLOR_METRIC_REDMEAN};
+
+  for (color_metric_t metric : metrics){
+    if (top_k(batch.data(), batch.size(), palette, k, indexes.data(), nullptr, metric) != found) mismatch("top_k", "count", size, 0, found, 0);
+    for (size_t q = 0; q < batch.size(); q++){
+      std::vector<palette_size_t> order = ranking(colors, batch[q], metric);
+      for (palette_size_t i = 0; i < found; i++){
+        if (indexes[q * k + i] != order[i]) mismatch("top_k", "index", size, batch[q].value(), order[i], indexes[q * k + i]);
+      }
+    }
+  }
+}
+
+// Inverse colormap against a brute force search in RGB565 space for every RGB565 color
+static void check_lut565(const std::vector<rgb24_t>& colors){
+  palette_t palette(colors.data(), (palette_size_t)colors.size(), PALETTE_INDEX_LUT565);
+  if (!palette.build_index(PALETTE_INDEX_LUT565)){
+    mismatch("lut565", "build", colors.size(), 0, 1, 0);
+    return;
+  }
+  std::vector<uint16_t> packed(colors.size());
+  for (size_t i = 0; i < colors.size(); i++) packed[i] = rgb888_to_rgb565(colors[i]).value;
+  for (uint32_t value = 0; value < 65536; value++){
+    rgb16_t query((uint16_t)value);
+    palette_size_t expected = 0;
+    uint16_t min_distance = UINT16_MAX;
+    for (size_t i = 0; i < packed.size(); i++){
+      uint16_t distance = color_distance_sq(query, rgb16_t(packed[i]));
+      if (distance < min_distance){
+        min_distance = distance;
+        expected = (palette_size_t)i;
+      }
+    }
+    palette_size_t index = palette.nearest_index(query);
+    if (index != expected) mismatch("lut565", "nearest_index", colors.size(), value, expected, index);
+  }
+}
+
+int main(){
+  const size_t sizes[] = {1, 2, 7, 16, 64, 256, 1000};
+  for (int clustered = 0; clustered < 2; clustered++){
+    for (size_t size : sizes){
+      // clustered palettes: 3 bits per channel around mid gray, many repeated colors and equal distances
+      std::vector<rgb24_t> colors(size);
+      for (size_t i = 0; i < size; i++){
+        uint32_t value = next_random();
+        colors[i] = clustered ? rgb24_t(120 + (value & 7) * 2, 120 + ((value >> 3) & 7) * 2, 120 + ((value >> 6) & 7) * 2) : rgb24_t(value & 0xFFFFFF);
+      }
+      std::vector<rgb24_t> queries = make_queries(colors, size > 256 ? 300 : 1000);
+
+      check_structure("linear", colors, PALETTE_INDEX_NONE, queries);
+      check_structure("grid", colors, PALETTE_INDEX_GRID, queries);
+      check_structure("kdtree", colors, PALETTE_INDEX_KDTREE, queries);
+      check_structure("grid+kdtree", colors, PALETTE_INDEX_GRID | PALETTE_INDEX_KDTREE, queries);
+      check_top_k(colors, queries);
+      if (size <= 256) check_lut565(colors);
+    }
+  }
+  printf("palette searches %s\n", failures == 0 ? "exact" : "MISMATCH");
+  if (failures > 0) printf("%lu mismatches\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+// parallel_convert.cpp
+
+// Creator: JDFraire-P
+
+// Description: Host test of the parallel image converter against the single-threaded library functions
+
+/*  Method
+1. Random images with padded source rows are converted with 1, 2 and 3 workers and bands of a few rows, so each image runs as many
+   tasks that the workers take and steal.
+2. Every output mode is compared with the single-threaded functions on the gamma corrected image: RGB565 in both byte orders
+   (convert_rgb888_to_rgb565, dither_rgb888_to_rgb565) and 1, 2, 4 and 8-bit palette indexes (dither_rgb888_to_palette, packed
+   first pixel in the high bits), for every dithering method.
+3. A batch of images of different sizes is converted in one call, each output is compared with its own reference, and the bytes
+   of the padded output rows must stay untouched.
+Exit status 0 if every output is identical, 1 otherwise (first mismatches are printed).
+*/
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsUtils.h>
+#include <ColorsPalette.h>
+#include <ColorsDither.h>
+#include <ColorsParallel.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static unsigned long failures = 0;
+
+// Report a mismatch (the first ones)
+static void mismatch(const char* mode, unsigned threads, size_t image, size_t offset, uint32_t expected, uint32_t actual){
+  if (failures++ < 10) printf("%s, %u threads, image %lu: byte %lu expected 0x%02lX got 0x%02lX\n", mode, threads, (unsigned long)image, (unsigned long)offset, (unsigned long)expected, (unsigned long)actual);
+}
+
+// Deterministic pseudo-random numbers (xorshift32)
+static uint32_t seed = 362436069UL;
+static uint32_t next_random(){
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+// Source image with padded rows (smooth gradients with noise, so the dithering patterns matter)
+struct test_image_t{
+  size_t width;
+  size_t height;
+  size_t stride; // source pixels per row
+  std::vector<rgb24_t> pixels;
+};
+
+static test_image_t make_image(size_t width, size_t height){
+  test_image_t image = {width, height, width + 3, {}};
+  image.pixels.resize(image.stride * height);
+  for (size_t y = 0; y < height; y++){
+    for (size_t x = 0; x < image.stride; x++){
+      uint32_t noise = next_random();
+      image.pixels[y * image.stride + x] = rgb24_t((uint8_t)(x * 255 / width + (noise & 7)), (uint8_t)(y * 255 / height + ((noise >> 3) & 7)), (uint8_t)(noise >> 8));
+    }
+  }
+  return image;
+}
+
+// Output mode of a test
+struct test_mode_t{
+  const char* name;
+  uint8_t index_bits; // 0: RGB565
+  bool big_endian;
+  dither_method_t method;
+};
+
+// Packed output rows of the single-threaded functions (rows of row_bytes, padded to dst_stride with 0xA5)
+static std::vector<uint8_t> reference_output(const test_image_t& image, const test_mode_t& mode, const uint8_t* gamma, const palette_t& palette, size_t dst_stride){
+  std::vector<rgb24_t> corrected(image.width * image.height);
+  for (size_t y = 0; y < image.height; y++){
+    for (size_t x = 0; x < image.width; x++){
+      rgb24_t color = image.pixels[y * image.stride + x];
+      corrected[y * image.width + x] = rgb24_t(gamma[color.red], gamma[color.green], gamma[color.blue]);
+    }
+  }
+
+  std::vector<uint8_t> output(dst_stride * image.height, 0xA5);
+  if (mode.index_bits == 0){
+    std::vector<uint16_t> words(image.width * image.height);
+    if (mode.method == DITHER_NONE) convert_rgb888_to_rgb565((const uint8_t*)corrected.data(), words.data(), words.size(), mode.big_endian);
+    else dither_rgb888_to_rgb565(corrected.data(), words.data(), image.width, image.height, mode.method, mode.big_endian);
+    for (size_t y = 0; y < image.height; y++) memcpy(&output[y * dst_stride], &words[y * image.width], image.width * sizeof(uint16_t));
+    return output;
+  }
+
+  std::vector<uint8_t> indexes(image.width * image.height);
+  dither_rgb888_to_palette(corrected.data(), indexes.data(), image.width, image.height, palette, mode.method);
+  uint8_t per_byte = 8 / mode.index_bits;
+  for (size_t y = 0; y < image.height; y++){
+    uint8_t* row = &output[y * dst_stride];
+    for (size_t x = 0; x < image.width; x += per_byte){
+      uint8_t byte = 0;
+      for (uint8_t k = 0; k < per_byte; k++) byte = (uint8_t)((byte << mode.index_bits) | (x + k < image.width ? indexes[y * image.width + x + k] : 0));
+      row[x / per_byte] = byte;
+    }
+  }
+  return output;
+}
+
+// Convert a batch of images with a converter and compare each output with its reference
+static void check_batch(const std::vector<test_image_t>& images, const test_mode_t& mode, unsigned threads, const uint8_t* gamma, const palette_t& palette){
+  image_converter_t converter(threads);
+  converter.set_gamma_lut(gamma);
+  converter.set_dither(mode.method);
+  if (mode.index_bits == 0) converter.set_rgb565(mode.big_endian);
+  else converter.set_palette(&palette, mode.index_bits);
+  // bands of 8 rows on the test images, many tasks per image
+  converter.set_tile_bytes(images[0].width * 3 * 8);
+
+  std::vector<std::vector<uint8_t>> outputs(images.size());
+  std::vector<size_t> strides(images.size());
+  std::vector<image_job_t> jobs(images.size());
+  for (size_t i = 0; i < images.size(); i++){
+    size_t row_bytes = mode.index_bits == 0 ? images[i].width * sizeof(uint16_t) : (images[i].width * mode.index_bits + 7) / 8;
+    strides[i] = row_bytes + 5;
+    outputs[i].assign(strides[i] * images[i].height, 0xA5);
+    jobs[i] = {images[i].pixels.data(), images[i].stride, outputs[i].data(), strides[i], images[i].width, images[i].height};
+  }
+  if (!converter.convert(jobs.data(), jobs.size())){
+    mismatch(mode.name, threads, 0, 0, 1, 0);
+    return;
+  }
+  for (size_t i = 0; i < images.size(); i++){
+    std::vector<uint8_t> expected = reference_output(images[i], mode, gamma, palette, strides[i]);
+    for (size_t b = 0; b < expected.size(); b++){
+      if (outputs[i][b] != expected[b]){
+        mismatch(mode.name, threads, i, b, expected[b], outputs[i][b]);
+        break;
+      }
+    }
+  }
+}
+
+int main(){
+  std::vector<test_image_t> images;
+  images.push_back(make_image(157, 93));
+  images.push_back(make_image(64, 40));
+  images.push_back(make_image(33, 7));
+
+  // gamma 2.2 table, identity would hide a missing gamma step
+  uint8_t gamma[256];
+  for (int c = 0; c < 256; c++) gamma[c] = (uint8_t)(255.0 * pow(c / 255.0, 1 / 2.2) + 0.5);
+
+  rgb24_t colors[16];
+  for (uint8_t i = 0; i < 16; i++) colors[i] = rgb24_t((uint8_t)(i & 1 ? 255 : 40 * (i >> 1)), (uint8_t)(i & 2 ? 200 : 20 * i), (uint8_t)(i & 4 ? 255 : 16 * i));
+  palette_t palette2(colors, 2);
+  palette_t palette4(colors, 4);
+  palette_t palette16(colors, 16, PALETTE_INDEX_LUT565 | PALETTE_INDEX_GRID);
+
+  const dither_method_t methods[] = {DITHER_NONE, DITHER_FLOYD_STEINBERG, DITHER_ATKINSON, DITHER_BAYER4, DITHER_BAYER8};
+  const char* const method_names[] = {"none", "floyd_steinberg", "atkinson", "bayer4", "bayer8"};
+  const uint8_t index_bits[] = {0, 1, 2, 4, 8};
+  const unsigned threads[] = {1, 2, 3};
+  for (uint8_t m = 0; m < 5; m++){
+    for (uint8_t bits : index_bits){
+      for (int big_endian = 0; big_endian < (bits == 0 ? 2 : 1); big_endian++){
+        char name[64];
+        snprintf(name, sizeof(name), "%s %s%s", method_names[m], bits == 0 ? "rgb565" : (bits == 1 ? "1-bit" : (bits == 2 ? "2-bit" : (bits == 4 ? "4-bit" : "8-bit"))), big_endian ? " be" : "");
+        test_mode_t mode = {name, bits, big_endian != 0, methods[m]};
+        const palette_t& palette = bits == 1 ? palette2 : (bits == 2 ? palette4 : palette16);
+        for (unsigned count : threads) check_batch(images, mode, count, gamma, palette);
+      }
+    }
+  }
+  printf("parallel converter %s\n", failures == 0 ? "identical" : "MISMATCH");
+  if (failures > 0) printf("%lu mismatches\n", failures);
+  return failures == 0 ? 0 : 1;
+}
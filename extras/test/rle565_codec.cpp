@@ -0,0 +1,145 @@
+// rle565_codec.cpp
+
+// Creator: JDFraire-P
+
+// Description: Host test of the RLE565 line codec (round trips, rle565_bound, truncated data and the streaming encoder and decoder)
+
+/*  Method
+1. Lines of 1 to 20000 pixels around the count limits (32 and 8192) are generated in several patterns: noise, flat runs, a reference
+   with sparse changes, alternating pixels and runs of every length around the RUN and COPY thresholds.
+2. Each line is encoded against a reference line and without reference, with the output buffer exactly rle565_bound(n) bytes:
+   the encoding must fit, decode back to the same pixels and consume exactly the encoded bytes.
+3. A buffer one byte smaller than the encoding must be refused, and every truncated encoding must fail to decode.
+4. The streaming encoder and decoder code a sequence of frames line by line, with a reset in the middle of the stream.
+Exit status 0 if every line round-trips, 1 otherwise (first failures are printed).
+*/
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsUtils.h>
+#include <ColorsDelta.h>
+#include <stdio.h>
+#include <vector>
+
+static unsigned long failures = 0;
+
+// Report a failure (the first ones)
+static void failure(const char* check, const char* pattern, size_t n, size_t expected, size_t actual){
+  if (failures++ < 10) printf("%s (%s, %lu pixels): expected %lu got %lu\n", check, pattern, (unsigned long)n, (unsigned long)expected, (unsigned long)actual);
+}
+
+// Deterministic pseudo-random numbers (xorshift32)
+static uint32_t seed = 88172645UL;
+static uint32_t next_random(){
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+// Line patterns
+enum pattern_t{ PATTERN_NOISE, PATTERN_FLAT, PATTERN_SPARSE, PATTERN_ALTERNATING, PATTERN_RUNS, PATTERNS };
+static const char* const PATTERN_NAMES[PATTERNS] = {"noise", "flat", "sparse", "alternating", "runs"};
+
+// Line of n pixels of a pattern (sparse changes and run lengths are taken against the reference)
+static void make_line(pattern_t pattern, const std::vector<uint16_t>& reference, std::vector<uint16_t>& line){
+  size_t n = line.size();
+  for (size_t i = 0; i < n; i++){
+    switch (pattern){
+      case PATTERN_NOISE: line[i] = (uint16_t)next_random(); break;
+      case PATTERN_FLAT: line[i] = (uint16_t)(i / 1000 * 0x0841); break;
+      case PATTERN_SPARSE: line[i] = next_random() % 16 == 0 ? (uint16_t)next_random() : reference[i]; break;
+      case PATTERN_ALTERNATING: line[i] = i % 2 ? 0xFFFF : 0x0000; break;
+      default: break;
+    }
+  }
+  if (pattern == PATTERN_RUNS){
+    // runs of 1 to 5 and around 32 pixels, equal to the reference or not
+    size_t i = 0;
+    while (i < n){
+      size_t length = next_random() % 4 == 0 ? 30 + next_random() % 5 : 1 + next_random() % 5;
+      bool copy = next_random() % 2 == 0;
+      uint16_t color = (uint16_t)next_random();
+      for (size_t j = 0; j < length && i < n; j++, i++) line[i] = copy ? reference[i] : color;
+    }
+  }
+}
+
+// Round trip of a line with and without reference
+static void check_line(pattern_t pattern, const std::vector<uint16_t>& reference, const std::vector<uint16_t>& line){
+  size_t n = line.size();
+  const char* name = PATTERN_NAMES[pattern];
+  std::vector<uint8_t> encoded(rle565_bound(n));
+  std::vector<uint16_t> decoded(n);
+
+  for (int with_reference = 0; with_reference < 2; with_reference++){
+    const uint16_t* ref = with_reference ? reference.data() : nullptr;
+    size_t length = rle565_encode(line.data(), ref, n, encoded.data(), encoded.size());
+    if (length == 0 || length > rle565_bound(n)){
+      failure("encode within rle565_bound", name, n, rle565_bound(n), length);
+      continue;
+    }
+    size_t read = rle565_decode(encoded.data(), length, ref, decoded.data(), n);
+    if (read != length) failure("decode length", name, n, length, read);
+    for (size_t i = 0; i < n; i++){
+      if (decoded[i] != line[i]){
+        failure("decoded pixel", name, n, line[i], decoded[i]);
+        break;
+      }
+    }
+
+    // a buffer too small is refused, truncated data is rejected
+    std::vector<uint8_t> small(length - 1);
+    size_t refused = rle565_encode(line.data(), ref, n, small.data(), small.size());
+    if (refused != 0) failure("encode into a small buffer", name, n, 0, refused);
+    for (size_t cut = length > 64 ? length - 64 : 0; cut < length; cut++){
+      size_t truncated = rle565_decode(encoded.data(), cut, ref, decoded.data(), n);
+      if (truncated != 0) failure("decode of truncated data", name, n, 0, truncated);
+    }
+  }
+}
+
+// Streaming encoder and decoder over a sequence of frames
+static void check_stream(size_t width, size_t height, size_t frames){
+  rle565_encoder_t encoder(width);
+  rle565_decoder_t decoder(width);
+  if (!encoder.ready() || !decoder.ready()){
+    failure("stream allocation", "stream", width, 1, 0);
+    return;
+  }
+  std::vector<uint16_t> reference(width);
+  std::vector<uint16_t> line(width);
+  std::vector<uint16_t> decoded(width);
+  std::vector<uint8_t> encoded(rle565_bound(width));
+  for (size_t row = 0; row < frames * height; row++){
+    if (row == frames * height / 2){
+      encoder.reset();
+      decoder.reset();
+    }
+    make_line((pattern_t)(row % PATTERNS), reference, line);
+    size_t length = encoder.encode(line.data(), encoded.data(), encoded.size());
+    size_t read = decoder.decode(encoded.data(), length, decoded.data());
+    if (length == 0 || read != length) failure("stream line length", PATTERN_NAMES[row % PATTERNS], width, length, read);
+    else if (decoded != line) failure("stream line pixels", PATTERN_NAMES[row % PATTERNS], width, 0, 1);
+    reference = line;
+  }
+}
+
+int main(){
+  const size_t widths[] = {1, 2, 3, 31, 32, 33, 64, 320, 8191, 8192, 8193, 20000};
+  for (size_t n : widths){
+    std::vector<uint16_t> reference(n);
+    std::vector<uint16_t> line(n);
+    for (size_t i = 0; i < n; i++) reference[i] = (uint16_t)next_random();
+    for (uint8_t pattern = 0; pattern < PATTERNS; pattern++){
+      make_line((pattern_t)pattern, reference, line);
+      check_line((pattern_t)pattern, reference, line);
+    }
+    // the reference itself (a static line)
+    check_line(PATTERN_SPARSE, reference, reference);
+  }
+  check_stream(320, 24, 4);
+  printf("rle565 codec %s\n", failures == 0 ? "round trips" : "FAILED");
+  if (failures > 0) printf("%lu failures\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+// simd_exhaustive.cpp
+
+// Creator: JDFraire-P
+
+// Description: Exhaustive host test of the bulk conversion kernels against the scalar rgb888_to_rgb565 and rgb565_to_rgb888
+
+/*  Method
+0. The channel scalings behind rgb888_to_rgb565 and rgb565_to_rgb888 are checked against the float reference round(c / 255.0 * 31.0)
+   (and the 6-bit and expanding forms) for every input, so the scalar oracle of the next steps cannot drift with the kernels.
+1. Every backend supported by the running CPU is selected in turn (AVX2, SSE2 or NEON, then scalar).
+2. All 2^24 RGB888 colors go through both convert_rgb888_to_rgb565 overloads (interleaved and packed) in both byte orders,
+   in blocks of 65536 pixels (one red value per block).
+3. All 2^16 RGB565 colors go through both convert_rgb565_to_rgb888 overloads in both byte orders.
+4. Every pixel is compared with the scalar conversion, then short and misaligned spans check the kernel edges and the scalar tails.
+Exit status 0 if every backend is bit-exact, 1 otherwise (first mismatches are printed).
+*/
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsUtils.h>
+#include "ColorsSimd.h"
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+static unsigned long failures = 0;
+
+// Report a mismatch (the first ones of each check)
+static void mismatch(const char* backend, const char* check, uint32_t input, uint32_t expected, uint32_t actual){
+  if (failures++ < 10) printf("%s %s: input 0x%06lX expected 0x%06lX got 0x%06lX\n", backend, check, (unsigned long)input, (unsigned long)expected, (unsigned long)actual);
+}
+
+static inline uint16_t swap_bytes(uint16_t value){
+  return (uint16_t)((value << 8) | (value >> 8));
+}
+
+// Expected RGB565 word of a RGB888 value
+static inline uint16_t expected_565(uint32_t value, bool big_endian){
+  uint16_t word = rgb888_to_rgb565(rgb24_t(value)).value;
+  return big_endian ? swap_bytes(word) : word;
+}
+
+// Channel scalings against the float rounding they replace (all 256, 32 and 64 inputs)
+static void check_channels(){
+  for (uint16_t c = 0; c < 256; c++){
+    uint8_t expected_5 = (uint8_t)round(c / 255.0 * 31.0);
+    uint8_t expected_6 = (uint8_t)round(c / 255.0 * 63.0);
+    if (channel8_to_5((uint8_t)c) != expected_5) mismatch("reference", "channel8_to_5", c, expected_5, channel8_to_5((uint8_t)c));
+    if (channel8_to_6((uint8_t)c) != expected_6) mismatch("reference", "channel8_to_6", c, expected_6, channel8_to_6((uint8_t)c));
+  }
+  for (uint8_t c = 0; c < 32; c++){
+    uint8_t expected = (uint8_t)round(c / 31.0 * 255.0);
+    if (channel5_to_8(c) != expected) mismatch("reference", "channel5_to_8", c, expected, channel5_to_8(c));
+  }
+  for (uint8_t c = 0; c < 64; c++){
+    uint8_t expected = (uint8_t)round(c / 63.0 * 255.0);
+    if (channel6_to_8(c) != expected) mismatch("reference", "channel6_to_8", c, expected, channel6_to_8(c));
+  }
+}
+
+// Every RGB888 color to RGB565
+static void check_rgb888_to_rgb565(const char* backend){
+  const size_t block = 65536;
+  std::vector<uint8_t> interleaved(3 * block);
+  std::vector<uint32_t> packed(block);
+  std::vector<uint16_t> output(block);
+
+  for (uint32_t red = 0; red < 256; red++){
+    for (uint32_t i = 0; i < block; i++){
+      uint32_t value = (red << 16) | i;
+      interleaved[3 * i] = (uint8_t)red;
+      interleaved[3 * i + 1] = (uint8_t)(i >> 8);
+      interleaved[3 * i + 2] = (uint8_t)i;
+      packed[i] = value | 0xFF000000UL; // the upper byte is ignored
+    }
+    for (int big_endian = 0; big_endian < 2; big_endian++){
+      convert_rgb888_to_rgb565(interleaved.data(), output.data(), block, big_endian);
+      for (uint32_t i = 0; i < block; i++){
+        uint32_t value = (red << 16) | i;
+        if (output[i] != expected_565(value, big_endian)) mismatch(backend, big_endian ? "rgb888_to_rgb565(uint8_t, be)" : "rgb888_to_rgb565(uint8_t)", value, expected_565(value, big_endian), output[i]);
+      }
+      convert_rgb888_to_rgb565(packed.data(), output.data(), block, big_endian);
+      for (uint32_t i = 0; i < block; i++){
+        uint32_t value = (red << 16) | i;
+        if (output[i] != expected_565(value, big_endian)) mismatch(backend, big_endian ? "rgb888_to_rgb565(uint32_t, be)" : "rgb888_to_rgb565(uint32_t)", value, expected_565(value, big_endian), output[i]);
+      }
+    }
+  }
+}
+
+// Every RGB565 color to RGB888
+static void check_rgb565_to_rgb888(const char* backend){
+  const size_t count = 65536;
+  std::vector<uint16_t> input(count);
+  std::vector<uint8_t> interleaved(3 * count);
+  std::vector<uint32_t> packed(count);
+
+  for (int big_endian = 0; big_endian < 2; big_endian++){
+    for (uint32_t i = 0; i < count; i++) input[i] = big_endian ? swap_bytes((uint16_t)i) : (uint16_t)i;
+    convert_rgb565_to_rgb888(input.data(), interleaved.data(), count, big_endian);
+    convert_rgb565_to_rgb888(input.data(), packed.data(), count, big_endian);
+    for (uint32_t i = 0; i < count; i++){
+      uint32_t expected = rgb565_to_rgb888(rgb16_t((uint16_t)i)).value();
+      uint32_t actual = ((uint32_t)interleaved[3 * i] << 16) | ((uint32_t)interleaved[3 * i + 1] << 8) | interleaved[3 * i + 2];
+      if (actual != expected) mismatch(backend, big_endian ? "rgb565_to_rgb888(uint8_t, be)" : "rgb565_to_rgb888(uint8_t)", i, expected, actual);
+      if (packed[i] != expected) mismatch(backend, big_endian ? "rgb565_to_rgb888(uint32_t, be)" : "rgb565_to_rgb888(uint32_t)", i, expected, packed[i]);
+    }
+  }
+}
+
+// Short and misaligned spans (kernel edges and scalar tails), the pixels around the span must stay untouched
+static void check_spans(const char* backend){
+  const size_t max_length = 80;
+  uint8_t interleaved[3 * (max_length + 4)];
+  uint32_t packed[max_length + 4];
+  uint16_t words[max_length + 4];
+  uint8_t colors[3 * (max_length + 4)];
+  for (size_t i = 0; i < sizeof(interleaved); i++) interleaved[i] = (uint8_t)(i * 37 + 11);
+  for (size_t i = 0; i < max_length + 4; i++){
+    packed[i] = (uint32_t)(i * 2654435761UL);
+    words[i] = (uint16_t)(i * 40503U);
+  }
+
+  for (size_t offset = 0; offset < 3; offset++){
+    for (size_t length = 0; length <= max_length; length++){
+      uint16_t output[max_length + 4];
+      output[offset + length] = 0xBEEF;
+      convert_rgb888_to_rgb565(interleaved + 3 * offset, output + offset, length, false);
+      for (size_t i = 0; i < length; i++){
+        const uint8_t* pixel = interleaved + 3 * (offset + i);
+        uint32_t value = ((uint32_t)pixel[0] << 16) | ((uint32_t)pixel[1] << 8) | pixel[2];
+        if (output[offset + i] != expected_565(value, false)) mismatch(backend, "span rgb888_to_rgb565(uint8_t)", value, expected_565(value, false), output[offset + i]);
+      }
+      if (output[offset + length] != 0xBEEF) mismatch(backend, "span rgb888_to_rgb565(uint8_t) overrun", (uint32_t)length, 0xBEEF, output[offset + length]);
+
+      output[offset + length] = 0xBEEF;
+      convert_rgb888_to_rgb565(packed + offset, output + offset, length, true);
+      for (size_t i = 0; i < length; i++){
+        uint32_t value = packed[offset + i] & 0xFFFFFF;
+        if (output[offset + i] != expected_565(value, true)) mismatch(backend, "span rgb888_to_rgb565(uint32_t, be)", value, expected_565(value, true), output[offset + i]);
+      }
+      if (output[offset + length] != 0xBEEF) mismatch(backend, "span rgb888_to_rgb565(uint32_t) overrun", (uint32_t)length, 0xBEEF, output[offset + length]);
+
+      colors[3 * (offset + length)] = 0xA5;
+      convert_rgb565_to_rgb888(words + offset, colors + 3 * offset, length, false);
+      for (size_t i = 0; i < length; i++){
+        uint32_t expected = rgb565_to_rgb888(rgb16_t(words[offset + i])).value();
+        const uint8_t* pixel = colors + 3 * (offset + i);
+        uint32_t actual = ((uint32_t)pixel[0] << 16) | ((uint32_t)pixel[1] << 8) | pixel[2];
+        if (actual != expected) mismatch(backend, "span rgb565_to_rgb888(uint8_t)", words[offset + i], expected, actual);
+      }
+      if (colors[3 * (offset + length)] != 0xA5) mismatch(backend, "span rgb565_to_rgb888(uint8_t) overrun", (uint32_t)length, 0xA5, colors[3 * (offset + length)]);
+    }
+  }
+}
+
+int main(){
+  check_channels();
+  printf("%-8s %s\n", "channels", failures == 0 ? "round() exact" : "MISMATCH");
+
+  const char* backends[8];
+  size_t count = simd_backend_names(backends, 8);
+  for (size_t i = 0; i < count && i < 8; i++){
+    if (!simd_select_backend(backends[i])){
+      printf("%s: cannot be selected\n", backends[i]);
+      failures++;
+      continue;
+    }
+    unsigned long before = failures;
+    check_rgb888_to_rgb565(backends[i]);
+    check_rgb565_to_rgb888(backends[i]);
+    check_spans(backends[i]);
+    printf("%-8s %s\n", get_conversion_backend(), failures == before ? "bit-exact" : "MISMATCH");
+  }
+  if (failures > 0) printf("%lu mismatches\n", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// ColorsBlend.h
+
+// Creator: JDFraire-P
+
+// Description: Alpha blending and compositing of packed RGB565 colors and spans without unpacking to RGB888
+
+/*  Spread channel blending
+1. Copy the RGB565 word into both halves of a 32-bit word and mask it with 0x07E0F81F: green moves to bits 21-26, red stays at bits 11-15
+   and blue at bits 0-4, with at least 5 free bits above each channel.
+2. Blend both colors with one 32-bit multiply: result = background + (foreground - background) * alpha / 32 (alpha 0 to 32), the free bits
+   take the carries and borrows so the three channels do not disturb each other.
+3. Mask the result again and fold the halves back into a RGB565 word.
+Every channel gets exactly background + floor((foreground - background) * alpha / 32), as if it was blended alone.
+8-bit alphas are rounded to 5 bits ((alpha + 4) / 8), so 0 keeps the background and 255 gives the foreground.
+*/
+
+#ifndef COLORSBLEND_H
+#define COLORSBLEND_H
+
+// Libraries
+#include <ColorsUtils.h>
+
+/* SPREAD CHANNELS */
+
+// Mask of the spread channels (green 21-26, red 11-15, blue 0-4)
+#define RGB565_SPREAD_MASK 0x07E0F81FUL
+
+// Spread a RGB565 word over 32 bits
+constexpr uint32_t rgb565_spread(uint16_t color){
+  return ((uint32_t)color | ((uint32_t)color << 16)) & RGB565_SPREAD_MASK;
+}
+// Fold spread channels back into a RGB565 word
+constexpr uint16_t rgb565_fold(uint32_t spread){
+  return (uint16_t)((spread & RGB565_SPREAD_MASK) | ((spread & RGB565_SPREAD_MASK) >> 16));
+}
+// Round an 8-bit alpha to the 0 to 32 range of the blend functions
+constexpr uint8_t alpha8_to_5(uint8_t alpha){
+  return (uint8_t)(((uint16_t)alpha + 4) >> 3);
+}
+
+/* BLEND FUNCTIONS */
+
+// Blend foreground over background with a 5-bit alpha (0: background, 32: foreground)
+constexpr rgb16_t blend565_alpha5(rgb16_t background, rgb16_t foreground, uint8_t alpha5){
+  return rgb16_t(rgb565_fold((((rgb565_spread(foreground.value) - rgb565_spread(background.value)) * alpha5) >> 5) + rgb565_spread(background.value)));
+}
+// Blend foreground over background with an 8-bit alpha (0: background, 255: foreground)
+constexpr rgb16_t blend565(rgb16_t background, rgb16_t foreground, uint8_t alpha){
+  return blend565_alpha5(background, foreground, alpha8_to_5(alpha));
+}
+
+// Saturate the channels of a spread sum that overflowed (carry bits 5, 16 and 27 fill their channel)
+constexpr uint32_t rgb565_saturate(uint32_t sum){
+  return sum | ((sum & 0x00010020UL) - ((sum & 0x00010020UL) >> 5)) | ((sum & 0x08000000UL) - ((sum & 0x08000000UL) >> 6));
+}
+// Add two colors channel by channel, clamped to the channel maximum
+constexpr rgb16_t add565(rgb16_t color_1, rgb16_t color_2){
+  return rgb16_t(rgb565_fold(rgb565_saturate(rgb565_spread(color_1.value) + rgb565_spread(color_2.value))));
+}
+
+// Product of two 5-bit channels scaled back to 5 bits, rounded to nearest (same result as round(a * b / 31.0))
+constexpr uint8_t multiply5(uint8_t channel_1, uint8_t channel_2){
+  return (uint8_t)(((uint16_t)channel_1 * channel_2 + 16 + (((uint16_t)channel_1 * channel_2 + 16) >> 5)) >> 5);
+}
+// Product of two 6-bit channels scaled back to 6 bits, rounded to nearest (same result as round(a * b / 63.0))
+constexpr uint8_t multiply6(uint8_t channel_1, uint8_t channel_2){
+  return (uint8_t)(((uint16_t)channel_1 * channel_2 + 32 + (((uint16_t)channel_1 * channel_2 + 32) >> 6)) >> 6);
+}
+// Multiply two colors channel by channel (white keeps the other color, black gives black)
+constexpr rgb16_t multiply565(rgb16_t color_1, rgb16_t color_2){
+  return rgb16_t(multiply5(color_1.red(), color_2.red()), multiply6(color_1.green(), color_2.green()), multiply5(color_1.blue(), color_2.blue()));
+}
+
+/* SPAN FUNCTIONS */
+// dst is the background and receives the result, big_endian: RGB565 words of dst and src are byte swapped (as SPI displays expect)
+
+// Blend n src colors over dst with a constant 8-bit alpha
+void blend565(uint16_t* dst, const uint16_t* src, size_t n, uint8_t alpha, bool big_endian = false);
+// Blend a color over n dst colors with a constant 8-bit alpha (translucent fills and overlays)
+void blend565(uint16_t* dst, rgb16_t color, size_t n, uint8_t alpha, bool big_endian = false);
+// Blend a color over n dst colors with a per pixel 8-bit alpha mask (A8 coverage of antialiased glyphs), 0 and 255 skip the blend
+void blend565_mask(uint16_t* dst, const uint8_t* mask, rgb16_t color, size_t n, bool big_endian = false);
+// Blend n RGBA8888 pixels (4 bytes per pixel: red, green, blue, alpha, not premultiplied) over dst
+void blend_rgba8888_over_rgb565(uint16_t* dst, const uint8_t* src, size_t n, bool big_endian = false);
+// Add n src colors to dst (clamped)
+void add565(uint16_t* dst, const uint16_t* src, size_t n, bool big_endian = false);
+// Multiply n dst colors by src colors
+void multiply565(uint16_t* dst, const uint16_t* src, size_t n, bool big_endian = false);
+
+#endif
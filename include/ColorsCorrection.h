@@ -0,0 +1,88 @@
+// ColorsCorrection.h
+
+// Creator: JDFraire-P
+
+// Description: Color correction lookup tables (gamma, brightness, white point, user curves) composed at setup and fused into pixel packing
+
+/*  Composed lookup tables
+1. A correction keeps one 256 entry table per channel (768 bytes), it starts as the identity.
+2. Every stage maps the current table entries through its curve, so any chain of stages ends as one table per channel:
+   the stages run in call order, for LEDs apply the gamma first and then brightness and white point (scaled in linear light).
+3. The gamma curve is computed once per stage with pow (256 calls), then the pixels only read tables: no float per pixel.
+4. Changing one stage means building the tables again: keep a copy of the slow stages (gamma) and apply the fast ones to the copy,
+   the correction is trivially copyable.
+*/
+
+/*  Fused conversion
+1. convert<FORMAT> reads each RGB888 pixel once, looks up each channel once and packs and writes the pixel once (pixel formats of ColorsFormat.h),
+   instead of a correction pass over the frame followed by a conversion pass.
+2. The loop is compiled for the format, so the packing is shifts and multiplies by constants.
+3. On hosts with vector kernels convert_rgb565 corrects blocks of 256 pixels and packs them with the bulk conversion kernels,
+   the block stays in the cache so the frame is still read once and written once.
+*/
+
+#ifndef COLORSCORRECTION_H
+#define COLORSCORRECTION_H
+
+// Libraries
+#include <ColorsUtils.h>
+#include <ColorsFormat.h>
+
+/* COLOR CORRECTION */
+
+// Per channel color correction, stages are composed into one 256 entry table per channel
+class color_correction_t{
+public:
+  // Identity correction
+  color_correction_t();
+
+  // STAGES (applied after the previous stages)
+
+  // Back to the identity
+  void reset();
+  // Gamma curve on every channel (output = 255 * (input / 255) ^ gamma, 2.2 to 2.8 for LEDs)
+  void apply_gamma(float gamma);
+  // Gamma curve per channel
+  void apply_gamma(float red_gamma, float green_gamma, float blue_gamma);
+  // Scale every channel by brightness / 255
+  void apply_brightness(uint8_t brightness);
+  // Scale each channel by the channel of the white point / 255 (white balance, 0xFFFFFF keeps the colors)
+  void apply_white_point(rgb24_t white);
+  // User curve of 256 entries on every channel
+  void apply_curve(const uint8_t* curve);
+  // User curve of 256 entries per channel (nullptr keeps the channel)
+  void apply_curves(const uint8_t* red_curve, const uint8_t* green_curve, const uint8_t* blue_curve);
+  // User curve of 256 entries in flash (PROGMEM) on every channel
+  void apply_curve_P(const uint8_t* curve);
+
+  // LOOKUP
+
+  // Table of a channel (0: red, 1: green, 2: blue)
+  const uint8_t* table(uint8_t channel) const { return tables[channel]; }
+  // Corrected color
+  rgb24_t correct(rgb24_t color) const { return rgb24_t(tables[0][color.red], tables[1][color.green], tables[2][color.blue]); }
+  // Correct n colors, src and dst may be the same
+  void correct(const rgb24_t* src, rgb24_t* dst, size_t n) const;
+
+  // FUSED CONVERSIONS (src: RGB888 pixels, 3 bytes per pixel red first, as rgb24_t arrays)
+
+  // Correct and pack n pixels to FORMAT (format_rgb565, format_grb888, ...), src and dst must not overlap
+  template <typename FORMAT>
+  void convert(const void* src, void* dst, size_t n) const{
+    const uint8_t* from = (const uint8_t*)src;
+    uint8_t* to = (uint8_t*)dst;
+    for (size_t i = 0; i < n; i++, from += 3, to += FORMAT::bytes){
+      FORMAT::store(to, FORMAT::pack(rgb24_t(tables[0][from[0]], tables[1][from[1]], tables[2][from[2]])));
+    }
+  }
+  // Correct and pack n pixels to RGB565, big_endian swaps the bytes of each word
+  void convert_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian = false) const;
+
+private:
+  // Map the table of a channel through a curve
+  void map(uint8_t channel, const uint8_t* curve);
+
+  uint8_t tables[3][256];
+};
+
+#endif
@@ -0,0 +1,123 @@
+// ColorsDelta.h
+
+// Creator: JDFraire-P
+
+// Description: Dirty span and rectangle diffing of RGB565 frames and a run-length / delta codec for RGB565 line streams
+
+/*  Frame diffing
+1. Equal pixels are skipped a machine word at a time (4 pixels on 64-bit hosts, 2 pixels on 8 and 32-bit boards), only the word with the
+   first difference is checked pixel by pixel.
+2. Spans: the dirty pixels of a line are grouped in spans, spans separated by up to gap clean pixels are merged (a few pixels sent again
+   cost less than a new address window on a SPI display). When the span array is full the last span grows to cover the rest of the line.
+3. Rectangles: each row gives the extent from its first to its last dirty pixel (searched from both ends), consecutive dirty rows are joined
+   into one rectangle and a clean row closes it. When the rectangle array is full the last rectangle grows to cover the rest.
+*/
+
+/*  RLE565 line codec
+1. A line is coded against a reference line: the same line of the previous frame (the receiver keeps it in its frame buffer) or the
+   previous line of the stream (the streaming encoder and decoder keep this one line of history).
+2. Operations: COPY n pixels of the reference, RUN of n pixels of one color, LITERAL n colors. The operation byte holds the operation in
+   bits 7-6 (0: COPY, 1: RUN, 2: LITERAL) and the count: bit 5 clear: count 1 to 32 in bits 4-0 (count - 1), bit 5 set: count 1 to 8192
+   in bits 4-0 and the next byte (count - 1, high bits first). Colors follow RUN and LITERAL as 2 bytes, most significant byte first.
+3. The encoder takes a COPY for 2 or more pixels equal to the reference, a RUN for 3 or more equal pixels and a LITERAL for the rest,
+   so a line never takes more than rle565_bound(n) bytes (2 bytes per pixel plus the LITERAL bytes).
+4. A static line of 320 pixels is 2 bytes (640 bytes raw), flat areas cost 3 bytes per run.
+*/
+
+#ifndef COLORSDELTA_H
+#define COLORSDELTA_H
+
+// Libraries
+#include <ColorsUtils.h>
+
+/* FRAME DIFFING */
+
+// Dirty span of a line (pixels start to start + length - 1)
+struct dirty_span_t{
+  uint16_t start;
+  uint16_t length;
+};
+
+// Dirty rectangle of a frame
+struct dirty_rect_t{
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+};
+
+// Dirty spans between the previous and the current line of n pixels, spans closer than gap clean pixels are merged, returns the spans stored
+size_t diff565_spans(const uint16_t* previous, const uint16_t* current, size_t n, dirty_span_t* spans, size_t max_spans, uint16_t gap = 0);
+// Dirty rectangles between two width x height frames (stride pixels per row, 0: width), returns the rectangles stored
+size_t diff565_rects(const uint16_t* previous, const uint16_t* current, size_t width, size_t height, size_t stride, dirty_rect_t* rects, size_t max_rects);
+// Bounding rectangle of the dirty pixels of two width x height frames (stride pixels per row, 0: width), false if the frames are equal
+bool diff565_bounds(const uint16_t* previous, const uint16_t* current, size_t width, size_t height, size_t stride, dirty_rect_t* bounds);
+
+/* RLE565 LINE CODEC */
+
+// Largest encoded size of a line of n pixels
+constexpr size_t rle565_bound(size_t n){ return 2 * n + 2 * (n / 8192 + 1); }
+
+// Encode a line of n pixels against a reference line of n pixels (nullptr: RUN and LITERAL only), returns the bytes written (0 if size is too small)
+size_t rle565_encode(const uint16_t* line, const uint16_t* reference, size_t n, uint8_t* out, size_t size);
+// Decode a line of n pixels against a reference line (nullptr: no COPY allowed), line and reference may be the same (COPY keeps the pixels),
+// returns the bytes read (0 if the data is truncated, invalid or does not cover exactly n pixels)
+size_t rle565_decode(const uint8_t* in, size_t length, const uint16_t* reference, uint16_t* line, size_t n);
+
+// Streaming encoder for lines of a fixed width, each line is coded against the previous one (one line of history)
+class rle565_encoder_t{
+public:
+  // Encoder for lines of width pixels
+  rle565_encoder_t(size_t width);
+  ~rle565_encoder_t();
+  rle565_encoder_t(const rle565_encoder_t&) = delete;
+  rle565_encoder_t& operator=(const rle565_encoder_t&) = delete;
+
+  // History line is allocated
+  bool ready() const { return history != nullptr; }
+  // Line width in pixels
+  size_t width() const { return columns; }
+
+  // Encode the next line of width pixels, returns the bytes written (0 if size is too small, the history is then kept)
+  size_t encode(const uint16_t* line, uint8_t* out, size_t size);
+  // Forget the history, the next line is coded without reference (start of a stream a decoder can join)
+  void reset() { started = false; }
+
+  // Heap memory owned by the history line (bytes)
+  size_t memory_usage() const { return history != nullptr ? columns * sizeof(uint16_t) : 0; }
+
+private:
+  size_t columns;
+  bool started;
+  uint16_t* history;
+};
+
+// Streaming decoder for lines of a fixed width, each line is decoded against the previous one (one line of history)
+class rle565_decoder_t{
+public:
+  // Decoder for lines of width pixels
+  rle565_decoder_t(size_t width);
+  ~rle565_decoder_t();
+  rle565_decoder_t(const rle565_decoder_t&) = delete;
+  rle565_decoder_t& operator=(const rle565_decoder_t&) = delete;
+
+  // History line is allocated
+  bool ready() const { return history != nullptr; }
+  // Line width in pixels
+  size_t width() const { return columns; }
+
+  // Decode the next line of width pixels, returns the bytes read (0 if the data is invalid, the history is then kept)
+  size_t decode(const uint8_t* in, size_t length, uint16_t* line);
+  // Forget the history, the next line must be coded without reference
+  void reset() { started = false; }
+
+  // Heap memory owned by the history line (bytes)
+  size_t memory_usage() const { return history != nullptr ? columns * sizeof(uint16_t) : 0; }
+
+private:
+  size_t columns;
+  bool started;
+  uint16_t* history;
+};
+
+#endif
@@ -0,0 +1,95 @@
+// ColorsDither.h
+
+// Creator: JDFraire-P
+
+// Description: Streaming dithering of RGB888 rows to RGB565 or palette indexes with bounded line buffers
+
+/*  Error diffusion (Floyd-Steinberg and Atkinson)
+1. Add the error carried to the pixel by its already processed neighbours and clamp the channels to 0-255.
+2. Quantize the pixel (RGB565 or nearest palette color) and take the error between the pixel and the quantized color.
+3. Spread the error over the neighbours not processed yet: Floyd-Steinberg sends 7/16 right, 3/16 below left, 5/16 below and 1/16 below right,
+   Atkinson sends 1/8 to two pixels right, three pixels below and one pixel two rows below (3/4 of the error, the rest is dropped).
+4. Errors to the right travel in registers, errors to the next rows are kept in line buffers: Floyd-Steinberg needs one line (the line is
+   overwritten in place as the row advances), Atkinson needs two lines. Rows alternate direction (serpentine scan) to avoid drift patterns.
+*/
+
+/*  Ordered dithering (Bayer)
+1. Read the threshold of the pixel position in a 4x4 or 8x8 Bayer matrix, thresholds are spread evenly over one quantization step.
+2. Add the threshold (centered on 0) to the pixel channels and quantize the pixel.
+No state is kept between pixels, so rows can be dithered in any order and there are no line buffers.
+*/
+
+#ifndef COLORSDITHER_H
+#define COLORSDITHER_H
+
+// Libraries
+#include <ColorsUtils.h>
+#include <ColorsPalette.h>
+
+/* DITHERING TYPES */
+
+// Dithering methods
+enum dither_method_t : uint8_t{
+  DITHER_NONE, // plain quantization (same as rgb888_to_rgb565 or nearest_index)
+  DITHER_FLOYD_STEINBERG, // error diffusion, one line buffer
+  DITHER_ATKINSON, // error diffusion, two line buffers, higher contrast
+  DITHER_BAYER4, // 4x4 ordered dithering, no buffers
+  DITHER_BAYER8 // 8x8 ordered dithering, no buffers
+};
+
+/* DITHERING ENGINE */
+
+// Row by row ditherer for frames of a fixed width, rows must be given from top to bottom
+class dither_t{
+public:
+  // Ditherer for rows of width pixels, spread is the ordered dithering amplitude for palette targets (0: from the palette size)
+  dither_t(dither_method_t method, size_t width, uint8_t spread = 0);
+  ~dither_t();
+  dither_t(const dither_t&) = delete;
+  dither_t& operator=(const dither_t&) = delete;
+
+  // Line buffers are allocated (always true for the methods without buffers)
+  bool ready() const { return errors != nullptr || !diffusion(); }
+  // Dithering method
+  dither_method_t method() const { return mode; }
+  // Row width in pixels
+  size_t width() const { return columns; }
+  // Index of the next row
+  uint32_t row() const { return y; }
+
+  // Dither the next row of width pixels to RGB565
+  void row_to_rgb565(const rgb24_t* src, uint16_t* dst, bool big_endian = false);
+  // Dither the next row of width pixels to palette indexes (palettes of up to 256 colors, uses the palette search structures)
+  void row_to_palette(const rgb24_t* src, const palette_t& palette, uint8_t* dst);
+  // Start a new frame (clears the carried errors and the row counter)
+  void reset();
+
+  // Heap memory owned by the line buffers (bytes)
+  size_t memory_usage() const { return errors != nullptr ? buffer_size() * sizeof(int16_t) : 0; }
+
+private:
+  // Method diffuses errors
+  bool diffusion() const { return mode == DITHER_FLOYD_STEINBERG || mode == DITHER_ATKINSON; }
+  // Line buffer entries (3 channels per pixel plus a padding pixel on each side, one or two lines)
+  size_t buffer_size() const { return (columns + 2) * 3 * (mode == DITHER_ATKINSON ? 2 : 1); }
+
+  template <typename TARGET> void dither_row(const rgb24_t* src, TARGET& target, uint8_t step_red, uint8_t step_green, uint8_t step_blue);
+  template <typename TARGET> void floyd_steinberg_row(const rgb24_t* src, TARGET& target);
+  template <typename TARGET> void atkinson_row(const rgb24_t* src, TARGET& target);
+  template <typename TARGET> void bayer_row(const rgb24_t* src, TARGET& target, uint8_t step_red, uint8_t step_green, uint8_t step_blue);
+
+  dither_method_t mode;
+  size_t columns;
+  uint8_t palette_spread;
+  uint32_t y;
+  int16_t* errors; // errors of the next rows in 1/16 (Floyd-Steinberg) or 1/8 (Atkinson) channel units
+};
+
+/* DITHERING FUNCTIONS */
+
+// Dither a width x height RGB888 frame to RGB565, false if the line buffers cannot be allocated
+bool dither_rgb888_to_rgb565(const rgb24_t* src, uint16_t* dst, size_t width, size_t height, dither_method_t method, bool big_endian = false);
+// Dither a width x height RGB888 frame to palette indexes (palettes of up to 256 colors), false if the line buffers cannot be allocated
+bool dither_rgb888_to_palette(const rgb24_t* src, uint8_t* dst, size_t width, size_t height, const palette_t& palette, dither_method_t method);
+
+#endif
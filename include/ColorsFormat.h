@@ -0,0 +1,179 @@
+// ColorsFormat.h
+
+// Creator: JDFraire-P
+
+// Description: Pixel format descriptors (RGB565, BGR565, RGB444, RGB332, RGB666, RGB888, GRB888, ARGB8888) and span converters specialized at compile time
+
+/*  Pixel formats
+1. A pixel format lists where each channel sits in the pixel word (pixel_channel<bits, shift>, 0 bits: no channel) and the byte order of the word in memory.
+2. The pixel takes the bytes needed by its highest channel bit (1 to 4), 3 byte formats are stored as 3 bytes, not padded words.
+3. Channels are scaled to and from 8 bits rounded to nearest: the same results as channel8_to_5, channel5_to_8 and the other RGB565 helpers.
+4. Missing channels read as 255 (alpha of opaque formats), so converting to a format with alpha gives opaque pixels.
+rgb888_t and rgb24_t use format_rgb888, rgb565_t and rgb16_t use format_rgb565 (pixel_format_of gives the format of a color type).
+*/
+
+/*  Span converter convert<SRC, DST>
+1. Every format is a type, so the loop of convert is compiled for one pair of formats: loading, channel moves and scaling are shifts, masks
+   and multiplies by constants, no format switch per pixel.
+2. Channels of the same width move without scaling, a format converted to itself is a copy of the words.
+3. RGB888 to and from RGB565 (native or byte swapped) use the bulk conversion functions and their vector kernels.
+*/
+
+#ifndef COLORSFORMAT_H
+#define COLORSFORMAT_H
+
+// Libraries
+#include <ColorsUtils.h>
+
+/* PIXEL FORMAT DESCRIPTORS */
+
+// Byte order of a pixel word in memory
+enum pixel_order_t : uint8_t{
+  PIXEL_LSB_FIRST, // least significant byte first (native words on AVR, ARM and x86)
+  PIXEL_MSB_FIRST // most significant byte first (byte swapped words for SPI displays, byte streams as RGB888)
+};
+
+// Channel of a pixel format, bits wide (0 to 8, 0: no channel) at bit shift of the pixel word
+template <uint8_t BITS, uint8_t SHIFT = 0>
+struct pixel_channel{
+  static_assert(BITS <= 8, "pixel channels are up to 8 bits");
+
+  static constexpr uint8_t bits = BITS;
+  static constexpr uint8_t shift = SHIFT;
+  static constexpr uint8_t maximum = (uint8_t)((1u << BITS) - 1);
+  static constexpr uint32_t mask = (uint32_t)maximum << SHIFT;
+
+  // Channel value of a pixel word
+  static constexpr uint8_t get(uint32_t word){ return (uint8_t)((word >> SHIFT) & maximum); }
+  // Channel value placed in a pixel word (masked to the channel bits)
+  static constexpr uint32_t place(uint8_t value){ return ((uint32_t)value & maximum) << SHIFT; }
+
+  // Scale an 8-bit value to the channel bits, rounded to nearest (exact (x + (x >> 8) + 1) >> 8 form of x / 255)
+  static constexpr uint8_t from8(uint8_t value){
+    return BITS == 8 ? value : BITS == 6 ? channel8_to_6(value) : BITS == 5 ? channel8_to_5(value)
+      : (uint8_t)(((uint16_t)value * maximum + 127 + (((uint16_t)value * maximum + 127) >> 8) + 1) >> 8);
+  }
+  // Scale a channel value to 8 bits, rounded to nearest (missing channels read as 255)
+  static constexpr uint8_t to8(uint8_t value){
+    return BITS == 8 ? value : BITS == 0 ? 255 : BITS == 6 ? channel6_to_8(value) : BITS == 5 ? channel5_to_8(value)
+      : (uint8_t)(((uint32_t)value * ((16711680UL + maximum / 2) / (maximum ? maximum : 1)) + 32768) >> 16);
+  }
+};
+
+// Larger of two channel ends (bits + shift)
+constexpr uint8_t pixel_top_bit(uint8_t end_1, uint8_t end_2){ return end_1 > end_2 ? end_1 : end_2; }
+
+// Storage word of a pixel of BYTES bytes
+template <uint8_t BYTES> struct pixel_word{ typedef uint32_t type; };
+template <> struct pixel_word<1>{ typedef uint8_t type; };
+template <> struct pixel_word<2>{ typedef uint16_t type; };
+
+// Pixel format: red, green, blue and alpha channels (pixel_channel) and byte order in memory
+template <typename R, typename G, typename B, typename A = pixel_channel<0>, pixel_order_t ORDER = PIXEL_LSB_FIRST>
+struct pixel_format{
+  typedef R red;
+  typedef G green;
+  typedef B blue;
+  typedef A alpha;
+
+  // Bits of the pixel word (highest channel bit + 1)
+  static constexpr uint8_t word_bits = pixel_top_bit(pixel_top_bit(R::bits + R::shift, G::bits + G::shift), pixel_top_bit(B::bits + B::shift, A::bits + A::shift));
+  // Bytes of a pixel in memory
+  static constexpr uint8_t bytes = (uint8_t)((word_bits + 7) / 8);
+  // Byte order of the pixel in memory
+  static constexpr pixel_order_t order = ORDER;
+  // Pixel word type (uint8_t, uint16_t or uint32_t)
+  typedef typename pixel_word<bytes>::type word_t;
+
+  static_assert(word_bits <= 32, "pixel formats are up to 32 bits");
+  static_assert((R::mask & G::mask) == 0 && (R::mask & B::mask) == 0 && (G::mask & B::mask) == 0
+    && ((R::mask | G::mask | B::mask) & A::mask) == 0, "pixel channels must not overlap");
+
+  // Pixel word of raw channel values (masked to their bits, no scaling)
+  static constexpr word_t place(uint8_t red_value, uint8_t green_value, uint8_t blue_value, uint8_t alpha_value = 0){
+    return (word_t)(R::place(red_value) | G::place(green_value) | B::place(blue_value) | A::place(alpha_value));
+  }
+  // Pixel word of a RGB888 color and an 8-bit alpha (ignored without alpha channel)
+  static constexpr word_t pack(rgb24_t color, uint8_t alpha_value = 255){
+    return place(R::from8(color.red), G::from8(color.green), B::from8(color.blue), A::from8(alpha_value));
+  }
+  // RGB888 color of a pixel word
+  static constexpr rgb24_t unpack(word_t word){
+    return rgb24_t(R::to8(R::get(word)), G::to8(G::get(word)), B::to8(B::get(word)));
+  }
+  // 8-bit alpha of a pixel word (255 without alpha channel)
+  static constexpr uint8_t opacity(word_t word){ return A::to8(A::get(word)); }
+
+  // Read the pixel word at pixel (byte reads, merged into one word read by the compiler)
+  static inline word_t load(const uint8_t* pixel){
+    word_t word = 0;
+    for (uint8_t i = 0; i < bytes; i++) word |= (word_t)((word_t)pixel[i] << (8 * (ORDER == PIXEL_LSB_FIRST ? i : bytes - 1 - i)));
+    return word;
+  }
+  // Write a pixel word at pixel
+  static inline void store(uint8_t* pixel, word_t word){
+    for (uint8_t i = 0; i < bytes; i++) pixel[i] = (uint8_t)(word >> (8 * (ORDER == PIXEL_LSB_FIRST ? i : bytes - 1 - i)));
+  }
+};
+
+/* PIXEL FORMATS */
+
+// RGB565, native 16-bit words (RRRRRGGGGGGBBBBB)
+typedef pixel_format<pixel_channel<5, 11>, pixel_channel<6, 5>, pixel_channel<5, 0>> format_rgb565;
+// RGB565, byte swapped words (most significant byte first, as SPI displays expect)
+typedef pixel_format<pixel_channel<5, 11>, pixel_channel<6, 5>, pixel_channel<5, 0>, pixel_channel<0>, PIXEL_MSB_FIRST> format_rgb565_swapped;
+// BGR565, native 16-bit words (BBBBBGGGGGGRRRRR, panels wired with blue first)
+typedef pixel_format<pixel_channel<5, 0>, pixel_channel<6, 5>, pixel_channel<5, 11>> format_bgr565;
+// RGB444, native 16-bit words (0000RRRRGGGGBBBB)
+typedef pixel_format<pixel_channel<4, 8>, pixel_channel<4, 4>, pixel_channel<4, 0>> format_rgb444;
+// RGB332, 1 byte (RRRGGGBB)
+typedef pixel_format<pixel_channel<3, 5>, pixel_channel<3, 2>, pixel_channel<2, 0>> format_rgb332;
+// RGB666, 3 bytes (red, green, blue, each channel in the 6 upper bits of its byte, ILI9488 18-bit mode)
+typedef pixel_format<pixel_channel<6, 18>, pixel_channel<6, 10>, pixel_channel<6, 2>, pixel_channel<0>, PIXEL_MSB_FIRST> format_rgb666;
+// RGB888, 3 bytes (red, green, blue, the layout of rgb24_t)
+typedef pixel_format<pixel_channel<8, 16>, pixel_channel<8, 8>, pixel_channel<8, 0>, pixel_channel<0>, PIXEL_MSB_FIRST> format_rgb888;
+// GRB888, 3 bytes (green, red, blue, the WS2812 LED order)
+typedef pixel_format<pixel_channel<8, 8>, pixel_channel<8, 16>, pixel_channel<8, 0>, pixel_channel<0>, PIXEL_MSB_FIRST> format_grb888;
+// ARGB8888, native 32-bit words (0xAARRGGBB)
+typedef pixel_format<pixel_channel<8, 16>, pixel_channel<8, 8>, pixel_channel<8, 0>, pixel_channel<8, 24>> format_argb8888;
+
+// Pixel format of a color type (rgb24_t, rgb16_t, rgb888_t and rgb565_t)
+template <typename COLOR> struct pixel_format_of;
+template <> struct pixel_format_of<rgb24_t>{ typedef format_rgb888 type; };
+template <> struct pixel_format_of<rgb16_t>{ typedef format_rgb565 type; };
+template <> struct pixel_format_of<rgb888_t>{ typedef format_rgb888 type; };
+template <> struct pixel_format_of<rgb565_t>{ typedef format_rgb565 type; };
+
+/* SPAN CONVERTER */
+
+// Convert a pixel word from SRC to DST (channels of the same width are moved, others scaled through 8 bits)
+template <typename SRC, typename DST, typename SRC_CHANNEL, typename DST_CHANNEL>
+constexpr uint32_t convert_channel(typename SRC::word_t word){
+  return SRC_CHANNEL::bits == DST_CHANNEL::bits
+    ? (SRC_CHANNEL::shift >= DST_CHANNEL::shift ? (uint32_t)word >> (SRC_CHANNEL::shift - DST_CHANNEL::shift) : (uint32_t)word << (DST_CHANNEL::shift - SRC_CHANNEL::shift)) & DST_CHANNEL::mask
+    : DST_CHANNEL::place(DST_CHANNEL::from8(SRC_CHANNEL::to8(SRC_CHANNEL::get(word))));
+}
+// Convert a pixel word from SRC to DST
+template <typename SRC, typename DST>
+constexpr typename DST::word_t convert_pixel(typename SRC::word_t word){
+  return (typename DST::word_t)(convert_channel<SRC, DST, typename SRC::red, typename DST::red>(word)
+    | convert_channel<SRC, DST, typename SRC::green, typename DST::green>(word)
+    | convert_channel<SRC, DST, typename SRC::blue, typename DST::blue>(word)
+    | convert_channel<SRC, DST, typename SRC::alpha, typename DST::alpha>(word));
+}
+
+// Convert n pixels from SRC to DST format, src and dst are bytes (SRC::bytes and DST::bytes per pixel) and must not overlap
+template <typename SRC, typename DST>
+void convert(const void* src, void* dst, size_t n){
+  const uint8_t* from = (const uint8_t*)src;
+  uint8_t* to = (uint8_t*)dst;
+  for (size_t i = 0; i < n; i++, from += SRC::bytes, to += DST::bytes) DST::store(to, convert_pixel<SRC, DST>(SRC::load(from)));
+}
+
+// RGB888 and RGB565 spans run on the bulk conversion functions (vector kernels), the RGB565 words must be 2 byte aligned
+template <> inline void convert<format_rgb888, format_rgb565>(const void* src, void* dst, size_t n){ convert_rgb888_to_rgb565((const uint8_t*)src, (uint16_t*)dst, n, false); }
+template <> inline void convert<format_rgb888, format_rgb565_swapped>(const void* src, void* dst, size_t n){ convert_rgb888_to_rgb565((const uint8_t*)src, (uint16_t*)dst, n, true); }
+template <> inline void convert<format_rgb565, format_rgb888>(const void* src, void* dst, size_t n){ convert_rgb565_to_rgb888((const uint16_t*)src, (uint8_t*)dst, n, false); }
+template <> inline void convert<format_rgb565_swapped, format_rgb888>(const void* src, void* dst, size_t n){ convert_rgb565_to_rgb888((const uint16_t*)src, (uint8_t*)dst, n, true); }
+
+#endif
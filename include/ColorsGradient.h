@@ -0,0 +1,114 @@
+// ColorsGradient.h
+
+// Creator: JDFraire-P
+
+// Description: Fixed-point multi-stop gradients for LED strips and displays (spans, linear and radial fills, color at t)
+
+/*  Gradient spans (DDA)
+1. Positions go from 0 to GRADIENT_END (65535), the stops are kept sorted by position, before the first stop and after the last one the color is constant.
+2. The stop colors are stored in the interpolation space: RGB channels, HSV (hsv_t of ColorsHsv.h) or OKLab in the 15-bit fixed point
+   of the OKLab conversions (L 0 to 32768), converted once per stop.
+3. A span of n colors walks t from the first to the last position with a 15-bit fixed-point step, one division per span.
+4. When t enters a segment the channel values at t and their step per color are computed (one division per channel and segment),
+   then every color adds the steps and rounds the channels with a shift: no division per color.
+5. The channels are converted to RGB888 and stored as rgb24_t, rgb888_t, RGB565 or GRB bytes. RGB only clamps, HSV costs the sextant multiplies
+   of hsv_to_rgb888 and OKLab the fixed-point inverse (LMS matrix, cubes, linear matrix and sRGB table search, about 25 multiplies, no division).
+HSV segments take the shortest way around the hue circle, a gray stop (no saturation) takes the hue of the other stop of the segment.
+*/
+
+/*  2D fills
+1. The colors along the vector (linear) or the radius (radial) are computed once with a span in a table of RGB565 words, a quarter pixel per entry,
+   so the interpolation space costs the same for every pixel count and each pixel only reads its entry.
+2. Linear: the entry grows along the vector from (x0, y0) to (x1, y1) and is constant across it, so each row adds a constant step (16-bit fixed point).
+   Pixels before the start or after the end of the vector take the first or last color.
+3. Radial: the distance is tracked from pixel to pixel with the squared distance (d^2 grows by 2 dx + 1 per pixel), no square root per pixel.
+*/
+
+#ifndef COLORSGRADIENT_H
+#define COLORSGRADIENT_H
+
+// Libraries
+#include <ColorsUtils.h>
+
+/* GRADIENT TYPES */
+
+// Maximum stops of a gradient
+#define GRADIENT_MAX_STOPS 8
+// Last position of a gradient
+#define GRADIENT_END 65535
+
+// Interpolation spaces
+enum gradient_space_t : uint8_t{
+  GRADIENT_RGB, // channel by channel, cheapest
+  GRADIENT_HSV, // hue, saturation and value, hue takes the shortest way around the circle (rainbows)
+  GRADIENT_OKLAB // perceptually even steps, no dark or gray middle between complementary colors
+};
+
+// Color stop (position 0 to GRADIENT_END)
+struct gradient_stop_t{
+  uint16_t position;
+  rgb24_t color;
+};
+
+/* GRADIENT ENGINE */
+
+// Multi-stop gradient, the stops are copied so the gradient can be kept in a global or passed by value
+class gradient_t{
+public:
+  // Gradient of count stops (up to GRADIENT_MAX_STOPS, sorted by position on copy)
+  gradient_t(const gradient_stop_t* stops, uint8_t count, gradient_space_t space = GRADIENT_RGB);
+  // Gradient of count evenly spaced colors (up to GRADIENT_MAX_STOPS)
+  gradient_t(const rgb24_t* colors, uint8_t count, gradient_space_t space = GRADIENT_RGB);
+  // Two colors gradient
+  gradient_t(rgb24_t from, rgb24_t to, gradient_space_t space = GRADIENT_RGB);
+
+  // Number of stops
+  uint8_t size() const { return count; }
+  // Interpolation space
+  gradient_space_t space() const { return mode; }
+
+  // Color at position t (no division, for animation loops: wrap the phase with a uint16_t counter)
+  rgb24_t color_at(uint16_t t) const;
+  // RGB565 color at position t
+  rgb16_t color565_at(uint16_t t) const { return rgb888_to_rgb565(color_at(t)); }
+
+  // SPANS (n colors from position from to position to, both included, to < from runs the gradient backwards)
+
+  // Fill n packed colors
+  void fill(rgb24_t* dst, size_t n, uint16_t from = 0, uint16_t to = GRADIENT_END) const;
+  // Fill n colors (only the channels and the value are written, the names are kept)
+  void fill(rgb888_t* dst, size_t n, uint16_t from = 0, uint16_t to = GRADIENT_END) const;
+  // Fill n RGB565 words, big_endian swaps the bytes of each word
+  void fill_rgb565(uint16_t* dst, size_t n, uint16_t from = 0, uint16_t to = GRADIENT_END, bool big_endian = false) const;
+  // Fill n LEDs with GRB bytes (3 bytes per LED: green, red, blue, the WS2812 order)
+  void fill_grb(uint8_t* dst, size_t n, uint16_t from = 0, uint16_t to = GRADIENT_END) const;
+
+  // 2D FILLS (RGB565 frames of width x height pixels, stride pixels per row, 0: width)
+
+  // Linear fill, the gradient runs from (x0, y0) to (x1, y1) (same points: last color), false if the color table cannot be allocated
+  bool fill_linear(uint16_t* dst, size_t width, size_t height, size_t stride, int16_t x0, int16_t y0, int16_t x1, int16_t y1, bool big_endian = false) const;
+  // Radial fill, the gradient runs from the center (cx, cy) to radius pixels (radius 0: last color), false if the color table cannot be allocated
+  bool fill_radial(uint16_t* dst, size_t width, size_t height, size_t stride, int16_t cx, int16_t cy, uint16_t radius, bool big_endian = false) const;
+
+private:
+  struct segment_t;
+
+  // Sort the stops and prepare the segments
+  void prepare();
+  // Number of stops at or before position t
+  uint8_t stops_before(uint16_t t) const;
+  // Channels of the stops of segment index (stop index to stop index + 1) in the interpolation space, hue path fixed
+  void segment_channels(uint8_t index, int32_t* channels_1, int32_t* channels_2) const;
+  // Segment under the 15-bit fixed-point position t and channel steps for a position step dt
+  void enter_segment(segment_t& segment, int32_t t, int32_t dt) const;
+  template <gradient_space_t SPACE, typename TARGET> void run_span(int32_t t, int32_t dt, size_t n, TARGET& target) const;
+  template <typename TARGET> void span(int32_t t, int32_t dt, size_t n, TARGET& target) const;
+
+  gradient_space_t mode;
+  uint8_t count;
+  uint16_t positions[GRADIENT_MAX_STOPS];
+  int32_t channels[GRADIENT_MAX_STOPS][3]; // stop colors in the interpolation space (OKLab in 15-bit fixed point)
+  uint32_t inverses[GRADIENT_MAX_STOPS]; // 2^24 / segment length (rounded), color_at scale
+};
+
+#endif
@@ -0,0 +1,120 @@
+// ColorsHsv.h
+
+// Creator: JDFraire-P
+
+// Description: HSV and HSL color types with integer-only conversions, bulk spans and a hue wheel table for rainbow effects
+
+/*  Convert HSV and HSL to RGB888 (no division, no sextant switch)
+1. Hues go from 0 to 1535 (HUE_STEPS): 256 steps per sextant of 60 degrees, so the sextant is the high byte and the fraction inside it the low byte.
+2. In every sextant one channel is at the top level, one at the bottom level and one rises or falls with the fraction.
+3. HSV: level = value - value * saturation / 255 * ramp / 256 (ramps: top 0, bottom 256, rising 256 - fraction, falling fraction).
+   HSL: level = lightness - saturation * min(lightness, 255 - lightness) / 255 * ramp / 128 (ramps: top -128, bottom 128, rising 128 - fraction, falling fraction - 128).
+4. The chroma is scaled once by 1 / 255 in fixed point (multiply by 65793 / 2^24), then each level is one multiply and one shift.
+5. A 6 x 3 table gives the level of red, green and blue in each sextant, so the conversion has no data dependent branch.
+The result is within 1 of the float conversion.
+*/
+
+/*  Convert RGB888 to HSV and HSL
+1. Take the largest and smallest channels, value is the largest one and lightness their mean.
+2. The hue fraction (difference of the other channels / (largest - smallest)) and the saturation use a 256 entry reciprocal table
+   (65536 / d, 16-bit) instead of a division, AVR has no hardware divider.
+3. The largest channel is selected with masks instead of branches, grays have no hue (their hue is 0).
+4. HSL saturation is taken against the rounded lightness, so hsl_to_rgb888 gets the spread of the channels back.
+RGB888 -> HSV -> RGB888 and RGB888 -> HSL -> RGB888 give back every RGB888 color within 1 per channel.
+*/
+
+/*  Hue wheel
+1. hue_wheel reads the fully saturated color of an 8-bit hue (0 to 255 for a full turn) from a 768 byte table in flash.
+2. hsv8_to_rgb888 applies saturation and value to the table color with one multiply per channel, full saturation and value read the table only.
+*/
+
+#ifndef COLORSHSV_H
+#define COLORSHSV_H
+
+// Libraries
+#include <ColorsUtils.h>
+
+/* HSV AND HSL TYPES */
+
+// Hue steps of a full turn (6 sextants of 256 steps)
+#define HUE_STEPS 1536
+
+// Hue of an angle in degrees
+constexpr uint16_t hue_from_degrees(uint16_t degrees){ return (uint16_t)(((uint32_t)(degrees % 360) * 64 + 7) / 15); }
+// Hue of an 8-bit hue wheel position
+constexpr uint16_t hue_from_hue8(uint8_t hue8){ return (uint16_t)(hue8 * 6); }
+
+// HSV color (4 bytes): hue 0 to 1535, saturation and value 0 to 255
+struct hsv_t{
+  uint16_t hue;
+  uint8_t saturation;
+  uint8_t value;
+
+  hsv_t() = default;
+  constexpr hsv_t(uint16_t hue, uint8_t saturation, uint8_t value) : hue(hue), saturation(saturation), value(value) {}
+};
+
+// HSL color (4 bytes): hue 0 to 1535, saturation and lightness 0 to 255
+struct hsl_t{
+  uint16_t hue;
+  uint8_t saturation;
+  uint8_t lightness;
+
+  hsl_t() = default;
+  constexpr hsl_t(uint16_t hue, uint8_t saturation, uint8_t lightness) : hue(hue), saturation(saturation), lightness(lightness) {}
+};
+
+static_assert(sizeof(hsv_t) == 4, "hsv_t must be 4 bytes");
+static_assert(sizeof(hsl_t) == 4, "hsl_t must be 4 bytes");
+
+/* HSV AND HSL CONVERSION FUNCTIONS */
+// rgb888_t and rgb565_t colors convert to rgb24_t and rgb16_t, rgb888_t(rgb24_t) and rgb565_t(rgb16_t) convert back
+
+// Convert RGB888 to HSV
+hsv_t rgb888_to_hsv(rgb24_t color);
+// Convert RGB565 to HSV (expanded to RGB888)
+hsv_t rgb565_to_hsv(rgb16_t color);
+// Convert HSV to RGB888 (hues of 1536 and above wrap around)
+rgb24_t hsv_to_rgb888(hsv_t color);
+// Convert HSV to RGB565
+rgb16_t hsv_to_rgb565(hsv_t color);
+
+// Convert RGB888 to HSL
+hsl_t rgb888_to_hsl(rgb24_t color);
+// Convert RGB565 to HSL (expanded to RGB888)
+hsl_t rgb565_to_hsl(rgb16_t color);
+// Convert HSL to RGB888 (hues of 1536 and above wrap around)
+rgb24_t hsl_to_rgb888(hsl_t color);
+// Convert HSL to RGB565
+rgb16_t hsl_to_rgb565(hsl_t color);
+
+/* HUE WHEEL FUNCTIONS */
+
+// Fully saturated color of an 8-bit hue (0: red, 85: green, 170: blue), read from a 256 entry table
+rgb24_t hue_wheel(uint8_t hue8);
+// HSV color with an 8-bit hue through the hue wheel table
+rgb24_t hsv8_to_rgb888(uint8_t hue8, uint8_t saturation, uint8_t value);
+
+/* BULK HSV AND HSL FUNCTIONS */
+
+// Convert n RGB888 colors to HSV
+void convert_rgb888_to_hsv(const rgb24_t* src, hsv_t* dst, size_t n);
+// Convert n HSV colors to RGB888
+void convert_hsv_to_rgb888(const hsv_t* src, rgb24_t* dst, size_t n);
+// Convert n HSV colors to RGB565, big_endian swaps the bytes of each word
+void convert_hsv_to_rgb565(const hsv_t* src, uint16_t* dst, size_t n, bool big_endian = false);
+// Convert n RGB888 colors to HSL
+void convert_rgb888_to_hsl(const rgb24_t* src, hsl_t* dst, size_t n);
+// Convert n HSL colors to RGB888
+void convert_hsl_to_rgb888(const hsl_t* src, rgb24_t* dst, size_t n);
+// Convert n HSL colors to RGB565, big_endian swaps the bytes of each word
+void convert_hsl_to_rgb565(const hsl_t* src, uint16_t* dst, size_t n, bool big_endian = false);
+
+// Rotate the hue of n colors by shift hue steps (negative turns backwards), saturation and value are kept, src and dst may be the same
+void rotate_hue(const rgb24_t* src, rgb24_t* dst, size_t n, int16_t shift);
+// Fill n colors with a rainbow through the hue wheel: 8-bit hue from start, step hues per color (both 8.8 fixed point)
+void fill_rainbow(rgb24_t* dst, size_t n, uint16_t start, int16_t step, uint8_t saturation = 255, uint8_t value = 255);
+// Fill n LEDs with a rainbow in GRB bytes (3 bytes per LED: green, red, blue, the WS2812 order)
+void fill_rainbow_grb(uint8_t* dst, size_t n, uint16_t start, int16_t step, uint8_t saturation = 255, uint8_t value = 255);
+
+#endif
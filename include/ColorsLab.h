@@ -0,0 +1,109 @@
+// ColorsLab.h
+
+// Creator: JDFraire-P
+
+// Description: Perceptual color spaces (CIELAB and OKLab), fixed-point conversions and delta E metrics
+
+/*  Convert RGB888 to CIELAB (D65 white)
+1. Linearize each sRGB channel with a 256 entry table (linear values in 16-bit fixed point), no pow() per pixel.
+2. Multiply the linear channels by the sRGB to XYZ matrix (14-bit fixed point coefficients), the D65 white point is folded into the matrix so white gives X = Y = Z = 1.
+3. Apply f(t): the cube root above (6/29)^3 and the linear segment 7.787 t + 16/116 below it.
+4. L = 116 f(Y) - 16, a = 500 (f(X) - f(Y)), b = 200 (f(Y) - f(Z)), stored in hundredths.
+*/
+
+/*  Convert RGB888 to OKLab
+1. Linearize each sRGB channel with the same table.
+2. Multiply the linear channels by the OKLab LMS matrix (14-bit fixed point coefficients).
+3. Take the cube root of L, M and S.
+4. Multiply the roots by the OKLab output matrix (13-bit fixed point coefficients), L, a and b are stored in ten-thousandths.
+*/
+
+/*  Fixed-point cube root
+1. Scale the input (20-bit fixed point, 0 to 1) up by powers of 8 until it is at least 1/8, each power of 8 halves the root.
+2. Read the root of the scaled value from a 225 entry table over [1/8, 1] and interpolate linearly between entries.
+3. Shift the root back down once per power of 8, the error stays below one unit of the 15-bit result.
+*/
+
+/*  Convert CIELAB and OKLab back to RGB888
+1. Run the steps backwards: inverse f(t) or cube, then the inverse matrix (12-bit fixed point coefficients).
+2. Clip the linear channels to [0, 1] (colors outside the sRGB gamut are clipped per channel).
+3. Find the sRGB value whose linear value is nearest with a binary search in the linearization table.
+*/
+
+#ifndef COLORSLAB_H
+#define COLORSLAB_H
+
+// Libraries
+#include <ColorsUtils.h>
+
+/* PERCEPTUAL COLOR TYPES */
+
+// CIELAB color (D65 white) in hundredths: L from 0 to 10000, a and b about -11000 to 11000 for sRGB colors
+struct lab_t{
+  int16_t L;
+  int16_t a;
+  int16_t b;
+
+  lab_t() = default;
+  constexpr lab_t(int16_t L, int16_t a, int16_t b) : L(L), a(a), b(b) {}
+};
+
+// OKLab color in ten-thousandths: L from 0 to 10000, a and b about -3200 to 3200 for sRGB colors
+struct oklab_t{
+  int16_t L;
+  int16_t a;
+  int16_t b;
+
+  oklab_t() = default;
+  constexpr oklab_t(int16_t L, int16_t a, int16_t b) : L(L), a(a), b(b) {}
+};
+
+static_assert(sizeof(lab_t) == 6, "lab_t must be 6 bytes");
+static_assert(sizeof(oklab_t) == 6, "oklab_t must be 6 bytes");
+
+/* PERCEPTUAL CONVERSION FUNCTIONS */
+
+// Convert RGB888 to CIELAB
+lab_t rgb888_to_lab(rgb24_t color);
+// Convert RGB565 to CIELAB (expanded to RGB888)
+lab_t rgb565_to_lab(rgb16_t color);
+// Convert CIELAB to RGB888 (clipped to the sRGB gamut)
+rgb24_t lab_to_rgb888(lab_t color);
+
+// Convert RGB888 to OKLab
+oklab_t rgb888_to_oklab(rgb24_t color);
+// Convert RGB565 to OKLab (expanded to RGB888)
+oklab_t rgb565_to_oklab(rgb16_t color);
+// Convert OKLab to RGB888 (clipped to the sRGB gamut)
+rgb24_t oklab_to_rgb888(oklab_t color);
+
+// Convert n RGB888 colors to CIELAB
+void convert_rgb888_to_lab(const rgb24_t* src, lab_t* dst, size_t n);
+// Convert n RGB888 colors to OKLab
+void convert_rgb888_to_oklab(const rgb24_t* src, oklab_t* dst, size_t n);
+
+/* PERCEPTUAL DISTANCE FUNCTIONS */
+
+// Squared delta E 1976 (euclidean distance in CIELAB) in hundredths squared
+constexpr uint32_t delta_e76_sq(lab_t color_1, lab_t color_2){
+  return (uint32_t)(((int32_t)color_1.L - color_2.L) * ((int32_t)color_1.L - color_2.L))
+       + (uint32_t)(((int32_t)color_1.a - color_2.a) * ((int32_t)color_1.a - color_2.a))
+       + (uint32_t)(((int32_t)color_1.b - color_2.b) * ((int32_t)color_1.b - color_2.b));
+}
+// Delta E 1976
+float delta_e76(lab_t color_1, lab_t color_2);
+// Delta E 2000 (CIEDE2000, reference weights kL = kC = kH = 1)
+float delta_e2000(lab_t color_1, lab_t color_2);
+// Squared delta E 2000 in hundredths squared (rounded, same units as delta_e76_sq)
+uint32_t delta_e2000_sq(lab_t color_1, lab_t color_2);
+
+// Squared euclidean distance in OKLab in ten-thousandths squared
+constexpr uint32_t oklab_distance_sq(oklab_t color_1, oklab_t color_2){
+  return (uint32_t)(((int32_t)color_1.L - color_2.L) * ((int32_t)color_1.L - color_2.L))
+       + (uint32_t)(((int32_t)color_1.a - color_2.a) * ((int32_t)color_1.a - color_2.a))
+       + (uint32_t)(((int32_t)color_1.b - color_2.b) * ((int32_t)color_1.b - color_2.b));
+}
+// Euclidean distance in OKLab (0 to about 1)
+float oklab_distance(oklab_t color_1, oklab_t color_2);
+
+#endif
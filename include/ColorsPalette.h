@@ -0,0 +1,319 @@
+// ColorsPalette.h
+
+// Creator: JDFraire-P
+
+// Description: Sized color palettes with precomputed nearest color search structures
+
+/*  Inverse colormap (RGB565 lookup table)
+1. For each of the 65536 RGB565 colors, find the nearest palette color packed to RGB565, compared in RGB565 channel units (first index on ties).
+2. Store the palette index of that color in a 65536 byte table (palettes of up to 256 colors).
+3. A nearest color query for a RGB565 color is then a single load: table[rgb565.value].
+The table depends only on the palette, it can be built once on the host and shipped as a const (flash) array.
+Every RGB565 query of a palette (nearest_index(rgb16_t), nearest_index_rgb565, get_similar_color565 with the euclidean metric) compares
+in RGB565 space, the same answer as get_similar_color565 over a color list, with or without the table. RGB888 queries compare in RGB888.
+*/
+
+/*  Candidate grid (RGB888)
+1. Split the RGB888 cube in 2^bits x 2^bits x 2^bits cells.
+2. For each cell find the smallest "farthest corner" distance over all palette colors, no point of the cell is farther than that from its nearest color.
+3. Keep as candidates only the palette colors whose distance to the cell box is not greater than that bound.
+4. A nearest color query scans only the candidates of its cell, and still returns the exact nearest color.
+*/
+
+/*  k-d tree (RGB888)
+1. Sort the palette indexes around the median of the channel with the largest spread, the median is the node and each half is a subtree.
+2. Repeat on each half until every index is a node, the tree is stored implicitly in the sorted index array (no pointers).
+3. A query descends to the side of its own channel value first and visits the other side only if the splitting plane is not farther than the current result.
+Queries are exact (same result as the linear search) and cost about log2(size) distance evaluations on typical palettes.
+*/
+
+/*  Derived caches and memory budget
+1. The palette derives its caches from the colors on first use: packed RGB565 colors, CIELAB and OKLab colors, name, value and
+   luminance orders, and the search structures selected with index_flags. Each one is computed once and shared by every later query.
+2. set_color() copies the colors on the first change (the caller list is never written), invalidate() is for colors changed in place
+   by the caller. Both release every cache, the selected search structures are built again on the next query.
+3. A cache or structure is only built if it fits in the memory budget with the ones already built, otherwise the queries fall back
+   to the linear searches and per entry conversions (same results, slower). Lowering the budget below the memory in use releases the caches.
+*/
+
+#ifndef COLORSPALETTE_H
+#define COLORSPALETTE_H
+
+// Libraries
+#include <ColorsUtils.h>
+#include <ColorsLab.h>
+
+/* PALETTE TYPES */
+
+// Palette sizes and indexes (AVR palettes are limited to 65535 colors)
+#if defined(__AVR__)
+typedef uint16_t palette_size_t;
+#else
+typedef uint32_t palette_size_t;
+#endif
+
+// Index returned when a color is not found
+#define PALETTE_NOT_FOUND ((palette_size_t)-1)
+
+// Size in bytes of a RGB565 inverse colormap
+#define PALETTE_LUT565_SIZE 65536UL
+// Inverse colormaps can be allocated (false with a 16-bit size_t, AVR boards attach a table in flash instead)
+#define PALETTE_LUT565_ALLOCATABLE (PALETTE_LUT565_SIZE - 1 <= (size_t)-1)
+
+// Search structures a palette builds on first use
+#define PALETTE_INDEX_NONE 0x00
+#define PALETTE_INDEX_LUT565 0x01 // 64 KiB inverse colormap for RGB565 queries (palettes of up to 256 colors)
+#define PALETTE_INDEX_GRID 0x02 // candidate grid for RGB888 queries
+#define PALETTE_INDEX_KDTREE 0x04 // k-d tree for RGB888 queries, nearest, k-nearest and radius queries on large palettes
+
+// Memory budget of a palette without limit
+#define PALETTE_BUDGET_UNLIMITED ((size_t)-1)
+
+class palette_t;
+
+/* INVERSE COLORMAP */
+
+// Nearest palette index for each RGB565 color in RGB565 space (palettes of up to 256 colors)
+class palette_lut565_t{
+public:
+  palette_lut565_t();
+  ~palette_lut565_t();
+  palette_lut565_t(const palette_lut565_t&) = delete;
+  palette_lut565_t& operator=(const palette_lut565_t&) = delete;
+
+  // Build the table in an owned buffer of PALETTE_LUT565_SIZE bytes (false if the palette has more than 256 colors, allocation fails
+  // or size_t is 16-bit: boards without 64 KiB of RAM attach a table built on a host and stored in flash)
+  bool build(const palette_t& palette);
+  // Build the table in a caller buffer of PALETTE_LUT565_SIZE bytes (to keep it in a static buffer or dump it as a flash array)
+  bool build(const palette_t& palette, uint8_t* table);
+  // Use a prebuilt table (progmem: the table is in AVR program memory)
+  void attach(const uint8_t* table, bool progmem = false);
+  // Release the table
+  void clear();
+
+  // Table is ready for queries
+  bool ready() const { return table != nullptr; }
+  // Table bytes
+  const uint8_t* data() const { return table; }
+
+  // Nearest palette index of a RGB565 color
+  uint8_t nearest_index(rgb16_t color) const { return progmem ? pgm_read_byte(table + color.value) : table[color.value]; }
+  // Nearest palette index of each RGB565 color in src
+  void nearest_index(const uint16_t* src, uint8_t* dst, size_t n) const;
+
+  // Time spent in the last build (microseconds)
+  uint32_t build_time_us() const { return build_time; }
+  // Heap memory owned by the table (bytes, 0 for attached or caller tables)
+  size_t memory_usage() const { return owned ? (size_t)PALETTE_LUT565_SIZE : 0; }
+
+private:
+  const uint8_t* table;
+  bool owned;
+  bool progmem;
+  uint32_t build_time;
+};
+
+/* CANDIDATE GRID */
+
+// Per cell candidate lists for exact nearest RGB888 queries
+class palette_grid_t{
+public:
+  palette_grid_t();
+  ~palette_grid_t();
+  palette_grid_t(const palette_grid_t&) = delete;
+  palette_grid_t& operator=(const palette_grid_t&) = delete;
+
+  // Build the grid with 2^bits cells per channel (1 to 5 bits), false if allocation fails
+  bool build(const palette_t& palette, uint8_t bits = 3);
+  // Release the grid
+  void clear();
+
+  // Grid is ready for queries
+  bool ready() const { return offsets != nullptr; }
+
+  // Nearest palette index of a RGB888 color (exact, first index on ties)
+  palette_size_t nearest_index(const palette_t& palette, rgb24_t color) const;
+
+  // Time spent in the last build (microseconds)
+  uint32_t build_time_us() const { return build_time; }
+  // Heap memory owned by the grid (bytes)
+  size_t memory_usage() const;
+  // Average candidates per cell (search cost of a query)
+  float average_candidates() const;
+
+private:
+  palette_size_t* offsets; // first candidate of each cell, cells + 1 entries
+  palette_size_t* candidates; // palette indexes of each cell, in palette order
+  uint8_t bits;
+  uint32_t build_time;
+};
+
+/* K-D TREE */
+
+// Implicit k-d tree over the palette colors
+class palette_kdtree_t{
+public:
+  palette_kdtree_t();
+  ~palette_kdtree_t();
+  palette_kdtree_t(const palette_kdtree_t&) = delete;
+  palette_kdtree_t& operator=(const palette_kdtree_t&) = delete;
+
+  // Build the tree, false if allocation fails
+  bool build(const palette_t& palette);
+  // Release the tree
+  void clear();
+
+  // Tree is ready for queries
+  bool ready() const { return order != nullptr; }
+
+  // Nearest palette index of a RGB888 color (exact, first index on ties)
+  palette_size_t nearest_index(const palette_t& palette, rgb24_t color) const;
+  // Up to k nearest palette indexes sorted by distance (then index), distances are optional, returns the count found
+  palette_size_t k_nearest(const palette_t& palette, rgb24_t color, palette_size_t k, palette_size_t* indexes, uint32_t* distances = nullptr) const;
+  // Palette indexes within squared distance radius_sq (tree order), stores up to max_count and returns the total count
+  palette_size_t radius_search(const palette_t& palette, rgb24_t color, uint32_t radius_sq, palette_size_t* indexes, palette_size_t max_count) const;
+
+  // Time spent in the last build (microseconds)
+  uint32_t build_time_us() const { return build_time; }
+  // Heap memory owned by the tree (bytes)
+  size_t memory_usage() const { return ready() ? (size_t)size * (sizeof(palette_size_t) + 1) : 0; }
+
+private:
+  palette_size_t* order; // palette indexes in tree order, node of [low, high) is at (low + high) / 2
+  uint8_t* axes; // split channel of each node (0 red, 1 green, 2 blue)
+  palette_size_t size;
+  uint32_t build_time;
+};
+
+/* PALETTE */
+
+// Sized palette of packed colors with search structures built on first use
+class palette_t{
+public:
+  // Palette over colors (not copied, colors must outlive the palette), index_flags selects the structures built on first use
+  palette_t(const rgb24_t* colors, palette_size_t size, uint8_t index_flags = PALETTE_INDEX_NONE);
+  ~palette_t();
+  palette_t(const palette_t&) = delete;
+  palette_t& operator=(const palette_t&) = delete;
+
+  // Number of colors
+  palette_size_t size() const { return count; }
+  // Colors
+  const rgb24_t* colors() const { return list; }
+  // Color at index
+  rgb24_t operator[](palette_size_t index) const { return list[index]; }
+  // Change the color at index (the colors are copied on the first change, a palette over COLORS then loses the built-in names),
+  // false if index is out of range or the copy cannot be allocated
+  bool set_color(palette_size_t index, rgb24_t color);
+  // The colors were changed in place by the caller: release the caches, the selected structures are built again on next use
+  void invalidate();
+
+  // Index of the nearest color (squared euclidean distance in RGB888, first index on ties, PALETTE_NOT_FOUND if empty)
+  palette_size_t nearest_index(rgb24_t color) const;
+  // Index of the nearest color to a RGB565 color (squared euclidean distance in RGB565 space, same as nearest_index_rgb565)
+  palette_size_t nearest_index(rgb16_t color) const;
+  // Nearest color index of each RGB565 color in src (RGB565 space, palettes of up to 256 colors)
+  void nearest_index(const uint16_t* src, uint8_t* dst, size_t n) const;
+  // Nearest color index of each RGB888 color in src (palettes of up to 256 colors)
+  void nearest_index(const rgb24_t* src, uint8_t* dst, size_t n) const;
+  // Up to k nearest color indexes sorted by distance (then index), distances are optional, returns the count found
+  palette_size_t k_nearest(rgb24_t color, palette_size_t k, palette_size_t* indexes, uint32_t* distances = nullptr) const;
+  // Color indexes within squared distance radius_sq, stores up to max_count and returns the total count
+  palette_size_t radius_search(rgb24_t color, uint32_t radius_sq, palette_size_t* indexes, palette_size_t max_count) const;
+  // Index of the nearest color with a metric (perceptual metrics compare against the cached CIELAB or OKLab colors)
+  palette_size_t nearest_index(rgb24_t color, color_metric_t metric, const color_weights_t& weights = COLOR_WEIGHTS_EUCLIDEAN) const;
+
+  // Name the colors (names[i] names color i, not copied, names must outlive the palette), nullptr removes the names
+  void set_names(const char* const* names);
+  // Color names (nullptr if the palette has no names)
+  const char* const* names() const { return name_list; }
+  // Index of a color by name (case insensitive, lowest index on duplicates), PALETTE_NOT_FOUND if missing
+  palette_size_t find_name(const char* name) const;
+  // Index of a color by exact value (lowest index on duplicates), PALETTE_NOT_FOUND if missing
+  palette_size_t find_color(rgb24_t color) const;
+
+  // Colors converted to CIELAB on first use (nullptr if allocation fails or over the memory budget)
+  const lab_t* lab_colors() const;
+  // Colors converted to OKLab on first use (nullptr if allocation fails or over the memory budget)
+  const oklab_t* oklab_colors() const;
+  // Colors packed to RGB565 on first use (nullptr if allocation fails or over the memory budget)
+  const uint16_t* rgb565_colors() const;
+  // Color indexes sorted by luminance then index on first use (nullptr if allocation fails or over the memory budget)
+  const palette_size_t* luminance_order() const;
+
+  // Index of the nearest color to a RGB565 color compared in RGB565 space (same order as the RGB565 color list functions, inverse colormap if built)
+  palette_size_t nearest_index_rgb565(rgb16_t color) const;
+  // Index of the color with the nearest luminance (lowest luminance then index on ties, PALETTE_NOT_FOUND if empty)
+  palette_size_t nearest_luminance(uint8_t luminance) const;
+  // RGB565 color of each palette index in src (indexed frame buffers to display lines)
+  void expand_rgb565(const uint8_t* src, uint16_t* dst, size_t n) const;
+
+  // Build the structures selected in index_flags now instead of on first use
+  bool build_index(uint8_t index_flags);
+  // Release every search structure, the lookup indexes and the color caches
+  void clear_index();
+  // Limit the heap memory of the search structures and caches (bytes, PALETTE_BUDGET_UNLIMITED by default)
+  void set_memory_budget(size_t bytes);
+  // Memory budget (bytes)
+  size_t memory_budget() const { return budget; }
+
+  // Inverse colormap (empty until built)
+  const palette_lut565_t& lut565() const { return lut; }
+  // Candidate grid (empty until built)
+  const palette_grid_t& grid() const { return cells; }
+  // k-d tree (empty until built)
+  const palette_kdtree_t& kdtree() const { return tree; }
+  // Time spent building the search structures (microseconds)
+  uint32_t index_build_time_us() const { return lut.build_time_us() + cells.build_time_us() + tree.build_time_us(); }
+  // Heap memory owned by the search structures, the lookup indexes and the color caches (bytes)
+  size_t index_memory_usage() const;
+  // Heap memory owned by the palette (bytes, the caches and the copy of the colors)
+  size_t memory_usage() const { return index_memory_usage() + (owned != nullptr ? (size_t)count * sizeof(rgb24_t) : 0); }
+
+private:
+  // Build the selected structures that are not built yet (called on first use)
+  void ensure_index() const;
+  // Memory of a new cache fits in the budget
+  bool fits(size_t bytes) const { return bytes <= budget && index_memory_usage() <= budget - bytes; }
+  // Allocate a cache of count entries if it fits in the budget (nullptr otherwise)
+  void* allocate_cache(size_t entry_size) const;
+
+  const rgb24_t* list;
+  rgb24_t* owned; // copy of the colors after the first change, nullptr until then
+  palette_size_t count;
+  size_t budget;
+  uint8_t selected_index; // structures selected at construction or built with build_index
+  mutable uint8_t pending_index; // selected structures not built yet
+  mutable palette_lut565_t lut;
+  mutable palette_grid_t cells;
+  mutable palette_kdtree_t tree;
+  const char* const* name_list;
+  mutable palette_size_t* name_order; // color indexes sorted by name then index, nullptr until used
+  mutable palette_size_t* value_order; // color indexes sorted by value then index, nullptr until used
+  mutable lab_t* lab; // CIELAB colors, nullptr until used
+  mutable oklab_t* oklab; // OKLab colors, nullptr until used
+  mutable uint16_t* packed565; // RGB565 colors, nullptr until used
+  mutable palette_size_t* luminance_index; // color indexes sorted by luminance then index, nullptr until used
+};
+
+/* PALETTE FUNCTIONS */
+
+// Index of the nearest color in colors by linear search (squared euclidean distance in RGB888, first index on ties)
+palette_size_t nearest_color_index(rgb24_t color, const rgb24_t* colors, palette_size_t size);
+
+// k nearest palette indexes of each query sorted by distance (then index), results of query q are at [q * k, q * k + k)
+// Queries share each pass over the palette in blocks of 16, repeated queries reuse the results of the first one
+// Perceptual metrics use the cached CIELAB or OKLab palette colors (converted per pass if they do not fit in the memory budget)
+// Distances are optional, returns the results per query (k or the palette size if smaller, 0 if allocation fails)
+palette_size_t top_k(const rgb24_t* queries, size_t n, const palette_t& palette, palette_size_t k, palette_size_t* indexes, uint32_t* distances = nullptr, color_metric_t metric = COLOR_METRIC_EUCLIDEAN, const color_weights_t& weights = COLOR_WEIGHTS_EUCLIDEAN);
+
+// Most similar palette color with a metric (named if the palette is over the COLORS list)
+rgb888_t get_similar_color888(const rgb888_t& rgb888, const palette_t& palette, color_metric_t metric = COLOR_METRIC_EUCLIDEAN);
+// Most similar palette color to a RGB565 color with a metric (Euclidean in RGB565 space as over a list, the others expanded to RGB888)
+rgb565_t get_similar_color565(const rgb565_t& rgb565, const palette_t& palette, color_metric_t metric = COLOR_METRIC_EUCLIDEAN);
+// Palette color by name (case insensitive, empty color if missing)
+rgb888_t get_color_by_name(const char* name, const palette_t& palette);
+// Palette color by hex color code (empty color if missing)
+rgb888_t get_color_by_hex(int hex_color_code, const palette_t& palette);
+
+#endif
@@ -0,0 +1,107 @@
+// ColorsParallel.h
+
+// Creator: JDFraire-P
+
+// Description: Multi-threaded tiled image conversion engine for host tooling (RGB888 to RGB565 or packed palette indexes)
+
+/*  Tiled pipeline
+1. Each image is split in bands of full rows of about tile_bytes source bytes (a multiple of 8 rows, so Bayer patterns line up across bands).
+2. Each band runs the pipeline row by row through a scratch row: gamma table -> dithering or palette mapping -> packing (RGB565 byte order or 1/2/4/8-bit indexes).
+3. Error diffusion carries errors from row to row, so with DITHER_FLOYD_STEINBERG and DITHER_ATKINSON each image is a single task (parallel across the images of a batch).
+4. Every task writes its own output rows, so the result does not depend on the number of threads or on which thread runs a task.
+The output is identical to the single-threaded library functions (convert_rgb888_to_rgb565, dither_rgb888_to_rgb565 and dither_rgb888_to_palette on the gamma corrected image).
+*/
+
+/*  Work stealing
+1. The tasks of a batch are split in contiguous ranges, one per worker, so each worker walks neighbouring bands.
+2. A worker takes tasks from the front of its own range, when it is empty it steals the back half of the largest range left.
+3. Tasks are never created while the batch runs, a worker stops when every range is empty.
+*/
+
+#ifndef COLORSPARALLEL_H
+#define COLORSPARALLEL_H
+
+// Libraries
+#include <ColorsUtils.h>
+#include <ColorsPalette.h>
+#include <ColorsDither.h>
+
+// Threads are only available on host builds
+#if !defined(ARDUINO)
+
+/* IMAGE JOBS */
+
+// One image of a batch
+struct image_job_t{
+  const rgb24_t* src; // RGB888 pixels
+  size_t src_stride; // pixels per source row (0: width)
+  void* dst; // RGB565 words (uint16_t) or packed palette indexes (uint8_t)
+  size_t dst_stride; // bytes per output row (0: rows packed without padding, index rows rounded up to whole bytes)
+  size_t width;
+  size_t height;
+};
+
+/* CONVERSION ENGINE */
+
+// Default source bytes of a band (fits the L2 cache of a core with its output)
+#define IMAGE_TILE_BYTES 65536UL
+
+// Parallel image converter, configure the pipeline and then convert images or batches
+class image_converter_t{
+public:
+  // Converter with threads workers (0: one per hardware thread)
+  image_converter_t(unsigned threads = 0);
+  ~image_converter_t();
+  image_converter_t(const image_converter_t&) = delete;
+  image_converter_t& operator=(const image_converter_t&) = delete;
+
+  // Apply a channel table of 256 entries before quantization (copied, nullptr removes it)
+  void set_gamma_lut(const uint8_t* lut);
+  // Apply a power law to the channels before quantization (out = 255 * (in / 255) ^ gamma, 1.0 removes it)
+  void set_gamma(float gamma);
+  // Quantize to RGB565 words (default), big_endian swaps the bytes of each word
+  void set_rgb565(bool big_endian = false);
+  // Map to palette indexes (palettes of up to 256 colors, the palette must outlive the conversions), packed index_bits per index (1, 2, 4 or 8, first pixel in the high bits)
+  void set_palette(const palette_t* palette, uint8_t index_bits = 8);
+  // Dithering method (DITHER_NONE by default)
+  void set_dither(dither_method_t method);
+  // Source bytes of a band (rounded to a multiple of 8 rows)
+  void set_tile_bytes(size_t bytes);
+
+  // Convert count images, false if the pipeline is invalid (palette too large, bad index_bits) or a line buffer cannot be allocated
+  bool convert(const image_job_t* jobs, size_t count);
+  // Convert one image
+  bool convert(const image_job_t& job) { return convert(&job, 1); }
+
+  // Worker threads
+  unsigned threads() const { return workers; }
+  // Tasks (bands or images) of the last conversion
+  size_t last_task_count() const { return task_count; }
+  // Tasks taken from another worker in the last conversion
+  size_t last_steal_count() const { return steal_count; }
+
+private:
+  struct task_t;
+  struct worker_t;
+
+  // Run the pipeline on rows [first, last) of a job with the scratch buffers of a worker, false if a line buffer cannot be allocated
+  bool run_task(const task_t& task, worker_t& worker) const;
+  // Take the next task of worker (own range first, then stealing), false when every range is empty
+  bool next_task(worker_t* all, unsigned index, size_t& task);
+  // Rows of a band of a width pixels wide image
+  size_t band_rows(size_t width) const;
+
+  unsigned workers;
+  uint8_t* gamma; // 256 entry table, nullptr if none
+  const palette_t* palette; // nullptr for RGB565 output
+  uint8_t index_bits;
+  bool big_endian;
+  dither_method_t method;
+  size_t tile_bytes;
+  size_t task_count;
+  size_t steal_count;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+// ColorsQuantize.h
+
+// Creator: JDFraire-P
+
+// Description: Palette generation from streamed pixels (histogram, median cut and k-means refinement)
+
+/*  Histogram
+1. Drop the low bits of each channel (5 bits per channel by default, a 15-bit bucket space) and count the pixels of each bucket.
+2. Pixels are added in chunks of any size, memory is bounded by the bucket space (4 bytes per bucket) and not by the image size.
+3. AVR boards (16-bit size_t, a few KiB of RAM) refuse histograms over 13 bits in total and the RAM limits them further:
+   3/3/3 (2 KiB) or 3/4/3 (4 KiB) on a Nano Every, the default 5/5/5 (128 KiB) and 5/6/5 (256 KiB) need a 32-bit board.
+*/
+
+/*  Median cut
+1. Put every non-empty bucket in one box.
+2. Pick the box with the largest pixel count times its longest channel range, and split it at the pixel median of that channel.
+3. Repeat until there are as many boxes as colors requested (or no box can be split), each palette color is the pixel weighted mean of its box.
+*/
+
+/*  k-means refinement
+1. Assign each non-empty bucket to its nearest palette color (the palette grid keeps this fast).
+2. Move each palette color to the pixel weighted mean of its buckets, colors without buckets stay where they are.
+3. Repeat for the requested iterations or until no color moves.
+*/
+
+#ifndef COLORSQUANTIZE_H
+#define COLORSQUANTIZE_H
+
+// Libraries
+#include <ColorsUtils.h>
+#include <ColorsPalette.h>
+
+/* QUANTIZER */
+
+struct quantizer_box_t;
+
+// Color histogram of streamed pixels that builds optimized palettes
+class quantizer_t{
+public:
+  // Histogram with red_bits, green_bits and blue_bits per channel (1 to 6 bits each, 5/5/5 is a 15-bit space and 5/6/5 the RGB565 space)
+  quantizer_t(uint8_t red_bits = 5, uint8_t green_bits = 5, uint8_t blue_bits = 5);
+  ~quantizer_t();
+  quantizer_t(const quantizer_t&) = delete;
+  quantizer_t& operator=(const quantizer_t&) = delete;
+
+  // Histogram is allocated (false if allocation fails or the bucket space does not fit in size_t)
+  bool ready() const { return counts != nullptr; }
+
+  // Add n RGB888 pixels
+  void add(const rgb24_t* pixels, size_t n);
+  // Add n RGB565 pixels
+  void add(const uint16_t* pixels, size_t n, bool big_endian = false);
+  // Remove every pixel
+  void clear();
+
+  // Pixels added
+  uint32_t pixel_count() const { return pixels_added; }
+  // Buckets with at least one pixel
+  uint32_t color_count() const;
+
+  // Build a palette of up to max_colors colors in colors (median cut, then k-means iterations), returns the colors built (0 if allocation fails)
+  palette_size_t build(rgb24_t* colors, palette_size_t max_colors, uint8_t kmeans_iterations = 0) const;
+
+  // Heap memory owned by the histogram (bytes)
+  size_t memory_usage() const { return ready() ? (size_t)bucket_count() * sizeof(uint32_t) : 0; }
+
+private:
+  // Number of buckets
+  uint32_t bucket_count() const { return (uint32_t)1 << (bits[0] + bits[1] + bits[2]); }
+  // Bucket of a RGB888 color
+  uint32_t bucket(rgb24_t color) const;
+  // Channel value (0 to 255) of a bucket, channel 0 red, 1 green, 2 blue
+  uint8_t bucket_channel(uint32_t bucket, uint8_t channel) const;
+  // Bucket center color
+  rgb24_t bucket_color(uint32_t bucket) const { return rgb24_t(bucket_channel(bucket, 0), bucket_channel(bucket, 1), bucket_channel(bucket, 2)); }
+  // Pixel count and channel ranges of a median cut box
+  void measure_box(quantizer_box_t& box, const uint32_t* buckets) const;
+  // Move each color to the weighted mean of its nearest buckets, false if no color moved or allocation fails
+  bool kmeans_step(const uint32_t* buckets, uint32_t size, rgb24_t* colors, palette_size_t count) const;
+
+  uint32_t* counts; // pixels of each bucket
+  uint8_t bits[3];
+  uint32_t pixels_added;
+};
+
+#endif
@@ -0,0 +1,128 @@
+// ColorsStats.h
+
+// Creator: JDFraire-P
+
+// Description: Opt-in instrumentation of the library hot paths (calls, elements, entries scanned, cache hits and misses, String allocations, time)
+
+/*  Instrumentation
+1. Off by default: define COLORSUTILS_STATS=1 for the library and the sketch (PlatformIO build_flags = -DCOLORSUTILS_STATS=1,
+   host builds: cmake -DCOLORSUTILS_STATS=ON). When it is off every COLORS_STATS_* macro expands to nothing, no counter is stored
+   and colors_stats() returns zeros, so production builds without it run the same code as before.
+2. Counters are kept per function family: conversions, similarity searches, lookups by name or value, String based APIs and palette caches.
+   The library calls count as calls, the pixels or colors they process as elements and the palette or list entries compared in linear
+   scans as entries.
+3. Hits and misses: a similarity query answered by a search structure (RGB565 inverse colormap, grid, k-d tree) or a lookup answered by a
+   sorted index is a hit, a query that falls back to a linear scan is a miss. For the palette family a cache reused is a hit and a cache
+   built (or that cannot be built) is a miss.
+4. Time is measured only around the outermost instrumented call of each thread (nested calls are counted but their time belongs to the
+   caller): micros() by default (4 us resolution on AVR), CPU cycles on ESP32 and ESP8266 with COLORSUTILS_STATS_CYCLES.
+5. Counters are updated with relaxed atomic additions (plain additions on AVR), so parallel conversions keep exact counts.
+*/
+
+#ifndef COLORSSTATS_H
+#define COLORSSTATS_H
+
+// Libraries
+#include <Arduino.h>
+
+#ifndef COLORSUTILS_STATS
+#define COLORSUTILS_STATS 0
+#endif
+
+/* STATS TYPES */
+
+// Function families
+enum colors_stats_family_t{
+  COLORS_STATS_CONVERSION, // bulk and struct conversions (RGB888, RGB565, CIELAB, OKLab, corrected and palette expansions)
+  COLORS_STATS_SIMILARITY, // color_similarity, get_similar_color* and palette nearest color queries
+  COLORS_STATS_LOOKUP, // colors by name or by value (color lists, named colors, palettes)
+  COLORS_STATS_STRING, // color structs with String names and String formatters
+  COLORS_STATS_PALETTE, // palette search structures and caches
+  COLORS_STATS_FAMILIES
+};
+
+// Counters of a family
+enum colors_stats_counter_t{
+  COLORS_STATS_CALLS,
+  COLORS_STATS_ELEMENTS,
+  COLORS_STATS_ENTRIES,
+  COLORS_STATS_HITS,
+  COLORS_STATS_MISSES,
+  COLORS_STATS_ALLOCATIONS,
+  COLORS_STATS_TIME,
+  COLORS_STATS_COUNTERS
+};
+
+// Counter values (64-bit on 64-bit hosts, 32-bit on boards)
+#if UINTPTR_MAX > 0xFFFFFFFFUL
+typedef uint64_t colors_stats_count_t;
+#else
+typedef uint32_t colors_stats_count_t;
+#endif
+
+// Counters of a family
+struct colors_stats_t{
+  colors_stats_count_t calls; // library calls
+  colors_stats_count_t elements; // pixels or colors processed
+  colors_stats_count_t entries; // palette or list entries compared in linear scans
+  colors_stats_count_t hits; // queries answered by a lookup table, search structure or cache
+  colors_stats_count_t misses; // linear scan fallbacks and caches built
+  colors_stats_count_t allocations; // heap allocations of String names and String results
+  colors_stats_count_t time; // time in the outermost calls (colors_stats_time_unit())
+};
+
+// Line writer of colors_stats_dump (one line without line ending per call)
+typedef void (*colors_stats_writer_t)(const char* line, void* context);
+
+/* STATS FUNCTIONS */
+
+// Instrumentation is compiled in
+constexpr bool colors_stats_enabled(){ return COLORSUTILS_STATS != 0; }
+
+// Counters of a family (zeros if the instrumentation is off)
+colors_stats_t colors_stats(colors_stats_family_t family);
+// Clear every counter
+void colors_stats_reset();
+// Name of a family ("conversion", "similarity", ...)
+const char* colors_stats_family_name(colors_stats_family_t family);
+// Unit of the time counters ("us" or "cycles")
+const char* colors_stats_time_unit();
+// Write the counters of the families with calls, one line per family
+void colors_stats_dump(colors_stats_writer_t writer, void* context = nullptr);
+// Write the counters to Serial or any Print output
+void colors_stats_dump(Print& out);
+
+/* INSTRUMENTATION (library internal) */
+
+#if COLORSUTILS_STATS
+
+// Add n to a counter of a family
+void colors_stats_add(colors_stats_family_t family, colors_stats_counter_t counter, colors_stats_count_t n);
+
+// Counts a call and its elements, and times it if it is the outermost instrumented call of the thread
+class colors_stats_scope_t{
+public:
+  colors_stats_scope_t(colors_stats_family_t family, colors_stats_count_t elements);
+  ~colors_stats_scope_t();
+  colors_stats_scope_t(const colors_stats_scope_t&) = delete;
+  colors_stats_scope_t& operator=(const colors_stats_scope_t&) = delete;
+
+private:
+  colors_stats_family_t family;
+  bool outermost;
+  uint32_t start;
+};
+
+#define COLORS_STATS_SCOPE(family, elements) colors_stats_scope_t colors_stats_scope((family), (colors_stats_count_t)(elements))
+#define COLORS_STATS_CALL(family, elements) (colors_stats_add((family), COLORS_STATS_CALLS, 1), colors_stats_add((family), COLORS_STATS_ELEMENTS, (colors_stats_count_t)(elements)))
+#define COLORS_STATS_COUNT(family, counter, n) colors_stats_add((family), (counter), (colors_stats_count_t)(n))
+
+#else
+
+#define COLORS_STATS_SCOPE(family, elements) ((void)0)
+#define COLORS_STATS_CALL(family, elements) ((void)0)
+#define COLORS_STATS_COUNT(family, counter, n) ((void)0)
+
+#endif
+
+#endif
@@ -31,9 +31,85 @@
 // Libraries
 #include <Arduino.h>
 
+/* PACKED COLOR TYPES */
+
+// Packed 24-bit RGB888 color type (3 bytes, trivially copyable, no name)
+struct rgb24_t{
+  uint8_t red; // 8 bits
+  uint8_t green; // 8 bits
+  uint8_t blue; // 8 bits
+
+  // default constructor (trivial, use rgb24_t{} for black)
+  rgb24_t() = default;
+  // Constructor with 3 arguments (red, green, blue) as arguments (0 to 255)
+  constexpr rgb24_t(uint8_t red, uint8_t green, uint8_t blue) : red(red), green(green), blue(blue) {}
+  // Constructor with 6 digits hex color code as argument (0x000000 to 0xFFFFFF)
+  constexpr explicit rgb24_t(uint32_t hex_color_code) : red((uint8_t)(hex_color_code >> 16)), green((uint8_t)(hex_color_code >> 8)), blue((uint8_t)hex_color_code) {}
+
+  // 24-bit hex color code (0xRRGGBB)
+  constexpr uint32_t value() const { return ((uint32_t)red << 16) | ((uint32_t)green << 8) | (uint32_t)blue; }
+};
+
+// Packed 16-bit RGB565 color type (2 bytes, trivially copyable, no name)
+struct rgb16_t{
+  uint16_t value; // RRRRRGGGGGGBBBBB
+
+  // default constructor (trivial, use rgb16_t{} for black)
+  rgb16_t() = default;
+  // Constructor with 4 digits hex color code as argument (0x0000 to 0xFFFF)
+  constexpr explicit rgb16_t(uint16_t hex_color_code) : value(hex_color_code) {}
+  // Constructor with 3 arguments (red 0 to 31, green 0 to 63, blue 0 to 31) as arguments
+  constexpr rgb16_t(uint8_t red, uint8_t green, uint8_t blue) : value((uint16_t)(((uint16_t)(red & 0x1F) << 11) | ((uint16_t)(green & 0x3F) << 5) | (uint16_t)(blue & 0x1F))) {}
+
+  constexpr uint8_t red() const { return (uint8_t)(value >> 11) & 0x1F; } // 5 bits
+  constexpr uint8_t green() const { return (uint8_t)(value >> 5) & 0x3F; } // 6 bits
+  constexpr uint8_t blue() const { return (uint8_t)value & 0x1F; } // 5 bits
+};
+
+static_assert(sizeof(rgb24_t) == 3, "rgb24_t must be 3 bytes");
+static_assert(sizeof(rgb16_t) == 2, "rgb16_t must be 2 bytes");
+
+/* PACKED COLOR CONVERSION FUNCTIONS */
+
+// Channel scaling uses exact multiply-shift forms of the rounded division (16-bit intermediates, no division)
+// Scale an 8-bit channel to 5 bits, rounded to nearest (same result as round(c / 255.0 * 31.0))
+constexpr uint8_t channel8_to_5(uint8_t channel){ return (uint8_t)(((uint16_t)channel * 249 + 1014) >> 11); }
+// Scale an 8-bit channel to 6 bits, rounded to nearest (same result as round(c / 255.0 * 63.0))
+constexpr uint8_t channel8_to_6(uint8_t channel){ return (uint8_t)(((uint16_t)channel * 253 + 505) >> 10); }
+// Scale a 5-bit channel to 8 bits, rounded to nearest (same result as round(c / 31.0 * 255.0))
+constexpr uint8_t channel5_to_8(uint8_t channel){ return (uint8_t)(((uint16_t)channel * 527 + 23) >> 6); }
+// Scale a 6-bit channel to 8 bits, rounded to nearest (same result as round(c / 63.0 * 255.0))
+constexpr uint8_t channel6_to_8(uint8_t channel){ return (uint8_t)(((uint16_t)channel * 259 + 33) >> 6); }
+
+// Convert packed 24-bit RGB888 to packed 16-bit RGB565
+constexpr rgb16_t rgb888_to_rgb565(rgb24_t rgb888){
+  return rgb16_t(channel8_to_5(rgb888.red), channel8_to_6(rgb888.green), channel8_to_5(rgb888.blue));
+}
+// Convert packed 16-bit RGB565 to packed 24-bit RGB888
+constexpr rgb24_t rgb565_to_rgb888(rgb16_t rgb565){
+  return rgb24_t(channel5_to_8(rgb565.red()), channel6_to_8(rgb565.green()), channel5_to_8(rgb565.blue()));
+}
+
+/* BULK CONVERSION FUNCTIONS */
+// Framebuffer conversions of n pixels, bit-identical to rgb888_to_rgb565 and rgb565_to_rgb888
+// big_endian: RGB565 words are byte swapped (most significant byte first in memory, as SPI displays expect)
+// On hosts with SSE2/AVX2 or NEON the spans run on vector kernels selected at runtime
+
+// Name of the vector backend used by the bulk conversion functions ("scalar", "sse2", "avx2" or "neon")
+const char* get_conversion_backend();
+
+// Convert interleaved RGB888 pixels (3 bytes per pixel, red first) to RGB565
+void convert_rgb888_to_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian = false);
+// Convert packed RGB888 pixels (0x00RRGGBB, upper byte ignored) to RGB565
+void convert_rgb888_to_rgb565(const uint32_t* src, uint16_t* dst, size_t n, bool big_endian = false);
+// Convert RGB565 pixels to interleaved RGB888 (3 bytes per pixel, red first)
+void convert_rgb565_to_rgb888(const uint16_t* src, uint8_t* dst, size_t n, bool big_endian = false);
+// Convert RGB565 pixels to packed RGB888 (0x00RRGGBB)
+void convert_rgb565_to_rgb888(const uint16_t* src, uint32_t* dst, size_t n, bool big_endian = false);
+
 /* COLORS STRUCTS */
 
-// 24-bit RGB888 color type
+// 24-bit RGB888 color type (named compatibility wrapper of rgb24_t)
 struct rgb888_t{
   uint32_t value; // 24 bits
   String name; // Color name (if is provided)
@@ -55,9 +131,16 @@ struct rgb888_t{
   rgb888_t(const char* name, uint32_t hex_color_code);
   // Constructor with 4 arguments (name, red, green, blue) as arguments
   rgb888_t(const char* name, uint8_t red, uint8_t green, uint8_t blue);
+
+  // PACKED COLOR INTEROPERABILITY
+
+  // Constructor with packed color as argument
+  rgb888_t(rgb24_t color);
+  // Packed color (without name)
+  operator rgb24_t() const { return rgb24_t(red, green, blue); }
 };
 
-// 16-bit RGB565 color type
+// 16-bit RGB565 color type (named compatibility wrapper of rgb16_t)
 struct rgb565_t{
   uint16_t value; // 16 bits
   String name; // Color name (if is provided)
@@ -80,45 +163,170 @@ struct rgb565_t{
   // Constructor with 4 arguments (name, red, green, blue) as arguments
   rgb565_t(const char* name, uint8_t red, uint8_t green, uint8_t blue);
 
+  // PACKED COLOR INTEROPERABILITY
+
+  // Constructor with packed color as argument
+  rgb565_t(rgb16_t color);
+  // Packed color (without name)
+  operator rgb16_t() const { return rgb16_t(red, green, blue); }
 };
 
 /* COLOR CONVERSION FUNCTIONS */
 
 // Convert 24-bit RGB888 to 16-bit RGB565
-rgb565_t rgb888_to_rgb565(rgb888_t rgb888);
+rgb565_t rgb888_to_rgb565(const rgb888_t& rgb888);
 // Convert 16-bit RGB565 to 24-bit RGB888
-rgb888_t rgb565_to_rgb888(rgb565_t rgb565);
+rgb888_t rgb565_to_rgb888(const rgb565_t& rgb565);
 // Convert 24-bit RGB888 to String hex color code
-String rgb888_to_String(rgb888_t rgb888);
+String rgb888_to_String(const rgb888_t& rgb888);
 // Convert 16-bit RGB565 to String hex color code
-String rgb565_to_String(rgb565_t rgb565);
+String rgb565_to_String(const rgb565_t& rgb565);
+
+/* COLOR STRING FUNCTIONS */
+// Formatters write into a caller buffer (no allocation), hex digits are lower case as in rgb888_to_String
 
+// Size of a color string buffer (longest format "0xrrggbb" plus terminator)
+#define COLOR_STRING_SIZE 9
+
+// Text formats of a RGB888 color
+enum color_format_t : uint8_t{
+  COLOR_FORMAT_HEX, // 0xrrggbb
+  COLOR_FORMAT_CSS, // #rrggbb
+  COLOR_FORMAT_CSS_SHORT // #rgb, each channel rounded to the nearest multiple of 17
+};
+
+// Write a RGB888 color into buffer, returns the text length (0 and an empty string if the buffer is too small)
+size_t format_color(rgb24_t color, char* buffer, size_t size, color_format_t format = COLOR_FORMAT_HEX);
+// Write a RGB565 color as its 4 digits word (0xrrrr) into buffer, returns the text length (0 and an empty string if the buffer is too small)
+size_t format_color(rgb16_t color, char* buffer, size_t size);
+
+// Parse a color string of length characters (surrounding spaces ignored): #rgb, #rrggbb, 0xrrggbb, rgb(r, g, b) or a name of the COLORS list, false if invalid
+bool parse_color(const char* text, size_t length, rgb24_t* color);
+// Parse a null terminated color string
+bool parse_color(const char* text, rgb24_t* color);
+// Parse a RGB565 word string of length characters (0xrrrr, surrounding spaces ignored), false if invalid
+bool parse_color(const char* text, size_t length, rgb16_t* color);
+
+// Parse a buffer of color strings separated by commas or new lines (commas inside rgb() do not separate, empty entries are skipped)
+// Invalid entries are stored as black and counted in invalid (optional), returns the colors stored (up to max_count)
+// On hosts with SSE2 or NEON runs of compact #rrggbb entries ("#rrggbb,#rrggbb\n...") are parsed two at a time by a vector kernel
+size_t parse_colors(const char* text, size_t length, rgb24_t* colors, size_t max_count, size_t* invalid = nullptr);
+
+
+/* COLOR DISTANCE FUNCTIONS */
+// Integer squared distances rank colors like color_similarity without float math (pow and sqrt are soft-float calls on AVR)
+
+// Channel weights of weighted distances, Q8 fixed point (256 = 1.0, up to 4096 = 16.0)
+struct color_weights_t{
+  uint16_t red;
+  uint16_t green;
+  uint16_t blue;
+};
+
+// Unweighted (euclidean) channel weights
+constexpr color_weights_t COLOR_WEIGHTS_EUCLIDEAN = {256, 256, 256};
+// Common 2:4:3 perceptual approximation channel weights
+constexpr color_weights_t COLOR_WEIGHTS_243 = {512, 1024, 768};
+
+// Distance metric of distance functions and searches
+enum color_metric_t : uint8_t{
+  COLOR_METRIC_EUCLIDEAN, // squared euclidean distance in RGB888
+  COLOR_METRIC_WEIGHTED, // squared euclidean distance with channel weights (Q8 result)
+  COLOR_METRIC_REDMEAN, // "redmean" weighted distance, red and blue weights follow the mean red (Q8 result)
+  COLOR_METRIC_CIE76, // squared delta E 1976 in CIELAB (hundredths squared, palette searches only, see ColorsLab.h)
+  COLOR_METRIC_CIEDE2000, // squared delta E 2000 in CIELAB (hundredths squared, palette searches only, see ColorsLab.h)
+  COLOR_METRIC_OKLAB // squared euclidean distance in OKLab (ten-thousandths squared, palette searches only, see ColorsLab.h)
+};
+
+// Squared euclidean distance between two RGB888 colors (0 to 195075)
+constexpr uint32_t color_distance_sq(rgb24_t color_1, rgb24_t color_2){
+  return (uint32_t)(((int32_t)color_1.red - color_2.red) * ((int32_t)color_1.red - color_2.red))
+       + (uint32_t)(((int32_t)color_1.green - color_2.green) * ((int32_t)color_1.green - color_2.green))
+       + (uint32_t)(((int32_t)color_1.blue - color_2.blue) * ((int32_t)color_1.blue - color_2.blue));
+}
+// Squared euclidean distance between two RGB565 colors in RGB565 channel units (0 to 5891)
+constexpr uint16_t color_distance_sq(rgb16_t color_1, rgb16_t color_2){
+  return (uint16_t)(((int16_t)color_1.red() - color_2.red()) * ((int16_t)color_1.red() - color_2.red())
+       + ((int16_t)color_1.green() - color_2.green()) * ((int16_t)color_1.green() - color_2.green())
+       + ((int16_t)color_1.blue() - color_2.blue()) * ((int16_t)color_1.blue() - color_2.blue()));
+}
+// Weighted squared distance between two RGB888 colors, (w_r * dr^2 + w_g * dg^2 + w_b * db^2) / 256
+constexpr uint32_t color_distance_sq(rgb24_t color_1, rgb24_t color_2, const color_weights_t& weights){
+  return ((uint32_t)weights.red * (uint32_t)(((int32_t)color_1.red - color_2.red) * ((int32_t)color_1.red - color_2.red))
+        + (uint32_t)weights.green * (uint32_t)(((int32_t)color_1.green - color_2.green) * ((int32_t)color_1.green - color_2.green))
+        + (uint32_t)weights.blue * (uint32_t)(((int32_t)color_1.blue - color_2.blue) * ((int32_t)color_1.blue - color_2.blue))) >> 8;
+}
+// Redmean squared distance between two RGB888 colors, ((512 + r) * dr^2 + 1024 * dg^2 + (767 - r) * db^2) / 256 with r the mean red
+constexpr uint32_t color_distance_redmean_sq(rgb24_t color_1, rgb24_t color_2){
+  return color_distance_sq(color_1, color_2, color_weights_t{(uint16_t)(512 + (((uint16_t)color_1.red + color_2.red) >> 1)), 1024, (uint16_t)(767 - (((uint16_t)color_1.red + color_2.red) >> 1))});
+}
+// Squared distance between two RGB888 colors with a RGB metric (weights are used by COLOR_METRIC_WEIGHTED, perceptual metrics fall back to euclidean)
+constexpr uint32_t color_distance_sq(rgb24_t color_1, rgb24_t color_2, color_metric_t metric, const color_weights_t& weights = COLOR_WEIGHTS_EUCLIDEAN){
+  return metric == COLOR_METRIC_WEIGHTED ? color_distance_sq(color_1, color_2, weights)
+       : (metric == COLOR_METRIC_REDMEAN ? color_distance_redmean_sq(color_1, color_2) : color_distance_sq(color_1, color_2));
+}
 
 /* COMPARE COLORS FUNCTIONS */
 
 // Compare 24-bit RGB888 colors
-float color_similarity(rgb888_t rgb888_1, rgb888_t rgb888_2);
+float color_similarity(const rgb888_t& rgb888_1, const rgb888_t& rgb888_2);
 // Compare 16-bit RGB565 colors
-float color_similarity(rgb565_t rgb565_1, rgb565_t rgb565_2);
+float color_similarity(const rgb565_t& rgb565_1, const rgb565_t& rgb565_2);
 // Compare 24-bit RGB888 and 16-bit RGB565 colors
-float color_similarity(rgb888_t rgb888, rgb565_t rgb565);
+float color_similarity(const rgb888_t& rgb888, const rgb565_t& rgb565);
 // Compare 24-bit RGB888 and 16-bit RGB565 colors
-float color_similarity(rgb565_t rgb565, rgb888_t rgb888);
+float color_similarity(const rgb565_t& rgb565, const rgb888_t& rgb888);
 
 /* COLOR LIST FUNCTIONS */
 
-// Get color from color list by name
-rgb888_t get_color_by_name(const char* name, const rgb888_t* colors_list);
+// Get color from color list by name (case insensitive)
+rgb888_t get_color_by_name(const char* name, const rgb888_t* colors_list, size_t size);
 
 // Get color from color list by hex color code
-rgb888_t get_color_by_hex(int hex_color_code, const rgb888_t* colors_list);
+rgb888_t get_color_by_hex(int hex_color_code, const rgb888_t* colors_list, size_t size);
+
+// Get most similar color from color list (integer squared euclidean distance, same order as color_similarity)
+rgb888_t get_similar_color888(const rgb888_t& rgb888, const rgb888_t* colors_list, size_t size);
+
+// Get most similar color from color list (integer distance in RGB565 space, same order as color_similarity)
+rgb565_t get_similar_color565(const rgb565_t& rgb565, const rgb888_t* colors_list, size_t size);
+
+/* PACKED COLOR LIST FUNCTIONS */
+// Colors found in COLORS are returned with their name, other lists return unnamed colors
+
+// Get color from the named colors list by name (case insensitive)
+rgb888_t get_color_by_name(const char* name);
 
-// Get most similar color from color list
-rgb888_t get_similar_color888(rgb888_t rgb888, const rgb888_t* colors_list);
+// Get color from packed color list by hex color code
+rgb888_t get_color_by_hex(int hex_color_code, const rgb24_t* colors_list, size_t size);
 
-// Get most similar color from color list
-rgb565_t get_similar_color565(rgb565_t rgb565, const rgb888_t colors_list[]);
+// Get most similar color from packed color list
+rgb888_t get_similar_color888(const rgb888_t& rgb888, const rgb24_t* colors_list, size_t size);
+
+// Get most similar color from packed color list
+rgb565_t get_similar_color565(const rgb565_t& rgb565, const rgb24_t* colors_list, size_t size);
 
 /* NAMED COLORS LIST */
-extern const rgb888_t COLORS[];
+
+// Number of colors in the named colors list
+#define COLORS_COUNT 50
+// Size of a color name buffer (longest name plus terminator)
+#define COLOR_NAME_SIZE 11
+
+// Named colors, names are stored apart in COLOR_NAMES (same index)
+extern const rgb24_t COLORS[COLORS_COUNT];
+// Named colors names sorted case insensitive, read-only (PROGMEM on AVR)
+extern const char COLOR_NAMES[COLORS_COUNT][COLOR_NAME_SIZE] PROGMEM;
+
+// Index returned when a named color is not found
+#define COLOR_NOT_FOUND 0xFF
+
+// Copy the name of COLORS[index] into buffer, returns the name length (0 if index is out of range)
+size_t get_color_name(uint8_t index, char* buffer, size_t size);
+// Get COLORS[index] as a named rgb888_t
+rgb888_t get_named_color(uint8_t index);
+// Index of a named color by name (case insensitive binary search over the sorted names), COLOR_NOT_FOUND if missing
+uint8_t find_color_by_name(const char* name);
+// Index of a named color by 24-bit value (binary search over a sorted index, lowest index on duplicates), COLOR_NOT_FOUND if missing
+uint8_t find_color_by_hex(uint32_t hex_color_code);
 #endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+// ColorsBlend.cpp
+
+// Creator: JDFraire-P
+
+// Description: Alpha blending and compositing of packed RGB565 colors and spans without unpacking to RGB888
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsBlend.h>
+
+/* SPAN HELPERS */
+
+// Swap the bytes of a RGB565 word if big endian
+static inline uint16_t load565(uint16_t value, bool big_endian){
+  return big_endian ? (uint16_t)((value << 8) | (value >> 8)) : value;
+}
+
+/* SPAN FUNCTIONS */
+
+// Blend n src colors over dst with a constant 8-bit alpha
+void blend565(uint16_t* dst, const uint16_t* src, size_t n, uint8_t alpha, bool big_endian){
+  uint8_t alpha5 = alpha8_to_5(alpha);
+  if (alpha5 == 0) return;
+  if (alpha5 == 32){
+    memmove(dst, src, n * sizeof(uint16_t));
+    return;
+  }
+  for (size_t i = 0; i < n; i++){
+    uint32_t background = rgb565_spread(load565(dst[i], big_endian));
+    uint32_t foreground = rgb565_spread(load565(src[i], big_endian));
+    dst[i] = load565(rgb565_fold((((foreground - background) * alpha5) >> 5) + background), big_endian);
+  }
+}
+
+// Blend a color over n dst colors with a constant 8-bit alpha
+void blend565(uint16_t* dst, rgb16_t color, size_t n, uint8_t alpha, bool big_endian){
+  uint8_t alpha5 = alpha8_to_5(alpha);
+  if (alpha5 == 0) return;
+  uint32_t foreground = rgb565_spread(color.value);
+  for (size_t i = 0; i < n; i++){
+    uint32_t background = rgb565_spread(load565(dst[i], big_endian));
+    dst[i] = load565(rgb565_fold((((foreground - background) * alpha5) >> 5) + background), big_endian);
+  }
+}
+
+// Blend a color over n dst colors with a per pixel 8-bit alpha mask
+void blend565_mask(uint16_t* dst, const uint8_t* mask, rgb16_t color, size_t n, bool big_endian){
+  uint32_t foreground = rgb565_spread(color.value);
+  uint16_t solid = load565(color.value, big_endian);
+  for (size_t i = 0; i < n; i++){
+    // glyph masks are mostly empty or fully covered
+    uint8_t alpha5 = alpha8_to_5(mask[i]);
+    if (alpha5 == 0) continue;
+    if (alpha5 == 32){
+      dst[i] = solid;
+      continue;
+    }
+    uint32_t background = rgb565_spread(load565(dst[i], big_endian));
+    dst[i] = load565(rgb565_fold((((foreground - background) * alpha5) >> 5) + background), big_endian);
+  }
+}
+
+// Blend n RGBA8888 pixels over dst
+void blend_rgba8888_over_rgb565(uint16_t* dst, const uint8_t* src, size_t n, bool big_endian){
+  for (size_t i = 0; i < n; i++, src += 4){
+    uint8_t alpha5 = alpha8_to_5(src[3]);
+    if (alpha5 == 0) continue;
+    uint16_t color = rgb888_to_rgb565(rgb24_t(src[0], src[1], src[2])).value;
+    if (alpha5 == 32){
+      dst[i] = load565(color, big_endian);
+      continue;
+    }
+    uint32_t background = rgb565_spread(load565(dst[i], big_endian));
+    uint32_t foreground = rgb565_spread(color);
+    dst[i] = load565(rgb565_fold((((foreground - background) * alpha5) >> 5) + background), big_endian);
+  }
+}
+
+// Add n src colors to dst
+void add565(uint16_t* dst, const uint16_t* src, size_t n, bool big_endian){
+  for (size_t i = 0; i < n; i++){
+    uint32_t sum = rgb565_spread(load565(dst[i], big_endian)) + rgb565_spread(load565(src[i], big_endian));
+    dst[i] = load565(rgb565_fold(rgb565_saturate(sum)), big_endian);
+  }
+}
+
+// Multiply n dst colors by src colors
+void multiply565(uint16_t* dst, const uint16_t* src, size_t n, bool big_endian){
+  for (size_t i = 0; i < n; i++){
+    dst[i] = load565(multiply565(rgb16_t(load565(dst[i], big_endian)), rgb16_t(load565(src[i], big_endian))).value, big_endian);
+  }
+}
@@ -0,0 +1,141 @@
+// ColorsCorrection.cpp
+
+// Creator: JDFraire-P
+
+// Description: Color correction lookup tables (gamma, brightness, white point, user curves) composed at setup and fused into pixel packing
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsCorrection.h>
+#include <ColorsStats.h>
+#include "ColorsSimd.h"
+
+/* CURVE HELPERS */
+
+// Scale a channel by factor / 255, rounded to nearest (exact (x + (x >> 8) + 1) >> 8 form of x / 255)
+static inline uint8_t scale8(uint8_t channel, uint8_t factor){
+  uint16_t product = (uint16_t)((uint16_t)channel * factor + 127);
+  return (uint8_t)((product + (product >> 8) + 1) >> 8);
+}
+
+// Gamma curve of 256 entries
+static void gamma_curve(float gamma, uint8_t* curve){
+  for (uint16_t i = 0; i < 256; i++){
+    curve[i] = (uint8_t)(255.0 * pow(i / 255.0, gamma) + 0.5);
+  }
+}
+
+// Scale curve of 256 entries
+static void scale_curve(uint8_t factor, uint8_t* curve){
+  for (uint16_t i = 0; i < 256; i++){
+    curve[i] = scale8((uint8_t)i, factor);
+  }
+}
+
+/* COLOR CORRECTION */
+
+// Identity correction
+color_correction_t::color_correction_t(){
+  reset();
+}
+
+// Back to the identity
+void color_correction_t::reset(){
+  for (uint16_t i = 0; i < 256; i++){
+    tables[0][i] = tables[1][i] = tables[2][i] = (uint8_t)i;
+  }
+}
+
+// Map the table of a channel through a curve
+void color_correction_t::map(uint8_t channel, const uint8_t* curve){
+  for (uint16_t i = 0; i < 256; i++){
+    tables[channel][i] = curve[tables[channel][i]];
+  }
+}
+
+// Gamma curve on every channel
+void color_correction_t::apply_gamma(float gamma){
+  uint8_t curve[256];
+  gamma_curve(gamma, curve);
+  apply_curve(curve);
+}
+
+// Gamma curve per channel
+void color_correction_t::apply_gamma(float red_gamma, float green_gamma, float blue_gamma){
+  float gammas[3] = {red_gamma, green_gamma, blue_gamma};
+  uint8_t curve[256];
+  for (uint8_t channel = 0; channel < 3; channel++){
+    // Channels with the same gamma share the curve
+    if (channel == 0 || gammas[channel] != gammas[channel - 1]) gamma_curve(gammas[channel], curve);
+    map(channel, curve);
+  }
+}
+
+// Scale every channel by brightness / 255
+void color_correction_t::apply_brightness(uint8_t brightness){
+  uint8_t curve[256];
+  scale_curve(brightness, curve);
+  apply_curve(curve);
+}
+
+// Scale each channel by the channel of the white point / 255
+void color_correction_t::apply_white_point(rgb24_t white){
+  uint8_t factors[3] = {white.red, white.green, white.blue};
+  uint8_t curve[256];
+  for (uint8_t channel = 0; channel < 3; channel++){
+    scale_curve(factors[channel], curve);
+    map(channel, curve);
+  }
+}
+
+// User curve of 256 entries on every channel
+void color_correction_t::apply_curve(const uint8_t* curve){
+  map(0, curve);
+  map(1, curve);
+  map(2, curve);
+}
+
+// User curve of 256 entries per channel
+void color_correction_t::apply_curves(const uint8_t* red_curve, const uint8_t* green_curve, const uint8_t* blue_curve){
+  if (red_curve != nullptr) map(0, red_curve);
+  if (green_curve != nullptr) map(1, green_curve);
+  if (blue_curve != nullptr) map(2, blue_curve);
+}
+
+// User curve of 256 entries in flash on every channel
+void color_correction_t::apply_curve_P(const uint8_t* curve){
+  for (uint8_t channel = 0; channel < 3; channel++){
+    for (uint16_t i = 0; i < 256; i++){
+      tables[channel][i] = pgm_read_byte(curve + tables[channel][i]);
+    }
+  }
+}
+
+/* LOOKUP */
+
+// Correct n colors
+void color_correction_t::correct(const rgb24_t* src, rgb24_t* dst, size_t n) const{
+  for (size_t i = 0; i < n; i++){
+    dst[i] = correct(src[i]);
+  }
+}
+
+// Pixels per block of the vector path (the corrected block stays in the L1 cache)
+#define CORRECTION_BLOCK 256
+
+// Correct and pack n pixels to RGB565
+void color_correction_t::convert_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian) const{
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+#if COLORSUTILS_SIMD
+  // The vector kernels pack faster than the scalar fused loop: correct a block, then pack it from the cache
+  rgb24_t block[CORRECTION_BLOCK];
+  for (size_t i = 0; i < n; i += CORRECTION_BLOCK){
+    size_t count = n - i < CORRECTION_BLOCK ? n - i : CORRECTION_BLOCK;
+    correct((const rgb24_t*)(src + 3 * i), block, count);
+    convert_rgb888_to_rgb565((const uint8_t*)block, dst + i, count, big_endian);
+  }
+#else
+  if (big_endian) convert<format_rgb565_swapped>(src, dst, n);
+  else convert<format_rgb565>(src, dst, n);
+#endif
+}
@@ -0,0 +1,259 @@
+// ColorsDelta.cpp
+
+// Creator: JDFraire-P
+
+// Description: Dirty span and rectangle diffing of RGB565 frames and a run-length / delta codec for RGB565 line streams
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsDelta.h>
+
+/* WORD COMPARISONS */
+
+// Comparison word (4 pixels on 64-bit hosts, 2 pixels on 8 and 32-bit boards)
+#if UINTPTR_MAX > 0xFFFFFFFFUL
+typedef uint64_t diff_word_t;
+#else
+typedef uint32_t diff_word_t;
+#endif
+
+#define DIFF_WORD_PIXELS (sizeof(diff_word_t) / sizeof(uint16_t))
+
+// Leading pixels of a and b that are equal (up to n)
+static size_t equal_pixels(const uint16_t* a, const uint16_t* b, size_t n){
+  size_t i = 0;
+  for (; i + DIFF_WORD_PIXELS <= n; i += DIFF_WORD_PIXELS){
+    diff_word_t word_a, word_b;
+    memcpy(&word_a, a + i, sizeof(diff_word_t));
+    memcpy(&word_b, b + i, sizeof(diff_word_t));
+    if (word_a != word_b) break;
+  }
+  while (i < n && a[i] == b[i]) i++;
+  return i;
+}
+
+// Trailing pixels of a and b that are equal (up to n)
+static size_t equal_pixels_back(const uint16_t* a, const uint16_t* b, size_t n){
+  size_t i = n;
+  for (; i >= DIFF_WORD_PIXELS; i -= DIFF_WORD_PIXELS){
+    diff_word_t word_a, word_b;
+    memcpy(&word_a, a + i - DIFF_WORD_PIXELS, sizeof(diff_word_t));
+    memcpy(&word_b, b + i - DIFF_WORD_PIXELS, sizeof(diff_word_t));
+    if (word_a != word_b) break;
+  }
+  while (i > 0 && a[i - 1] == b[i - 1]) i--;
+  return n - i;
+}
+
+/* FRAME DIFFING */
+
+// Dirty spans between the previous and the current line of n pixels
+size_t diff565_spans(const uint16_t* previous, const uint16_t* current, size_t n, dirty_span_t* spans, size_t max_spans, uint16_t gap){
+  if (max_spans == 0) return 0;
+  size_t count = 0;
+  size_t i = equal_pixels(previous, current, n);
+  while (i < n){
+    // Dirty run from i, clean gaps of up to gap pixels are taken in
+    size_t end = i + 1;
+    size_t clean = 0;
+    while (true){
+      while (end < n && previous[end] != current[end]) end++;
+      clean = equal_pixels(previous + end, current + end, n - end);
+      if (end + clean == n || clean > gap) break;
+      end += clean;
+    }
+    if (count < max_spans) spans[count++] = {(uint16_t)i, (uint16_t)(end - i)};
+    else spans[count - 1].length = (uint16_t)(end - spans[count - 1].start); // array full, the last span covers the rest
+    i = end + clean;
+  }
+  return count;
+}
+
+// Dirty rectangles between two width x height frames
+size_t diff565_rects(const uint16_t* previous, const uint16_t* current, size_t width, size_t height, size_t stride, dirty_rect_t* rects, size_t max_rects){
+  if (stride == 0) stride = width;
+  if (max_rects == 0) return 0;
+  size_t count = 0;
+  bool open = false; // the last rectangle takes the next dirty row
+  for (size_t y = 0; y < height; y++, previous += stride, current += stride){
+    size_t left = equal_pixels(previous, current, width);
+    if (left == width){
+      open = false;
+      continue;
+    }
+    size_t right = width - equal_pixels_back(previous + left, current + left, width - left);
+    if (!open && count < max_rects){
+      rects[count++] = {(uint16_t)left, (uint16_t)y, (uint16_t)(right - left), 1};
+      open = true;
+      continue;
+    }
+    // Join the row to the last rectangle (open, or array full)
+    dirty_rect_t& rect = rects[count - 1];
+    size_t x0 = left < rect.x ? left : rect.x;
+    size_t x1 = right > (size_t)rect.x + rect.width ? right : (size_t)rect.x + rect.width;
+    rect.x = (uint16_t)x0;
+    rect.width = (uint16_t)(x1 - x0);
+    rect.height = (uint16_t)(y + 1 - rect.y);
+  }
+  return count;
+}
+
+// Bounding rectangle of the dirty pixels of two width x height frames
+bool diff565_bounds(const uint16_t* previous, const uint16_t* current, size_t width, size_t height, size_t stride, dirty_rect_t* bounds){
+  dirty_rect_t rect;
+  if (diff565_rects(previous, current, width, height, stride, &rect, 1) == 0) return false;
+  *bounds = rect;
+  return true;
+}
+
+/* RLE565 LINE CODEC */
+
+// Operations
+#define RLE565_COPY 0x00
+#define RLE565_RUN 0x40
+#define RLE565_LITERAL 0x80
+#define RLE565_LONG 0x20
+#define RLE565_MAX_COUNT 8192
+
+// Write an operation byte (and the count byte of long counts), false if it does not fit
+static inline bool put_operation(uint8_t* out, size_t size, size_t& length, uint8_t operation, size_t count){
+  count--;
+  if (count < 32){
+    if (length + 1 > size) return false;
+    out[length++] = (uint8_t)(operation | count);
+    return true;
+  }
+  if (length + 2 > size) return false;
+  out[length++] = (uint8_t)(operation | RLE565_LONG | (count >> 8));
+  out[length++] = (uint8_t)count;
+  return true;
+}
+
+// Write a color (most significant byte first)
+static inline void put_color(uint8_t* out, size_t& length, uint16_t color){
+  out[length++] = (uint8_t)(color >> 8);
+  out[length++] = (uint8_t)color;
+}
+
+// Encode a line of n pixels against a reference line
+size_t rle565_encode(const uint16_t* line, const uint16_t* reference, size_t n, uint8_t* out, size_t size){
+  size_t length = 0;
+  size_t i = 0;
+  while (i < n){
+    // COPY: 2 or more pixels equal to the reference (or the last pixel)
+    size_t count = reference != nullptr ? equal_pixels(line + i, reference + i, n - i) : 0;
+    if (count >= 2 || (count == 1 && i + 1 == n)){
+      for (size_t left = count; left > 0;){
+        size_t part = left < RLE565_MAX_COUNT ? left : RLE565_MAX_COUNT;
+        if (!put_operation(out, size, length, RLE565_COPY, part)) return 0;
+        left -= part;
+      }
+      i += count;
+      continue;
+    }
+    // RUN: 3 or more equal pixels
+    uint16_t color = line[i];
+    count = 1;
+    while (i + count < n && line[i + count] == color && count < RLE565_MAX_COUNT) count++;
+    if (count >= 3){
+      if (!put_operation(out, size, length, RLE565_RUN, count) || length + 2 > size) return 0;
+      put_color(out, length, color);
+      i += count;
+      continue;
+    }
+    // LITERAL: up to the start of a COPY or a RUN
+    size_t end = i + 1;
+    while (end < n && end - i < RLE565_MAX_COUNT){
+      if (reference != nullptr && line[end] == reference[end] && (end + 1 == n || line[end + 1] == reference[end + 1])) break;
+      if (end + 2 < n && line[end] == line[end + 1] && line[end] == line[end + 2]) break;
+      end++;
+    }
+    if (!put_operation(out, size, length, RLE565_LITERAL, end - i) || length + 2 * (end - i) > size) return 0;
+    for (; i < end; i++) put_color(out, length, line[i]);
+  }
+  return length;
+}
+
+// Decode a line of n pixels against a reference line
+size_t rle565_decode(const uint8_t* in, size_t length, const uint16_t* reference, uint16_t* line, size_t n){
+  size_t position = 0;
+  size_t i = 0;
+  while (i < n){
+    if (position >= length) return 0;
+    uint8_t operation = in[position++];
+    size_t count = operation & 0x1F;
+    if (operation & RLE565_LONG){
+      if (position >= length) return 0;
+      count = (count << 8) | in[position++];
+    }
+    count++;
+    if (count > n - i) return 0;
+    switch (operation & 0xC0){
+      case RLE565_COPY:
+        if (reference == nullptr) return 0;
+        if (reference != line) memcpy(line + i, reference + i, count * sizeof(uint16_t));
+        break;
+      case RLE565_RUN:{
+        if (position + 2 > length) return 0;
+        uint16_t color = (uint16_t)((in[position] << 8) | in[position + 1]);
+        position += 2;
+        for (size_t j = 0; j < count; j++) line[i + j] = color;
+        break;
+      }
+      case RLE565_LITERAL:
+        if (position + 2 * count > length) return 0;
+        for (size_t j = 0; j < count; j++, position += 2) line[i + j] = (uint16_t)((in[position] << 8) | in[position + 1]);
+        break;
+      default:
+        return 0;
+    }
+    i += count;
+  }
+  return position;
+}
+
+/* STREAMING ENCODER */
+
+// Encoder for lines of width pixels
+rle565_encoder_t::rle565_encoder_t(size_t width){
+  columns = width;
+  started = false;
+  history = (uint16_t*)malloc(width * sizeof(uint16_t));
+}
+
+rle565_encoder_t::~rle565_encoder_t(){
+  free(history);
+}
+
+// Encode the next line of width pixels
+size_t rle565_encoder_t::encode(const uint16_t* line, uint8_t* out, size_t size){
+  if (history == nullptr) return 0;
+  size_t length = rle565_encode(line, started ? history : nullptr, columns, out, size);
+  if (length == 0 && columns > 0) return 0;
+  memcpy(history, line, columns * sizeof(uint16_t));
+  started = true;
+  return length;
+}
+
+/* STREAMING DECODER */
+
+// Decoder for lines of width pixels
+rle565_decoder_t::rle565_decoder_t(size_t width){
+  columns = width;
+  started = false;
+  history = (uint16_t*)malloc(width * sizeof(uint16_t));
+}
+
+rle565_decoder_t::~rle565_decoder_t(){
+  free(history);
+}
+
+// Decode the next line of width pixels
+size_t rle565_decoder_t::decode(const uint8_t* in, size_t length, uint16_t* line){
+  if (history == nullptr) return 0;
+  size_t read = rle565_decode(in, length, started ? history : nullptr, line, columns);
+  if (read == 0 && columns > 0) return 0;
+  memcpy(history, line, columns * sizeof(uint16_t));
+  started = true;
+  return read;
+}
@@ -0,0 +1,241 @@
+// ColorsDither.cpp
+
+// Creator: JDFraire-P
+
+// Description: Streaming dithering of RGB888 rows to RGB565 or palette indexes with bounded line buffers
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsDither.h>
+
+/* BAYER MATRIX */
+
+// 8x8 Bayer thresholds (0 to 63), the top left 4x4 quadrant divided by 4 is the 4x4 matrix
+static const uint8_t BAYER8[8][8] PROGMEM = {
+  { 0, 32,  8, 40,  2, 34, 10, 42},
+  {48, 16, 56, 24, 50, 18, 58, 26},
+  {12, 44,  4, 36, 14, 46,  6, 38},
+  {60, 28, 52, 20, 62, 30, 54, 22},
+  { 3, 35, 11, 43,  1, 33,  9, 41},
+  {51, 19, 59, 27, 49, 17, 57, 25},
+  {15, 47,  7, 39, 13, 45,  5, 37},
+  {63, 31, 55, 23, 61, 29, 53, 21}
+};
+
+/* QUANTIZATION TARGETS */
+
+// RGB565 output
+struct dither_rgb565_target_t{
+  uint16_t* dst;
+  bool big_endian;
+
+  rgb24_t quantize(rgb24_t color, size_t x){
+    rgb16_t quantized = rgb888_to_rgb565(color);
+    dst[x] = big_endian ? (uint16_t)((quantized.value << 8) | (quantized.value >> 8)) : quantized.value;
+    return rgb565_to_rgb888(quantized);
+  }
+};
+
+// Palette index output
+struct dither_palette_target_t{
+  const palette_t& palette;
+  uint8_t* dst;
+
+  rgb24_t quantize(rgb24_t color, size_t x){
+    palette_size_t index = palette.nearest_index(color);
+    dst[x] = (uint8_t)index;
+    return palette[index];
+  }
+};
+
+// Channel plus a carried error, clamped to 0-255
+static inline uint8_t add_error(uint8_t channel, int16_t error){
+  int16_t value = (int16_t)channel + error;
+  return value < 0 ? 0 : (value > 255 ? 255 : (uint8_t)value);
+}
+
+// Ordered dithering offset of a threshold (0 to cells - 1), spread evenly over (-step / 2, step / 2)
+static inline int16_t bayer_offset(uint8_t threshold, uint8_t cells, uint8_t step){
+  return (int16_t)(((int16_t)(2 * threshold + 1 - cells) * step) / (2 * cells));
+}
+
+/* DITHERING ENGINE */
+
+dither_t::dither_t(dither_method_t method, size_t width, uint8_t spread){
+  mode = method;
+  columns = width;
+  palette_spread = spread;
+  y = 0;
+  errors = nullptr;
+  if (diffusion()){
+    errors = (int16_t*)malloc(buffer_size() * sizeof(int16_t));
+    reset();
+  }
+}
+
+dither_t::~dither_t(){
+  free(errors);
+}
+
+// Start a new frame
+void dither_t::reset(){
+  y = 0;
+  if (errors != nullptr) memset(errors, 0, buffer_size() * sizeof(int16_t));
+}
+
+// Dither the next row to RGB565
+void dither_t::row_to_rgb565(const rgb24_t* src, uint16_t* dst, bool big_endian){
+  dither_rgb565_target_t target = {dst, big_endian};
+  // one RGB565 step is about 8 (red and blue) and 4 (green) RGB888 units
+  dither_row(src, target, 8, 4, 8);
+}
+
+// Dither the next row to palette indexes
+void dither_t::row_to_palette(const rgb24_t* src, const palette_t& palette, uint8_t* dst){
+  if (palette.size() == 0){
+    memset(dst, 0, columns);
+    y++;
+    return;
+  }
+  uint8_t spread = palette_spread;
+  if (spread == 0){
+    // a palette of n colors has about cbrt(n) levels per channel
+    uint16_t levels = 1;
+    while ((uint32_t)(levels + 1) * (levels + 1) * (levels + 1) <= palette.size()) levels++;
+    spread = (uint8_t)(255 / levels);
+  }
+  dither_palette_target_t target = {palette, dst};
+  dither_row(src, target, spread, spread, spread);
+}
+
+// Dither the next row with the selected method
+template <typename TARGET>
+void dither_t::dither_row(const rgb24_t* src, TARGET& target, uint8_t step_red, uint8_t step_green, uint8_t step_blue){
+  switch (mode){
+    case DITHER_FLOYD_STEINBERG:
+      if (errors != nullptr) floyd_steinberg_row(src, target);
+      else bayer_row(src, target, 0, 0, 0);
+      break;
+    case DITHER_ATKINSON:
+      if (errors != nullptr) atkinson_row(src, target);
+      else bayer_row(src, target, 0, 0, 0);
+      break;
+    case DITHER_BAYER4:
+    case DITHER_BAYER8:
+      bayer_row(src, target, step_red, step_green, step_blue);
+      break;
+    default:
+      // zero steps turn the ordered dithering into plain quantization
+      bayer_row(src, target, 0, 0, 0);
+      break;
+  }
+  y++;
+}
+
+// Floyd-Steinberg row (one line buffer, errors in 1/16 channel units)
+template <typename TARGET>
+void dither_t::floyd_steinberg_row(const rgb24_t* src, TARGET& target){
+  // the line holds the errors of this row ahead of the current pixel and the errors of the next row behind it
+  int16_t* line = errors;
+  bool reverse = (y & 1) != 0;
+  int8_t direction = reverse ? -1 : 1;
+  int16_t carry[3] = {0, 0, 0}; // 7/16 to the next pixel of the row
+  int16_t pending[3] = {0, 0, 0}; // 1/16 below the next pixel, added once the current row error of that pixel is read
+
+  // padding pixels only collect errors that leave the row
+  memset(line, 0, 3 * sizeof(int16_t));
+  memset(line + (columns + 1) * 3, 0, 3 * sizeof(int16_t));
+
+  for (size_t i = 0; i < columns; i++){
+    size_t x = reverse ? columns - 1 - i : i;
+    int16_t* cell = line + (x + 1) * 3;
+    int16_t* behind = cell - 3 * direction;
+
+    rgb24_t color = src[x];
+    rgb24_t value(add_error(color.red, (int16_t)((cell[0] + carry[0] + 8) >> 4)),
+                  add_error(color.green, (int16_t)((cell[1] + carry[1] + 8) >> 4)),
+                  add_error(color.blue, (int16_t)((cell[2] + carry[2] + 8) >> 4)));
+    rgb24_t quantized = target.quantize(value, x);
+    int16_t error[3] = {(int16_t)(value.red - quantized.red), (int16_t)(value.green - quantized.green), (int16_t)(value.blue - quantized.blue)};
+
+    for (uint8_t c = 0; c < 3; c++){
+      behind[c] += 3 * error[c];
+      cell[c] = 5 * error[c] + pending[c];
+      pending[c] = error[c];
+      carry[c] = 7 * error[c];
+    }
+  }
+}
+
+// Atkinson row (two line buffers, errors in 1/8 channel units)
+template <typename TARGET>
+void dither_t::atkinson_row(const rgb24_t* src, TARGET& target){
+  // the current line holds the errors of this row and receives the errors two rows below, the other line gets the next row
+  size_t line_size = (columns + 2) * 3;
+  int16_t* current = errors + (y & 1) * line_size;
+  int16_t* next = errors + ((y + 1) & 1) * line_size;
+  bool reverse = (y & 1) != 0;
+  int8_t direction = reverse ? -1 : 1;
+  int16_t carry_1[3] = {0, 0, 0}; // errors to the next pixel of the row
+  int16_t carry_2[3] = {0, 0, 0}; // errors two pixels ahead
+
+  memset(next, 0, 3 * sizeof(int16_t));
+  memset(next + (columns + 1) * 3, 0, 3 * sizeof(int16_t));
+
+  for (size_t i = 0; i < columns; i++){
+    size_t x = reverse ? columns - 1 - i : i;
+    int16_t* cell = current + (x + 1) * 3;
+    int16_t* below = next + (x + 1) * 3;
+
+    rgb24_t color = src[x];
+    rgb24_t value(add_error(color.red, (int16_t)((cell[0] + carry_1[0] + 4) >> 3)),
+                  add_error(color.green, (int16_t)((cell[1] + carry_1[1] + 4) >> 3)),
+                  add_error(color.blue, (int16_t)((cell[2] + carry_1[2] + 4) >> 3)));
+    rgb24_t quantized = target.quantize(value, x);
+    int16_t error[3] = {(int16_t)(value.red - quantized.red), (int16_t)(value.green - quantized.green), (int16_t)(value.blue - quantized.blue)};
+
+    for (uint8_t c = 0; c < 3; c++){
+      carry_1[c] = carry_2[c] + error[c];
+      carry_2[c] = error[c];
+      below[c - 3 * direction] += error[c];
+      below[c] += error[c];
+      below[c + 3 * direction] += error[c];
+      cell[c] = error[c];
+    }
+  }
+}
+
+// Ordered dithering row (no buffers, zero steps give plain quantization)
+template <typename TARGET>
+void dither_t::bayer_row(const rgb24_t* src, TARGET& target, uint8_t step_red, uint8_t step_green, uint8_t step_blue){
+  uint8_t size = mode == DITHER_BAYER4 ? 4 : 8;
+  uint8_t cells = size * size;
+  uint8_t shift = mode == DITHER_BAYER4 ? 2 : 0;
+  const uint8_t* thresholds = BAYER8[y & (size - 1)];
+  for (size_t x = 0; x < columns; x++){
+    uint8_t threshold = pgm_read_byte(thresholds + (x & (size - 1))) >> shift;
+    rgb24_t color = src[x];
+    rgb24_t value(add_error(color.red, bayer_offset(threshold, cells, step_red)),
+                  add_error(color.green, bayer_offset(threshold, cells, step_green)),
+                  add_error(color.blue, bayer_offset(threshold, cells, step_blue)));
+    target.quantize(value, x);
+  }
+}
+
+/* DITHERING FUNCTIONS */
+
+// Dither a width x height RGB888 frame to RGB565
+bool dither_rgb888_to_rgb565(const rgb24_t* src, uint16_t* dst, size_t width, size_t height, dither_method_t method, bool big_endian){
+  dither_t dither(method, width);
+  if (!dither.ready()) return false;
+  for (size_t row = 0; row < height; row++) dither.row_to_rgb565(src + row * width, dst + row * width, big_endian);
+  return true;
+}
+
+// Dither a width x height RGB888 frame to palette indexes
+bool dither_rgb888_to_palette(const rgb24_t* src, uint8_t* dst, size_t width, size_t height, const palette_t& palette, dither_method_t method){
+  dither_t dither(method, width);
+  if (!dither.ready()) return false;
+  for (size_t row = 0; row < height; row++) dither.row_to_palette(src + row * width, palette, dst + row * width);
+  return true;
+}
@@ -0,0 +1,395 @@
+// ColorsGradient.cpp
+
+// Creator: JDFraire-P
+
+// Description: Fixed-point multi-stop gradients for LED strips and displays (spans, linear and radial fills, color at t)
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsGradient.h>
+#include <ColorsLab.h>
+#include <ColorsHsv.h>
+#include "ColorsLabFixed.h"
+
+/* INTERPOLATION SPACES */
+
+// Channel clamped to 0-255
+static inline uint8_t clamp8(int32_t value){
+  return value < 0 ? 0 : (value > 255 ? 255 : (uint8_t)value);
+}
+
+// Hue of any turn wrapped to 0-1535
+static inline uint16_t wrap_hue(int32_t hue){
+  while (hue < 0) hue += HUE_STEPS;
+  while (hue >= HUE_STEPS) hue -= HUE_STEPS;
+  return (uint16_t)hue;
+}
+
+// Channels (15-bit fixed point) of a space to RGB888
+template <gradient_space_t SPACE>
+static inline rgb24_t space_to_rgb(const int32_t* values){
+  int32_t c0 = (values[0] + 0x4000) >> 15;
+  int32_t c1 = (values[1] + 0x4000) >> 15;
+  int32_t c2 = (values[2] + 0x4000) >> 15;
+  if (SPACE == GRADIENT_HSV) return hsv_to_rgb888(hsv_t(wrap_hue(c0), clamp8(c1), clamp8(c2)));
+  if (SPACE == GRADIENT_OKLAB) return oklab_q15_to_rgb888(c0, c1, c2);
+  return rgb24_t(clamp8(c0), clamp8(c1), clamp8(c2));
+}
+
+// Channels of a space to RGB888, space chosen at runtime
+static rgb24_t space_to_rgb(gradient_space_t space, const int32_t* values){
+  switch (space){
+    case GRADIENT_HSV: return space_to_rgb<GRADIENT_HSV>(values);
+    case GRADIENT_OKLAB: return space_to_rgb<GRADIENT_OKLAB>(values);
+    default: return space_to_rgb<GRADIENT_RGB>(values);
+  }
+}
+
+/* SPAN TARGETS */
+
+// Packed colors
+struct gradient_rgb24_target_t{
+  rgb24_t* dst;
+
+  void store(size_t i, rgb24_t color) { dst[i] = color; }
+};
+
+// Named colors, the names are kept
+struct gradient_rgb888_target_t{
+  rgb888_t* dst;
+
+  void store(size_t i, rgb24_t color){
+    dst[i].value = color.value();
+    dst[i].red = color.red;
+    dst[i].green = color.green;
+    dst[i].blue = color.blue;
+  }
+};
+
+// RGB565 words
+struct gradient_rgb565_target_t{
+  uint16_t* dst;
+  bool big_endian;
+
+  void store(size_t i, rgb24_t color){
+    uint16_t value = rgb888_to_rgb565(color).value;
+    dst[i] = big_endian ? (uint16_t)((value << 8) | (value >> 8)) : value;
+  }
+};
+
+// WS2812 GRB bytes
+struct gradient_grb_target_t{
+  uint8_t* dst;
+
+  void store(size_t i, rgb24_t color){
+    dst[3 * i] = color.green;
+    dst[3 * i + 1] = color.red;
+    dst[3 * i + 2] = color.blue;
+  }
+};
+
+/* GRADIENT ENGINE */
+
+// DDA state of the segment under the position, the segment covers positions [low, high)
+struct gradient_t::segment_t{
+  uint32_t low;
+  uint32_t high;
+  int32_t values[3]; // channels at the position (15-bit fixed point)
+  int32_t steps[3]; // channel steps per color
+};
+
+gradient_t::gradient_t(const gradient_stop_t* stops, uint8_t count, gradient_space_t space){
+  mode = space;
+  this->count = count < GRADIENT_MAX_STOPS ? count : GRADIENT_MAX_STOPS;
+  for (uint8_t i = 0; i < this->count; i++){
+    positions[i] = stops[i].position;
+    channels[i][0] = stops[i].color.red;
+    channels[i][1] = stops[i].color.green;
+    channels[i][2] = stops[i].color.blue;
+  }
+  prepare();
+}
+
+gradient_t::gradient_t(const rgb24_t* colors, uint8_t count, gradient_space_t space){
+  mode = space;
+  this->count = count < GRADIENT_MAX_STOPS ? count : GRADIENT_MAX_STOPS;
+  for (uint8_t i = 0; i < this->count; i++){
+    positions[i] = this->count > 1 ? (uint16_t)((uint32_t)GRADIENT_END * i / (this->count - 1)) : 0;
+    channels[i][0] = colors[i].red;
+    channels[i][1] = colors[i].green;
+    channels[i][2] = colors[i].blue;
+  }
+  prepare();
+}
+
+gradient_t::gradient_t(rgb24_t from, rgb24_t to, gradient_space_t space){
+  const rgb24_t colors[2] = {from, to};
+  *this = gradient_t(colors, 2, space);
+}
+
+// Sort the stops (insertion sort, equal positions keep their order for hard edges) and convert them to the interpolation space
+void gradient_t::prepare(){
+  if (count == 0){
+    positions[0] = 0;
+    channels[0][0] = channels[0][1] = channels[0][2] = 0;
+    count = 1;
+  }
+
+  for (uint8_t i = 1; i < count; i++){
+    uint16_t position = positions[i];
+    int32_t color[3] = {channels[i][0], channels[i][1], channels[i][2]};
+    uint8_t j = i;
+    while (j > 0 && positions[j - 1] > position){
+      positions[j] = positions[j - 1];
+      memcpy(channels[j], channels[j - 1], sizeof(channels[j]));
+      j--;
+    }
+    positions[j] = position;
+    memcpy(channels[j], color, sizeof(color));
+  }
+
+  for (uint8_t i = 0; i < count; i++){
+    rgb24_t color((uint8_t)channels[i][0], (uint8_t)channels[i][1], (uint8_t)channels[i][2]);
+    if (mode == GRADIENT_HSV){
+      hsv_t hsv = rgb888_to_hsv(color);
+      channels[i][0] = hsv.hue;
+      channels[i][1] = hsv.saturation;
+      channels[i][2] = hsv.value;
+    }
+    else if (mode == GRADIENT_OKLAB){
+      // 15-bit fixed point of the OKLab conversion, spans feed it back without scaling
+      rgb888_to_oklab_q15(color, channels[i][0], channels[i][1], channels[i][2]);
+    }
+    // segment i (stop i to stop i + 1), hard edges are never entered
+    uint16_t length = i + 1 < count ? positions[i + 1] - positions[i] : 0;
+    inverses[i] = length != 0 ? ((1UL << 24) + length / 2) / length : 0;
+  }
+}
+
+// Number of stops at or before position t
+uint8_t gradient_t::stops_before(uint16_t t) const{
+  uint8_t i = 0;
+  while (i < count && positions[i] <= t) i++;
+  return i;
+}
+
+// Channels of the stops of a segment, hue path fixed
+void gradient_t::segment_channels(uint8_t index, int32_t* channels_1, int32_t* channels_2) const{
+  for (uint8_t c = 0; c < 3; c++){
+    channels_1[c] = channels[index][c];
+    channels_2[c] = channels[index + 1][c];
+  }
+  if (mode != GRADIENT_HSV) return;
+
+  // gray stops have no hue, take the one of the other stop
+  if (channels_2[1] == 0) channels_2[0] = channels_1[0];
+  else if (channels_1[1] == 0) channels_1[0] = channels_2[0];
+  // shortest way around the circle
+  if (channels_2[0] - channels_1[0] > HUE_STEPS / 2) channels_2[0] -= HUE_STEPS;
+  else if (channels_1[0] - channels_2[0] > HUE_STEPS / 2) channels_2[0] += HUE_STEPS;
+}
+
+// Segment under position t and channel steps for a position step dt (one division per channel)
+void gradient_t::enter_segment(segment_t& segment, int32_t t, int32_t dt) const{
+  uint8_t i = stops_before((uint16_t)(t >> 15));
+
+  // before the first stop or after the last one
+  if (i == 0 || i == count){
+    uint8_t stop = i == 0 ? 0 : count - 1;
+    segment.low = i == 0 ? 0 : (uint32_t)positions[stop] << 15;
+    segment.high = i == 0 ? (uint32_t)positions[stop] << 15 : 0xFFFFFFFFUL;
+    for (uint8_t c = 0; c < 3; c++){
+      segment.values[c] = channels[stop][c] * 32768;
+      segment.steps[c] = 0;
+    }
+    return;
+  }
+
+  int32_t channels_1[3];
+  int32_t channels_2[3];
+  segment_channels(i - 1, channels_1, channels_2);
+  segment.low = (uint32_t)positions[i - 1] << 15;
+  segment.high = (uint32_t)positions[i] << 15;
+  int32_t length = positions[i] - positions[i - 1];
+  for (uint8_t c = 0; c < 3; c++){
+    int32_t difference = channels_2[c] - channels_1[c];
+    segment.values[c] = channels_1[c] * 32768 + (int32_t)((int64_t)difference * (int32_t)(t - segment.low) / length);
+    segment.steps[c] = (int32_t)((int64_t)difference * dt / length);
+  }
+}
+
+// n colors from position t (15-bit fixed point) with a position step dt, the positions must stay in 0 to GRADIENT_END
+template <gradient_space_t SPACE, typename TARGET>
+void gradient_t::run_span(int32_t t, int32_t dt, size_t n, TARGET& target) const{
+  segment_t segment;
+  enter_segment(segment, t, dt);
+  uint32_t position = (uint32_t)t;
+  for (size_t i = 0; i < n; i++){
+    target.store(i, space_to_rgb<SPACE>(segment.values));
+    if (i + 1 == n) break;
+    position += (uint32_t)dt;
+    // the steps are only added inside the segment (the steps of a segment shorter than dt do not fit the channels)
+    if (position < segment.low || position >= segment.high) enter_segment(segment, (int32_t)position, dt);
+    else{
+      segment.values[0] += segment.steps[0];
+      segment.values[1] += segment.steps[1];
+      segment.values[2] += segment.steps[2];
+    }
+  }
+}
+
+// Span with the conversion of the interpolation space
+template <typename TARGET>
+void gradient_t::span(int32_t t, int32_t dt, size_t n, TARGET& target) const{
+  switch (mode){
+    case GRADIENT_HSV: run_span<GRADIENT_HSV>(t, dt, n, target); break;
+    case GRADIENT_OKLAB: run_span<GRADIENT_OKLAB>(t, dt, n, target); break;
+    default: run_span<GRADIENT_RGB>(t, dt, n, target); break;
+  }
+}
+
+/* COLOR AT T */
+
+// Color at position t
+rgb24_t gradient_t::color_at(uint16_t t) const{
+  uint8_t i = stops_before(t);
+  int32_t values[3];
+  if (i == 0 || i == count){
+    uint8_t stop = i == 0 ? 0 : count - 1;
+    for (uint8_t c = 0; c < 3; c++) values[c] = channels[stop][c] * 32768;
+    return space_to_rgb(mode, values);
+  }
+
+  int32_t channels_1[3];
+  int32_t channels_2[3];
+  segment_channels(i - 1, channels_1, channels_2);
+  // fraction of the segment (15-bit fixed point) with the segment inverse
+  int32_t fraction = (int32_t)(((uint32_t)(t - positions[i - 1]) * inverses[i - 1]) >> 9);
+  for (uint8_t c = 0; c < 3; c++) values[c] = channels_1[c] * 32768 + (channels_2[c] - channels_1[c]) * fraction;
+  return space_to_rgb(mode, values);
+}
+
+/* SPANS */
+
+// Start position and step of n colors from position from to position to
+static inline void span_steps(size_t n, uint16_t from, uint16_t to, int32_t& t, int32_t& dt){
+  t = (int32_t)from << 15;
+  dt = n > 1 ? (int32_t)((((int64_t)to - from) * 32768) / (int64_t)(n - 1)) : 0;
+}
+
+// Fill n packed colors
+void gradient_t::fill(rgb24_t* dst, size_t n, uint16_t from, uint16_t to) const{
+  int32_t t, dt;
+  span_steps(n, from, to, t, dt);
+  gradient_rgb24_target_t target = {dst};
+  span(t, dt, n, target);
+}
+
+// Fill n colors
+void gradient_t::fill(rgb888_t* dst, size_t n, uint16_t from, uint16_t to) const{
+  int32_t t, dt;
+  span_steps(n, from, to, t, dt);
+  gradient_rgb888_target_t target = {dst};
+  span(t, dt, n, target);
+}
+
+// Fill n RGB565 words
+void gradient_t::fill_rgb565(uint16_t* dst, size_t n, uint16_t from, uint16_t to, bool big_endian) const{
+  int32_t t, dt;
+  span_steps(n, from, to, t, dt);
+  gradient_rgb565_target_t target = {dst, big_endian};
+  span(t, dt, n, target);
+}
+
+// Fill n LEDs with GRB bytes
+void gradient_t::fill_grb(uint8_t* dst, size_t n, uint16_t from, uint16_t to) const{
+  int32_t t, dt;
+  span_steps(n, from, to, t, dt);
+  gradient_grb_target_t target = {dst};
+  span(t, dt, n, target);
+}
+
+/* 2D FILLS */
+
+// Fill n words with the same word
+static inline void fill_words(uint16_t* dst, size_t n, uint16_t value){
+  for (size_t i = 0; i < n; i++) dst[i] = value;
+}
+
+// RGB565 word of a color in the byte order of the frame
+static inline uint16_t frame_word(rgb24_t color, bool big_endian){
+  uint16_t value = rgb888_to_rgb565(color).value;
+  return big_endian ? (uint16_t)((value << 8) | (value >> 8)) : value;
+}
+
+// Linear fill
+bool gradient_t::fill_linear(uint16_t* dst, size_t width, size_t height, size_t stride, int16_t x0, int16_t y0, int16_t x1, int16_t y1, bool big_endian) const{
+  if (stride == 0) stride = width;
+  int64_t dx = (int64_t)x1 - x0;
+  int64_t dy = (int64_t)y1 - y0;
+  int64_t length = dx * dx + dy * dy;
+  if (length == 0){
+    uint16_t last = frame_word(color_at(GRADIENT_END), big_endian);
+    for (size_t y = 0; y < height; y++) fill_words(dst + y * stride, width, last);
+    return true;
+  }
+
+  // colors of the vector, a quarter pixel per entry
+  size_t entries = (size_t)(4 * sqrt((double)length)) + 2;
+  uint16_t* table = (uint16_t*)malloc(entries * sizeof(uint16_t));
+  if (table == nullptr) return false;
+  fill_rgb565(table, entries, 0, GRADIENT_END, big_endian);
+
+  // entry = projection on the vector / length * (entries - 1) (16-bit fixed point), the step across a row is constant
+  const int64_t end = (int64_t)(entries - 1) << 16;
+  int64_t step = dx * end / length;
+  for (size_t y = 0; y < height; y++){
+    uint16_t* row = dst + y * stride;
+    int64_t projection = -(int64_t)x0 * dx + ((int64_t)y - y0) * dy;
+    int64_t index = projection / length * end + projection % length * end / length;
+    for (size_t x = 0; x < width; x++){
+      // before the start or after the end of the vector: first or last color
+      row[x] = table[index <= 0 ? 0 : (index >= end ? entries - 1 : (size_t)((index + 0x8000) >> 16))];
+      index += step;
+    }
+  }
+  free(table);
+  return true;
+}
+
+// Radial fill
+bool gradient_t::fill_radial(uint16_t* dst, size_t width, size_t height, size_t stride, int16_t cx, int16_t cy, uint16_t radius, bool big_endian) const{
+  if (stride == 0) stride = width;
+  // every pixel is past a zero radius, like a zero length vector of fill_linear
+  if (radius == 0){
+    uint16_t last = frame_word(color_at(GRADIENT_END), big_endian);
+    for (size_t y = 0; y < height; y++) fill_words(dst + y * stride, width, last);
+    return true;
+  }
+
+  // colors of the radius, a quarter pixel per entry
+  size_t entries = (size_t)radius * 4 + 1;
+  uint16_t* table = (uint16_t*)malloc(entries * sizeof(uint16_t));
+  if (table == nullptr) return false;
+  fill_rgb565(table, entries, 0, GRADIENT_END, big_endian);
+  uint16_t outside = table[entries - 1];
+
+  for (size_t y = 0; y < height; y++){
+    uint16_t* row = dst + y * stride;
+    // distance in quarter pixels, rounded: r^2 - r < d^2 <= r^2 + r
+    int64_t dx = -4 * (int64_t)cx;
+    int64_t dy = 4 * ((int64_t)y - cy);
+    uint64_t distance_sq = (uint64_t)(dx * dx + dy * dy);
+    uint64_t r = (uint64_t)sqrt((double)distance_sq);
+    for (size_t x = 0; x < width; x++){
+      while (distance_sq > r * r + r) r++;
+      while (r > 0 && distance_sq <= r * r - r) r--;
+      row[x] = r < entries ? table[r] : outside;
+      // next pixel: (dx + 4)^2 = dx^2 + 8 dx + 16
+      distance_sq += (uint64_t)(8 * dx + 16);
+      dx += 4;
+    }
+  }
+  free(table);
+  return true;
+}
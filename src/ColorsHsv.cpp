@@ -0,0 +1,283 @@
+// ColorsHsv.cpp
+
+// Creator: JDFraire-P
+
+// Description: HSV and HSL color types with integer-only conversions, bulk spans and a hue wheel table for rainbow effects
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsHsv.h>
+#include <ColorsStats.h>
+
+/* CONVERSION TABLES */
+
+// 65536 / d rounded (65535 for 1), numerators are at most 255 d so the products fit in 32 bits
+static const uint16_t RECIPROCALS[256] PROGMEM = {
+  0, 65535, 32768, 21845, 16384, 13107, 10923, 9362, 8192, 7282, 6554, 5958, 5461, 5041, 4681, 4369,
+  4096, 3855, 3641, 3449, 3277, 3121, 2979, 2849, 2731, 2621, 2521, 2427, 2341, 2260, 2185, 2114,
+  2048, 1986, 1928, 1872, 1820, 1771, 1725, 1680, 1638, 1598, 1560, 1524, 1489, 1456, 1425, 1394,
+  1365, 1337, 1311, 1285, 1260, 1237, 1214, 1192, 1170, 1150, 1130, 1111, 1092, 1074, 1057, 1040,
+  1024, 1008, 993, 978, 964, 950, 936, 923, 910, 898, 886, 874, 862, 851, 840, 830,
+  819, 809, 799, 790, 780, 771, 762, 753, 745, 736, 728, 720, 712, 705, 697, 690,
+  683, 676, 669, 662, 655, 649, 643, 636, 630, 624, 618, 612, 607, 601, 596, 590,
+  585, 580, 575, 570, 565, 560, 555, 551, 546, 542, 537, 533, 529, 524, 520, 516,
+  512, 508, 504, 500, 496, 493, 489, 485, 482, 478, 475, 471, 468, 465, 462, 458,
+  455, 452, 449, 446, 443, 440, 437, 434, 431, 428, 426, 423, 420, 417, 415, 412,
+  410, 407, 405, 402, 400, 397, 395, 392, 390, 388, 386, 383, 381, 379, 377, 374,
+  372, 370, 368, 366, 364, 362, 360, 358, 356, 354, 352, 350, 349, 347, 345, 343,
+  341, 340, 338, 336, 334, 333, 331, 329, 328, 326, 324, 323, 321, 320, 318, 317,
+  315, 314, 312, 311, 309, 308, 306, 305, 303, 302, 301, 299, 298, 297, 295, 294,
+  293, 291, 290, 289, 287, 286, 285, 284, 282, 281, 280, 279, 278, 277, 275, 274,
+  273, 272, 271, 270, 269, 267, 266, 265, 264, 263, 262, 261, 260, 259, 258, 257
+};
+
+// Fully saturated color of each 8-bit hue (hue_from_hue8, same result as hsv_to_rgb888)
+static const uint8_t HUE_WHEEL[256][3] PROGMEM = {
+  {255, 0, 0}, {255, 6, 0}, {255, 12, 0}, {255, 18, 0}, {255, 24, 0}, {255, 30, 0}, {255, 36, 0}, {255, 42, 0},
+  {255, 48, 0}, {255, 54, 0}, {255, 60, 0}, {255, 66, 0}, {255, 72, 0}, {255, 78, 0}, {255, 84, 0}, {255, 90, 0},
+  {255, 96, 0}, {255, 102, 0}, {255, 108, 0}, {255, 114, 0}, {255, 120, 0}, {255, 126, 0}, {255, 131, 0}, {255, 137, 0},
+  {255, 143, 0}, {255, 149, 0}, {255, 155, 0}, {255, 161, 0}, {255, 167, 0}, {255, 173, 0}, {255, 179, 0}, {255, 185, 0},
+  {255, 191, 0}, {255, 197, 0}, {255, 203, 0}, {255, 209, 0}, {255, 215, 0}, {255, 221, 0}, {255, 227, 0}, {255, 233, 0},
+  {255, 239, 0}, {255, 245, 0}, {255, 251, 0}, {253, 255, 0}, {247, 255, 0}, {241, 255, 0}, {235, 255, 0}, {229, 255, 0},
+  {223, 255, 0}, {217, 255, 0}, {211, 255, 0}, {205, 255, 0}, {199, 255, 0}, {193, 255, 0}, {187, 255, 0}, {181, 255, 0},
+  {175, 255, 0}, {169, 255, 0}, {163, 255, 0}, {157, 255, 0}, {151, 255, 0}, {145, 255, 0}, {139, 255, 0}, {133, 255, 0},
+  {128, 255, 0}, {122, 255, 0}, {116, 255, 0}, {110, 255, 0}, {104, 255, 0}, {98, 255, 0}, {92, 255, 0}, {86, 255, 0},
+  {80, 255, 0}, {74, 255, 0}, {68, 255, 0}, {62, 255, 0}, {56, 255, 0}, {50, 255, 0}, {44, 255, 0}, {38, 255, 0},
+  {32, 255, 0}, {26, 255, 0}, {20, 255, 0}, {14, 255, 0}, {8, 255, 0}, {2, 255, 0}, {0, 255, 4}, {0, 255, 10},
+  {0, 255, 16}, {0, 255, 22}, {0, 255, 28}, {0, 255, 34}, {0, 255, 40}, {0, 255, 46}, {0, 255, 52}, {0, 255, 58},
+  {0, 255, 64}, {0, 255, 70}, {0, 255, 76}, {0, 255, 82}, {0, 255, 88}, {0, 255, 94}, {0, 255, 100}, {0, 255, 106},
+  {0, 255, 112}, {0, 255, 118}, {0, 255, 124}, {0, 255, 129}, {0, 255, 135}, {0, 255, 141}, {0, 255, 147}, {0, 255, 153},
+  {0, 255, 159}, {0, 255, 165}, {0, 255, 171}, {0, 255, 177}, {0, 255, 183}, {0, 255, 189}, {0, 255, 195}, {0, 255, 201},
+  {0, 255, 207}, {0, 255, 213}, {0, 255, 219}, {0, 255, 225}, {0, 255, 231}, {0, 255, 237}, {0, 255, 243}, {0, 255, 249},
+  {0, 255, 255}, {0, 249, 255}, {0, 243, 255}, {0, 237, 255}, {0, 231, 255}, {0, 225, 255}, {0, 219, 255}, {0, 213, 255},
+  {0, 207, 255}, {0, 201, 255}, {0, 195, 255}, {0, 189, 255}, {0, 183, 255}, {0, 177, 255}, {0, 171, 255}, {0, 165, 255},
+  {0, 159, 255}, {0, 153, 255}, {0, 147, 255}, {0, 141, 255}, {0, 135, 255}, {0, 129, 255}, {0, 124, 255}, {0, 118, 255},
+  {0, 112, 255}, {0, 106, 255}, {0, 100, 255}, {0, 94, 255}, {0, 88, 255}, {0, 82, 255}, {0, 76, 255}, {0, 70, 255},
+  {0, 64, 255}, {0, 58, 255}, {0, 52, 255}, {0, 46, 255}, {0, 40, 255}, {0, 34, 255}, {0, 28, 255}, {0, 22, 255},
+  {0, 16, 255}, {0, 10, 255}, {0, 4, 255}, {2, 0, 255}, {8, 0, 255}, {14, 0, 255}, {20, 0, 255}, {26, 0, 255},
+  {32, 0, 255}, {38, 0, 255}, {44, 0, 255}, {50, 0, 255}, {56, 0, 255}, {62, 0, 255}, {68, 0, 255}, {74, 0, 255},
+  {80, 0, 255}, {86, 0, 255}, {92, 0, 255}, {98, 0, 255}, {104, 0, 255}, {110, 0, 255}, {116, 0, 255}, {122, 0, 255},
+  {128, 0, 255}, {133, 0, 255}, {139, 0, 255}, {145, 0, 255}, {151, 0, 255}, {157, 0, 255}, {163, 0, 255}, {169, 0, 255},
+  {175, 0, 255}, {181, 0, 255}, {187, 0, 255}, {193, 0, 255}, {199, 0, 255}, {205, 0, 255}, {211, 0, 255}, {217, 0, 255},
+  {223, 0, 255}, {229, 0, 255}, {235, 0, 255}, {241, 0, 255}, {247, 0, 255}, {253, 0, 255}, {255, 0, 251}, {255, 0, 245},
+  {255, 0, 239}, {255, 0, 233}, {255, 0, 227}, {255, 0, 221}, {255, 0, 215}, {255, 0, 209}, {255, 0, 203}, {255, 0, 197},
+  {255, 0, 191}, {255, 0, 185}, {255, 0, 179}, {255, 0, 173}, {255, 0, 167}, {255, 0, 161}, {255, 0, 155}, {255, 0, 149},
+  {255, 0, 143}, {255, 0, 137}, {255, 0, 131}, {255, 0, 126}, {255, 0, 120}, {255, 0, 114}, {255, 0, 108}, {255, 0, 102},
+  {255, 0, 96}, {255, 0, 90}, {255, 0, 84}, {255, 0, 78}, {255, 0, 72}, {255, 0, 66}, {255, 0, 60}, {255, 0, 54},
+  {255, 0, 48}, {255, 0, 42}, {255, 0, 36}, {255, 0, 30}, {255, 0, 24}, {255, 0, 18}, {255, 0, 12}, {255, 0, 6}
+};
+
+// Level of red, green and blue in each sextant (0: top, 1: bottom, 2: rising, 3: falling)
+static const uint8_t SEXTANT_LEVELS[6][3] PROGMEM = {
+  {0, 2, 1}, {3, 0, 1}, {1, 0, 2}, {1, 3, 0}, {2, 1, 0}, {0, 1, 3}
+};
+
+/* CONVERSION HELPERS */
+
+// Rounded numerator / d with the reciprocal table (numerator up to 255 d, negative numerators round down)
+static inline int32_t divide(int32_t numerator, uint8_t d){
+  return (numerator * (int32_t)pgm_read_word(RECIPROCALS + d) + 32768) >> 16;
+}
+
+// Hue of a color from its largest channel and the channel spread (0 for grays, the reciprocal of 0 is 0)
+static inline uint16_t rgb_hue(rgb24_t color, uint8_t max, uint8_t delta){
+  // masks instead of branches, the largest channel of random colors is not predictable
+  int32_t red = -(int32_t)(max == color.red);
+  int32_t green = ~red & -(int32_t)(max == color.green);
+  int32_t blue = ~(red | green);
+  int32_t difference = (red & ((int32_t)color.green - color.blue)) | (green & ((int32_t)color.blue - color.red)) | (blue & ((int32_t)color.red - color.green));
+  int32_t hue = (green & 512) + (blue & 1024) + divide(256 * difference, delta);
+  return (uint16_t)(hue < 0 ? hue + HUE_STEPS : hue);
+}
+
+// Hue wrapped to a full turn
+static inline uint16_t wrap_hue(uint16_t hue){
+  return hue < HUE_STEPS ? hue : (uint16_t)(hue % HUE_STEPS);
+}
+
+// Pick the levels of red, green and blue for the sextant of a hue
+static inline rgb24_t sextant_color(uint16_t hue, const uint8_t* levels){
+  const uint8_t* order = SEXTANT_LEVELS[hue >> 8];
+  return rgb24_t(levels[pgm_read_byte(order)], levels[pgm_read_byte(order + 1)], levels[pgm_read_byte(order + 2)]);
+}
+
+// Chroma / 255 in 16-bit fixed point (chroma * 65793 / 256, 65793 / 2^24 is 1 / 255 within 2^-32), chroma up to 65025
+static inline uint32_t chroma_scale(uint16_t chroma){
+  return ((uint32_t)chroma * 65793) >> 8;
+}
+
+// Rounded drop of a channel: scaled chroma * ramp / 2^24 (ramp 0 to 256, one multiply)
+static inline uint8_t channel_drop(uint32_t scaled, uint16_t ramp){
+  return (uint8_t)((scaled * ramp + 0x800000UL) >> 24);
+}
+
+// Signed drop of a HSL channel (ramp -128 to 128, negative ramps raise the channel)
+static inline int16_t signed_drop(uint32_t scaled, int16_t ramp){
+  return (int16_t)(((int32_t)scaled * ramp + 0x800000L) >> 24);
+}
+
+/* HSV AND HSL CONVERSION FUNCTIONS */
+
+// Convert RGB888 to HSV
+hsv_t rgb888_to_hsv(rgb24_t color){
+  uint8_t max = color.red > color.green ? color.red : color.green;
+  if (color.blue > max) max = color.blue;
+  uint8_t min = color.red < color.green ? color.red : color.green;
+  if (color.blue < min) min = color.blue;
+  uint8_t delta = max - min;
+  return hsv_t(rgb_hue(color, max, delta), (uint8_t)divide(255 * (int32_t)delta, max), max);
+}
+
+// Convert RGB565 to HSV
+hsv_t rgb565_to_hsv(rgb16_t color){
+  return rgb888_to_hsv(rgb565_to_rgb888(color));
+}
+
+// Convert HSV to RGB888
+rgb24_t hsv_to_rgb888(hsv_t color){
+  uint16_t hue = wrap_hue(color.hue);
+  uint8_t fraction = (uint8_t)hue;
+  uint8_t value = color.value;
+  // drops of value * saturation / 255 * ramp / 256 (ramps: top 0, bottom 256, rising 256 - fraction, falling fraction)
+  uint32_t scaled = chroma_scale((uint16_t)value * color.saturation);
+  const uint8_t levels[4] = {value, (uint8_t)(value - channel_drop(scaled, 256)), (uint8_t)(value - channel_drop(scaled, 256 - fraction)), (uint8_t)(value - channel_drop(scaled, fraction))};
+  return sextant_color(hue, levels);
+}
+
+// Convert HSV to RGB565
+rgb16_t hsv_to_rgb565(hsv_t color){
+  return rgb888_to_rgb565(hsv_to_rgb888(color));
+}
+
+// Convert RGB888 to HSL
+hsl_t rgb888_to_hsl(rgb24_t color){
+  uint8_t max = color.red > color.green ? color.red : color.green;
+  if (color.blue > max) max = color.blue;
+  uint8_t min = color.red < color.green ? color.red : color.green;
+  if (color.blue < min) min = color.blue;
+  uint8_t delta = max - min;
+  uint8_t lightness = (uint8_t)(((uint16_t)max + min + 1) >> 1);
+  // saturation = delta / (1 - |2 lightness - 1|) with the rounded lightness, so hsl_to_rgb888 gets the spread back
+  uint8_t range = (uint8_t)(2 * (lightness < 255 - lightness ? lightness : 255 - lightness));
+  int32_t saturation = range != 0 ? divide(255 * (int32_t)delta, range) : 0;
+  return hsl_t(rgb_hue(color, max, delta), (uint8_t)(saturation < 255 ? saturation : 255), lightness);
+}
+
+// Convert RGB565 to HSL
+hsl_t rgb565_to_hsl(rgb16_t color){
+  return rgb888_to_hsl(rgb565_to_rgb888(color));
+}
+
+// Convert HSL to RGB888
+rgb24_t hsl_to_rgb888(hsl_t color){
+  uint16_t hue = wrap_hue(color.hue);
+  int16_t fraction = (uint8_t)hue;
+  uint8_t lightness = color.lightness;
+  // drops of saturation * min(lightness, 255 - lightness) / 255 * ramp / 128 (ramps: top -128, bottom 128, rising 128 - fraction, falling fraction - 128)
+  uint32_t scaled = chroma_scale((uint16_t)color.saturation * (lightness < 255 - lightness ? lightness : 255 - lightness)) << 1;
+  const uint8_t levels[4] = {(uint8_t)(lightness - signed_drop(scaled, -128)), (uint8_t)(lightness - signed_drop(scaled, 128)),
+                             (uint8_t)(lightness - signed_drop(scaled, 128 - fraction)), (uint8_t)(lightness - signed_drop(scaled, fraction - 128))};
+  return sextant_color(hue, levels);
+}
+
+// Convert HSL to RGB565
+rgb16_t hsl_to_rgb565(hsl_t color){
+  return rgb888_to_rgb565(hsl_to_rgb888(color));
+}
+
+/* HUE WHEEL FUNCTIONS */
+
+// Fully saturated color of an 8-bit hue
+rgb24_t hue_wheel(uint8_t hue8){
+  return rgb24_t(pgm_read_byte(&HUE_WHEEL[hue8][0]), pgm_read_byte(&HUE_WHEEL[hue8][1]), pgm_read_byte(&HUE_WHEEL[hue8][2]));
+}
+
+// Channel of the hue wheel with saturation and value, the table channel gives the ramp (255 - channel) * 256 / 255
+static inline uint8_t wheel_channel(uint8_t channel, uint8_t value, uint32_t scaled){
+  return value - channel_drop(scaled, (uint16_t)(((255 - channel) * 257 + 128) >> 8));
+}
+
+// HSV color with an 8-bit hue through the hue wheel table
+rgb24_t hsv8_to_rgb888(uint8_t hue8, uint8_t saturation, uint8_t value){
+  rgb24_t color = hue_wheel(hue8);
+  if (saturation == 255 && value == 255) return color;
+  uint32_t scaled = chroma_scale((uint16_t)value * saturation);
+  return rgb24_t(wheel_channel(color.red, value, scaled), wheel_channel(color.green, value, scaled), wheel_channel(color.blue, value, scaled));
+}
+
+/* BULK HSV AND HSL FUNCTIONS */
+
+// Swap the bytes of a RGB565 word if big endian
+static inline uint16_t store565(rgb16_t color, bool big_endian){
+  return big_endian ? (uint16_t)((color.value << 8) | (color.value >> 8)) : color.value;
+}
+
+// Convert n RGB888 colors to HSV
+void convert_rgb888_to_hsv(const rgb24_t* src, hsv_t* dst, size_t n){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = 0; i < n; i++) dst[i] = rgb888_to_hsv(src[i]);
+}
+
+// Convert n HSV colors to RGB888
+void convert_hsv_to_rgb888(const hsv_t* src, rgb24_t* dst, size_t n){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = 0; i < n; i++) dst[i] = hsv_to_rgb888(src[i]);
+}
+
+// Convert n HSV colors to RGB565
+void convert_hsv_to_rgb565(const hsv_t* src, uint16_t* dst, size_t n, bool big_endian){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = 0; i < n; i++) dst[i] = store565(hsv_to_rgb565(src[i]), big_endian);
+}
+
+// Convert n RGB888 colors to HSL
+void convert_rgb888_to_hsl(const rgb24_t* src, hsl_t* dst, size_t n){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = 0; i < n; i++) dst[i] = rgb888_to_hsl(src[i]);
+}
+
+// Convert n HSL colors to RGB888
+void convert_hsl_to_rgb888(const hsl_t* src, rgb24_t* dst, size_t n){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = 0; i < n; i++) dst[i] = hsl_to_rgb888(src[i]);
+}
+
+// Convert n HSL colors to RGB565
+void convert_hsl_to_rgb565(const hsl_t* src, uint16_t* dst, size_t n, bool big_endian){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = 0; i < n; i++) dst[i] = store565(hsl_to_rgb565(src[i]), big_endian);
+}
+
+// Rotate the hue of n colors
+void rotate_hue(const rgb24_t* src, rgb24_t* dst, size_t n, int16_t shift){
+  // shift as a forward turn of 0 to 1535 steps
+  int16_t turn = (int16_t)(shift % HUE_STEPS);
+  if (turn < 0) turn += HUE_STEPS;
+  for (size_t i = 0; i < n; i++){
+    hsv_t color = rgb888_to_hsv(src[i]);
+    color.hue = (uint16_t)(color.hue + turn);
+    if (color.hue >= HUE_STEPS) color.hue -= HUE_STEPS;
+    dst[i] = hsv_to_rgb888(color);
+  }
+}
+
+// Fill n colors with a rainbow
+void fill_rainbow(rgb24_t* dst, size_t n, uint16_t start, int16_t step, uint8_t saturation, uint8_t value){
+  uint16_t hue = start;
+  for (size_t i = 0; i < n; i++){
+    dst[i] = hsv8_to_rgb888((uint8_t)(hue >> 8), saturation, value);
+    hue = (uint16_t)(hue + step);
+  }
+}
+
+// Fill n LEDs with a rainbow in GRB bytes
+void fill_rainbow_grb(uint8_t* dst, size_t n, uint16_t start, int16_t step, uint8_t saturation, uint8_t value){
+  uint16_t hue = start;
+  for (size_t i = 0; i < n; i++){
+    rgb24_t color = hsv8_to_rgb888((uint8_t)(hue >> 8), saturation, value);
+    dst[3 * i] = color.green;
+    dst[3 * i + 1] = color.red;
+    dst[3 * i + 2] = color.blue;
+    hue = (uint16_t)(hue + step);
+  }
+}
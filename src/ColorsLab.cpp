@@ -0,0 +1,311 @@
+// ColorsLab.cpp
+
+// Creator: JDFraire-P
+
+// Description: Perceptual color spaces (CIELAB and OKLab), fixed-point conversions and delta E metrics
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsLab.h>
+#include "ColorsLabFixed.h"
+#include <ColorsStats.h>
+
+/* CONVERSION TABLES */
+
+// Linear value of each sRGB channel value (16-bit fixed point, 65535 is 1.0)
+static const uint16_t SRGB_TO_LINEAR[256] PROGMEM = {
+  0, 20, 40, 60, 80, 99, 119, 139, 159, 179, 199, 219, 241, 264, 288, 313,
+  340, 367, 396, 427, 458, 491, 526, 562, 599, 637, 677, 718, 761, 805, 851, 898,
+  947, 997, 1048, 1101, 1156, 1212, 1270, 1330, 1391, 1453, 1517, 1583, 1651, 1720, 1790, 1863,
+  1937, 2013, 2090, 2170, 2250, 2333, 2418, 2504, 2592, 2681, 2773, 2866, 2961, 3058, 3157, 3258,
+  3360, 3464, 3570, 3678, 3788, 3900, 4014, 4129, 4247, 4366, 4488, 4611, 4736, 4864, 4993, 5124,
+  5257, 5392, 5530, 5669, 5810, 5953, 6099, 6246, 6395, 6547, 6700, 6856, 7014, 7174, 7335, 7500,
+  7666, 7834, 8004, 8177, 8352, 8528, 8708, 8889, 9072, 9258, 9445, 9635, 9828, 10022, 10219, 10417,
+  10619, 10822, 11028, 11235, 11446, 11658, 11873, 12090, 12309, 12530, 12754, 12980, 13209, 13440, 13673, 13909,
+  14146, 14387, 14629, 14874, 15122, 15371, 15623, 15878, 16135, 16394, 16656, 16920, 17187, 17456, 17727, 18001,
+  18277, 18556, 18837, 19121, 19407, 19696, 19987, 20281, 20577, 20876, 21177, 21481, 21787, 22096, 22407, 22721,
+  23038, 23357, 23678, 24002, 24329, 24658, 24990, 25325, 25662, 26001, 26344, 26688, 27036, 27386, 27739, 28094,
+  28452, 28813, 29176, 29542, 29911, 30282, 30656, 31033, 31412, 31794, 32179, 32567, 32957, 33350, 33745, 34143,
+  34544, 34948, 35355, 35764, 36176, 36591, 37008, 37429, 37852, 38278, 38706, 39138, 39572, 40009, 40449, 40891,
+  41337, 41785, 42236, 42690, 43147, 43606, 44069, 44534, 45002, 45473, 45947, 46423, 46903, 47385, 47871, 48359,
+  48850, 49344, 49841, 50341, 50844, 51349, 51858, 52369, 52884, 53401, 53921, 54445, 54971, 55500, 56032, 56567,
+  57105, 57646, 58190, 58737, 59287, 59840, 60396, 60955, 61517, 62082, 62650, 63221, 63795, 64372, 64952, 65535
+};
+
+// Cube root of i / 256 for i from 32 to 256 (15-bit fixed point, 32768 is 1.0)
+static const uint16_t CBRT_TABLE[225] PROGMEM = {
+  16384, 16553, 16718, 16881, 17040, 17196, 17350, 17501, 17649, 17795, 17939, 18080, 18219, 18356, 18491,
+  18624, 18755, 18884, 19012, 19138, 19262, 19385, 19506, 19626, 19744, 19861, 19976, 20090, 20203, 20315,
+  20425, 20534, 20643, 20750, 20855, 20960, 21064, 21167, 21268, 21369, 21469, 21568, 21666, 21763, 21860,
+  21955, 22050, 22143, 22237, 22329, 22420, 22511, 22601, 22690, 22779, 22867, 22954, 23041, 23127, 23212,
+  23297, 23381, 23465, 23547, 23630, 23712, 23793, 23873, 23954, 24033, 24112, 24191, 24269, 24346, 24423,
+  24500, 24576, 24652, 24727, 24801, 24876, 24950, 25023, 25096, 25168, 25241, 25312, 25384, 25454, 25525,
+  25595, 25665, 25734, 25803, 25872, 25940, 26008, 26076, 26143, 26210, 26276, 26342, 26408, 26474, 26539,
+  26604, 26668, 26733, 26797, 26860, 26924, 26987, 27049, 27112, 27174, 27236, 27298, 27359, 27420, 27481,
+  27541, 27602, 27662, 27721, 27781, 27840, 27899, 27958, 28016, 28074, 28132, 28190, 28248, 28305, 28362,
+  28419, 28476, 28532, 28588, 28644, 28700, 28755, 28811, 28866, 28921, 28975, 29030, 29084, 29138, 29192,
+  29246, 29299, 29352, 29405, 29458, 29511, 29564, 29616, 29668, 29720, 29772, 29823, 29875, 29926, 29977,
+  30028, 30079, 30129, 30180, 30230, 30280, 30330, 30379, 30429, 30478, 30528, 30577, 30626, 30674, 30723,
+  30771, 30820, 30868, 30916, 30964, 31012, 31059, 31107, 31154, 31201, 31248, 31295, 31341, 31388, 31434,
+  31481, 31527, 31573, 31619, 31665, 31710, 31756, 31801, 31846, 31891, 31936, 31981, 32026, 32071, 32115,
+  32159, 32204, 32248, 32292, 32336, 32379, 32423, 32467, 32510, 32553, 32596, 32639, 32682, 32725, 32768
+};
+
+/* FIXED-POINT HELPERS */
+
+// Linear value of a sRGB channel (16-bit fixed point)
+static inline int32_t srgb_to_linear(uint8_t value){
+  return (int32_t)pgm_read_word(SRGB_TO_LINEAR + value);
+}
+
+// sRGB channel whose linear value is nearest to a linear value (15-bit fixed point, clipped to [0, 1])
+static uint8_t linear_to_srgb(int32_t linear){
+  if (linear <= 0) return 0;
+  if (linear >= 32768) return 255;
+  uint16_t target = (uint16_t)(linear << 1);
+  // largest channel value whose linear value is not above the target
+  uint8_t low = 0;
+  uint8_t high = 255;
+  while (low < high){
+    uint8_t middle = (uint8_t)((low + high + 1) >> 1);
+    if (pgm_read_word(SRGB_TO_LINEAR + middle) <= target) low = middle;
+    else high = middle - 1;
+  }
+  if (low < 255 && target - pgm_read_word(SRGB_TO_LINEAR + low) > pgm_read_word(SRGB_TO_LINEAR + low + 1) - target) low++;
+  return low;
+}
+
+// Cube root of a value from 0 to 1 (20-bit fixed point input, 15-bit fixed point result)
+static int32_t cbrt_q15(int32_t value){
+  if (value <= 0) return 0;
+  if (value >= 1048576) return 32768;
+  // scale into [1/8, 1), each factor of 8 doubles the root
+  uint8_t shift = 0;
+  while (value < 131072){
+    value <<= 3;
+    shift++;
+  }
+  uint8_t index = (uint8_t)((value >> 12) - 32);
+  int32_t fraction = value & 0xFFF;
+  int32_t low = pgm_read_word(CBRT_TABLE + index);
+  int32_t high = pgm_read_word(CBRT_TABLE + index + 1);
+  int32_t root = low + (((high - low) * fraction + 2048) >> 12);
+  return (root + ((1 << shift) >> 1)) >> shift;
+}
+
+// CIELAB f(t) (20-bit fixed point input, 15-bit fixed point result)
+static inline int32_t lab_f(int32_t t){
+  // (6/29)^3 = 0.008856, below it f(t) = 7.787 t + 16/116
+  if (t > 9286) return cbrt_q15(t);
+  return ((t * 15948 + 32768) >> 16) + 4520;
+}
+
+// Inverse of CIELAB f(t) (15-bit fixed point input and result)
+static inline int32_t lab_f_inverse(int32_t f){
+  // 6/29 = 0.2069, below it t = 3 (6/29)^2 (f - 16/116)
+  if (f > 6780){
+    if (f > 40000) f = 40000;
+    return (((f * f) >> 15) * f) >> 15;
+  }
+  return ((f - 4520) * 4208 + 16384) >> 15;
+}
+
+// Value divided by 2^shift rounded to nearest
+static inline int32_t round_shift(int32_t value, uint8_t shift){
+  return (value + ((int32_t)1 << (shift - 1))) >> shift;
+}
+
+// Clamp a value to [low, high]
+static inline int32_t clamp_value(int32_t value, int32_t low, int32_t high){
+  return value < low ? low : (value > high ? high : value);
+}
+
+/* PERCEPTUAL CONVERSION FUNCTIONS */
+
+// Convert RGB888 to CIELAB
+lab_t rgb888_to_lab(rgb24_t color){
+  int32_t red = srgb_to_linear(color.red);
+  int32_t green = srgb_to_linear(color.green);
+  int32_t blue = srgb_to_linear(color.blue);
+
+  // XYZ relative to the D65 white, 20-bit fixed point
+  int32_t fx = lab_f(round_shift(7110 * red + 6164 * green + 3110 * blue, 10));
+  int32_t fy = lab_f(round_shift(3484 * red + 11717 * green + 1183 * blue, 10));
+  int32_t fz = lab_f(round_shift(291 * red + 1794 * green + 14299 * blue, 10));
+
+  return lab_t((int16_t)(round_shift(11600 * fy, 15) - 1600), (int16_t)round_shift(50000 * (fx - fy), 15), (int16_t)round_shift(20000 * (fy - fz), 15));
+}
+
+// Convert RGB565 to CIELAB
+lab_t rgb565_to_lab(rgb16_t color){
+  return rgb888_to_lab(rgb565_to_rgb888(color));
+}
+
+// Convert CIELAB to RGB888
+rgb24_t lab_to_rgb888(lab_t color){
+  // f(X), f(Y) and f(Z) in 15-bit fixed point
+  int32_t fy = (((int32_t)color.L + 1600) * 32768 + 5800) / 11600;
+  int32_t fx = fy + ((int32_t)color.a * 32768 + (color.a < 0 ? -25000 : 25000)) / 50000;
+  int32_t fz = fy - ((int32_t)color.b * 32768 + (color.b < 0 ? -10000 : 10000)) / 20000;
+
+  int32_t x = lab_f_inverse(fx);
+  int32_t y = lab_f_inverse(fy);
+  int32_t z = lab_f_inverse(fz);
+
+  // linear channels in 15-bit fixed point
+  return rgb24_t(linear_to_srgb(round_shift(12615 * x - 6296 * y - 2223 * z, 12)),
+                 linear_to_srgb(round_shift(-3773 * x + 7684 * y + 185 * z, 12)),
+                 linear_to_srgb(round_shift(217 * x - 836 * y + 4715 * z, 12)));
+}
+
+// Convert RGB888 to OKLab in 15-bit fixed point
+void rgb888_to_oklab_q15(rgb24_t color, int32_t& L, int32_t& a, int32_t& b){
+  int32_t red = srgb_to_linear(color.red);
+  int32_t green = srgb_to_linear(color.green);
+  int32_t blue = srgb_to_linear(color.blue);
+
+  // LMS responses in 20-bit fixed point, cube roots in 15-bit fixed point
+  int32_t l = cbrt_q15(round_shift(6754 * red + 8787 * green + 843 * blue, 10));
+  int32_t m = cbrt_q15(round_shift(3472 * red + 11152 * green + 1760 * blue, 10));
+  int32_t s = cbrt_q15(round_shift(1447 * red + 4616 * green + 10321 * blue, 10));
+
+  L = round_shift(1724 * l + 6501 * m - 33 * s, 13);
+  a = round_shift(16204 * l - 19895 * m + 3691 * s, 13);
+  b = round_shift(212 * l + 6412 * m - 6624 * s, 13);
+}
+
+// Convert RGB888 to OKLab
+oklab_t rgb888_to_oklab(rgb24_t color){
+  int32_t L, a, b;
+  rgb888_to_oklab_q15(color, L, a, b);
+
+  // 15-bit fixed point results scaled to ten-thousandths
+  return oklab_t((int16_t)round_shift(L * 10000, 15), (int16_t)round_shift(a * 10000, 15), (int16_t)round_shift(b * 10000, 15));
+}
+
+// Convert RGB565 to OKLab
+oklab_t rgb565_to_oklab(rgb16_t color){
+  return rgb888_to_oklab(rgb565_to_rgb888(color));
+}
+
+// Convert OKLab in 15-bit fixed point to RGB888
+rgb24_t oklab_q15_to_rgb888(int32_t L, int32_t a, int32_t b){
+  // limited so the products below fit in 32 bits
+  L = clamp_value(L, 0, 32768);
+  a = clamp_value(a, -16384, 16384);
+  b = clamp_value(b, -16384, 16384);
+
+  // cube roots of the LMS responses, then the responses
+  int32_t l = clamp_value(round_shift(16384 * L + 6494 * a + 3536 * b, 14), -32768, 32768);
+  int32_t m = clamp_value(round_shift(16384 * L - 1730 * a - 1046 * b, 14), -32768, 32768);
+  int32_t s = clamp_value(round_shift(16384 * L - 1466 * a - 21160 * b, 14), -32768, 32768);
+  l = (((l * l) >> 15) * l) >> 15;
+  m = (((m * m) >> 15) * m) >> 15;
+  s = (((s * s) >> 15) * s) >> 15;
+
+  // linear channels in 15-bit fixed point
+  return rgb24_t(linear_to_srgb(round_shift(16698 * l - 13548 * m + 946 * s, 12)),
+                 linear_to_srgb(round_shift(-5196 * l + 10690 * m - 1398 * s, 12)),
+                 linear_to_srgb(round_shift(-17 * l - 2881 * m + 6994 * s, 12)));
+}
+
+// Convert OKLab to RGB888
+rgb24_t oklab_to_rgb888(oklab_t color){
+  // ten-thousandths to 15-bit fixed point
+  return oklab_q15_to_rgb888(((int32_t)color.L * 32768 + 5000) / 10000,
+                             ((int32_t)color.a * 32768 + (color.a < 0 ? -5000 : 5000)) / 10000,
+                             ((int32_t)color.b * 32768 + (color.b < 0 ? -5000 : 5000)) / 10000);
+}
+
+// Convert n RGB888 colors to CIELAB
+void convert_rgb888_to_lab(const rgb24_t* src, lab_t* dst, size_t n){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = 0; i < n; i++) dst[i] = rgb888_to_lab(src[i]);
+}
+
+// Convert n RGB888 colors to OKLab
+void convert_rgb888_to_oklab(const rgb24_t* src, oklab_t* dst, size_t n){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = 0; i < n; i++) dst[i] = rgb888_to_oklab(src[i]);
+}
+
+/* PERCEPTUAL DISTANCE FUNCTIONS */
+
+// Delta E 1976
+float delta_e76(lab_t color_1, lab_t color_2){
+  return sqrt((float)delta_e76_sq(color_1, color_2)) / 100.0;
+}
+
+/*  Delta E 2000
+1. Stretch a* by a factor that depends on the mean chroma (neutral colors get the largest stretch), then compute chroma C' and hue h' of both colors.
+2. Compute the lightness, chroma and hue differences (the hue difference is taken on the shorter arc of the hue circle).
+3. Weight each difference with the S_L, S_C and S_H functions of the mean lightness, chroma and hue.
+4. Add the rotation term R_T, which couples the chroma and hue differences in the blue region.
+*/
+float delta_e2000(lab_t color_1, lab_t color_2){
+  const float to_radians = PI / 180.0;
+  const float pow25_7 = 6103515625.0; // 25^7
+
+  float L1 = color_1.L / 100.0, a1 = color_1.a / 100.0, b1 = color_1.b / 100.0;
+  float L2 = color_2.L / 100.0, a2 = color_2.a / 100.0, b2 = color_2.b / 100.0;
+
+  // 1. stretched a*, chroma and hue
+  float C_mean = (sqrt(a1 * a1 + b1 * b1) + sqrt(a2 * a2 + b2 * b2)) / 2.0;
+  float C_mean7 = pow(C_mean, 7);
+  float G = 0.5 * (1.0 - sqrt(C_mean7 / (C_mean7 + pow25_7)));
+  float a1p = (1.0 + G) * a1;
+  float a2p = (1.0 + G) * a2;
+  float C1p = sqrt(a1p * a1p + b1 * b1);
+  float C2p = sqrt(a2p * a2p + b2 * b2);
+  float h1p = (a1p == 0 && b1 == 0) ? 0 : atan2(b1, a1p) / to_radians;
+  float h2p = (a2p == 0 && b2 == 0) ? 0 : atan2(b2, a2p) / to_radians;
+  if (h1p < 0) h1p += 360.0;
+  if (h2p < 0) h2p += 360.0;
+
+  // 2. differences
+  float dLp = L2 - L1;
+  float dCp = C2p - C1p;
+  float dhp = 0;
+  if (C1p * C2p != 0){
+    dhp = h2p - h1p;
+    if (dhp > 180.0) dhp -= 360.0;
+    else if (dhp < -180.0) dhp += 360.0;
+  }
+  float dHp = 2.0 * sqrt(C1p * C2p) * sin(dhp * to_radians / 2.0);
+
+  // 3. weighting functions
+  float Lp_mean = (L1 + L2) / 2.0;
+  float Cp_mean = (C1p + C2p) / 2.0;
+  float hp_mean = h1p + h2p;
+  if (C1p * C2p != 0){
+    if (fabs(h1p - h2p) <= 180.0) hp_mean /= 2.0;
+    else hp_mean = hp_mean < 360.0 ? (hp_mean + 360.0) / 2.0 : (hp_mean - 360.0) / 2.0;
+  }
+  float T = 1.0 - 0.17 * cos((hp_mean - 30.0) * to_radians) + 0.24 * cos(2.0 * hp_mean * to_radians)
+          + 0.32 * cos((3.0 * hp_mean + 6.0) * to_radians) - 0.20 * cos((4.0 * hp_mean - 63.0) * to_radians);
+  float Lp_offset = (Lp_mean - 50.0) * (Lp_mean - 50.0);
+  float S_L = 1.0 + 0.015 * Lp_offset / sqrt(20.0 + Lp_offset);
+  float S_C = 1.0 + 0.045 * Cp_mean;
+  float S_H = 1.0 + 0.015 * Cp_mean * T;
+
+  // 4. rotation term
+  float d_theta = 30.0 * exp(-((hp_mean - 275.0) / 25.0) * ((hp_mean - 275.0) / 25.0));
+  float Cp_mean7 = pow(Cp_mean, 7);
+  float R_T = -2.0 * sqrt(Cp_mean7 / (Cp_mean7 + pow25_7)) * sin(2.0 * d_theta * to_radians);
+
+  float L_term = dLp / S_L;
+  float C_term = dCp / S_C;
+  float H_term = dHp / S_H;
+  return sqrt(L_term * L_term + C_term * C_term + H_term * H_term + R_T * C_term * H_term);
+}
+
+// Squared delta E 2000 in hundredths squared
+uint32_t delta_e2000_sq(lab_t color_1, lab_t color_2){
+  float distance = delta_e2000(color_1, color_2) * 100.0;
+  return (uint32_t)(distance * distance + 0.5);
+}
+
+// Euclidean distance in OKLab
+float oklab_distance(oklab_t color_1, oklab_t color_2){
+  return sqrt((float)oklab_distance_sq(color_1, color_2)) / 10000.0;
+}
@@ -0,0 +1,20 @@
+// ColorsLabFixed.h
+
+// Creator: JDFraire-P
+
+// Description: OKLab conversions in 15-bit fixed point shared by the library modules (internal header)
+
+// L goes from 0 to 32768 (1.0), a and b from -16384 to 16384 (-0.5 to 0.5), the fixed point used inside rgb888_to_oklab and oklab_to_rgb888,
+// so callers that keep OKLab channels in it (gradient stops and spans) skip the ten-thousandths scaling and its divisions.
+
+#ifndef COLORSLABFIXED_H
+#define COLORSLABFIXED_H
+
+#include <ColorsUtils.h>
+
+// Convert RGB888 to OKLab in 15-bit fixed point
+void rgb888_to_oklab_q15(rgb24_t color, int32_t& L, int32_t& a, int32_t& b);
+// Convert OKLab in 15-bit fixed point to RGB888 (L, a and b are clamped to their ranges, no division)
+rgb24_t oklab_q15_to_rgb888(int32_t L, int32_t a, int32_t b);
+
+#endif
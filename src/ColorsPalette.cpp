@@ -0,0 +1,1134 @@
+// ColorsPalette.cpp
+
+// Creator: JDFraire-P
+
+// Description: Sized color palettes with precomputed nearest color search structures
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsPalette.h>
+#include <ColorsStats.h>
+
+/* PALETTE FUNCTIONS */
+
+// Index of the nearest color in colors by linear search (squared euclidean distance in RGB888, first index on ties)
+palette_size_t nearest_color_index(rgb24_t color, const rgb24_t* colors, palette_size_t size){
+  palette_size_t index = PALETTE_NOT_FOUND;
+  uint32_t min_distance = UINT32_MAX;
+  for (palette_size_t i = 0; i < size; i++){
+    uint32_t distance = color_distance_sq(color, colors[i]);
+    if (distance < min_distance){
+      min_distance = distance;
+      index = i;
+      if (distance == 0) break;
+    }
+  }
+  return index;
+}
+
+/* INVERSE COLORMAP */
+
+palette_lut565_t::palette_lut565_t(){
+  table = nullptr;
+  owned = false;
+  progmem = false;
+  build_time = 0;
+}
+
+palette_lut565_t::~palette_lut565_t(){
+  clear();
+}
+
+// Build the table in an owned buffer of PALETTE_LUT565_SIZE bytes
+bool palette_lut565_t::build(const palette_t& palette){
+  // 65536 bytes wrap to 0 with a 16-bit size_t
+  if (!PALETTE_LUT565_ALLOCATABLE || palette.size() == 0 || palette.size() > 256) return false;
+  uint8_t* buffer = (uint8_t*)malloc((size_t)PALETTE_LUT565_SIZE);
+  if (buffer == nullptr) return false;
+  if (!build(palette, buffer)){
+    free(buffer);
+    return false;
+  }
+  owned = true;
+  return true;
+}
+
+// Build the table in a caller buffer of PALETTE_LUT565_SIZE bytes
+bool palette_lut565_t::build(const palette_t& palette, uint8_t* buffer){
+  if (palette.size() == 0 || palette.size() > 256 || buffer == nullptr) return false;
+  uint32_t start = micros();
+  clear();
+
+  // palette channels in RGB565 units, distances are compared in RGB565 space like get_similar_color565
+  uint8_t reds[256], greens[256], blues[256];
+  uint16_t size = (uint16_t)palette.size();
+  for (uint16_t i = 0; i < size; i++){
+    rgb16_t entry = rgb888_to_rgb565(palette[i]);
+    reds[i] = entry.red();
+    greens[i] = entry.green();
+    blues[i] = entry.blue();
+  }
+
+  for (uint32_t value = 0; value < PALETTE_LUT565_SIZE; value++){
+    rgb16_t color((uint16_t)value);
+    int16_t red = color.red(), green = color.green(), blue = color.blue();
+    uint16_t index = 0;
+    uint16_t min_distance = UINT16_MAX;
+    // partial distances skip the entries already farther than the best one (first index on ties)
+    for (uint16_t i = 0; i < size; i++){
+      uint16_t distance = (uint16_t)((red - reds[i]) * (red - reds[i]));
+      if (distance >= min_distance) continue;
+      distance += (uint16_t)((green - greens[i]) * (green - greens[i]));
+      if (distance >= min_distance) continue;
+      distance += (uint16_t)((blue - blues[i]) * (blue - blues[i]));
+      if (distance >= min_distance) continue;
+      min_distance = distance;
+      index = i;
+      if (distance == 0) break;
+    }
+    buffer[value] = (uint8_t)index;
+  }
+
+  table = buffer;
+  build_time = micros() - start;
+  return true;
+}
+
+// Use a prebuilt table
+void palette_lut565_t::attach(const uint8_t* table, bool progmem){
+  clear();
+  this->table = table;
+  this->progmem = progmem;
+}
+
+// Release the table
+void palette_lut565_t::clear(){
+  if (owned) free((void*)table);
+  table = nullptr;
+  owned = false;
+  progmem = false;
+  build_time = 0;
+}
+
+// Nearest palette index of each RGB565 color in src
+void palette_lut565_t::nearest_index(const uint16_t* src, uint8_t* dst, size_t n) const{
+  if (progmem){
+    for (size_t i = 0; i < n; i++) dst[i] = pgm_read_byte(table + src[i]);
+  } else {
+    for (size_t i = 0; i < n; i++) dst[i] = table[src[i]];
+  }
+}
+
+/* CANDIDATE GRID */
+
+palette_grid_t::palette_grid_t(){
+  offsets = nullptr;
+  candidates = nullptr;
+  bits = 0;
+  build_time = 0;
+}
+
+palette_grid_t::~palette_grid_t(){
+  clear();
+}
+
+// Distance from a channel value to the cell range [low, high], and to its farthest end
+static inline void channel_distances(uint8_t value, uint8_t low, uint8_t high, uint8_t& near_distance, uint8_t& far_distance){
+  near_distance = value < low ? low - value : (value > high ? value - high : 0);
+  far_distance = (value - low) > (high - value) ? value - low : high - value;
+}
+
+// Build the grid with 2^bits cells per channel
+bool palette_grid_t::build(const palette_t& palette, uint8_t bits){
+  if (bits < 1) bits = 1;
+  if (bits > 5) bits = 5;
+  uint32_t start = micros();
+  clear();
+
+  const uint8_t cells_per_channel = (uint8_t)(1 << bits);
+  const uint8_t cell_shift = (uint8_t)(8 - bits);
+  const uint16_t cells_count = (uint16_t)1 << (3 * bits);
+  const palette_size_t size = palette.size();
+  const rgb24_t* colors = palette.colors();
+
+  offsets = (palette_size_t*)malloc(((size_t)cells_count + 1) * sizeof(palette_size_t));
+  if (offsets == nullptr) return false;
+  size_t capacity = size > 0 ? size : 1;
+  candidates = (palette_size_t*)malloc(capacity * sizeof(palette_size_t));
+  if (candidates == nullptr){
+    clear();
+    return false;
+  }
+
+  palette_size_t total = 0;
+  uint16_t cell = 0;
+  for (uint8_t red_cell = 0; red_cell < cells_per_channel; red_cell++){
+    for (uint8_t green_cell = 0; green_cell < cells_per_channel; green_cell++){
+      for (uint8_t blue_cell = 0; blue_cell < cells_per_channel; blue_cell++, cell++){
+        uint8_t red_low = (uint8_t)(red_cell << cell_shift), red_high = (uint8_t)(red_low + (1 << cell_shift) - 1);
+        uint8_t green_low = (uint8_t)(green_cell << cell_shift), green_high = (uint8_t)(green_low + (1 << cell_shift) - 1);
+        uint8_t blue_low = (uint8_t)(blue_cell << cell_shift), blue_high = (uint8_t)(blue_low + (1 << cell_shift) - 1);
+
+        // smallest farthest corner distance, bounds the nearest color distance of every point of the cell
+        uint32_t bound = UINT32_MAX;
+        for (palette_size_t i = 0; i < size; i++){
+          uint8_t near_red, far_red, near_green, far_green, near_blue, far_blue;
+          channel_distances(colors[i].red, red_low, red_high, near_red, far_red);
+          channel_distances(colors[i].green, green_low, green_high, near_green, far_green);
+          channel_distances(colors[i].blue, blue_low, blue_high, near_blue, far_blue);
+          uint32_t far_distance = (uint32_t)far_red * far_red + (uint32_t)far_green * far_green + (uint32_t)far_blue * far_blue;
+          if (far_distance < bound) bound = far_distance;
+        }
+
+        offsets[cell] = total;
+        for (palette_size_t i = 0; i < size; i++){
+          uint8_t near_red, far_red, near_green, far_green, near_blue, far_blue;
+          channel_distances(colors[i].red, red_low, red_high, near_red, far_red);
+          channel_distances(colors[i].green, green_low, green_high, near_green, far_green);
+          channel_distances(colors[i].blue, blue_low, blue_high, near_blue, far_blue);
+          uint32_t near_distance = (uint32_t)near_red * near_red + (uint32_t)near_green * near_green + (uint32_t)near_blue * near_blue;
+          if (near_distance > bound) continue;
+          if (total == capacity){
+            palette_size_t* grown = (palette_size_t*)realloc(candidates, 2 * capacity * sizeof(palette_size_t));
+            if (grown == nullptr){
+              clear();
+              return false;
+            }
+            candidates = grown;
+            capacity *= 2;
+          }
+          candidates[total++] = i;
+        }
+      }
+    }
+  }
+  offsets[cells_count] = total;
+
+  this->bits = bits;
+  build_time = micros() - start;
+  return true;
+}
+
+// Release the grid
+void palette_grid_t::clear(){
+  free(offsets);
+  free(candidates);
+  offsets = nullptr;
+  candidates = nullptr;
+  bits = 0;
+  build_time = 0;
+}
+
+// Nearest palette index of a RGB888 color
+palette_size_t palette_grid_t::nearest_index(const palette_t& palette, rgb24_t color) const{
+  const uint8_t cell_shift = (uint8_t)(8 - bits);
+  uint16_t cell = (uint16_t)(((uint16_t)(color.red >> cell_shift) << (2 * bits)) | ((uint16_t)(color.green >> cell_shift) << bits) | (color.blue >> cell_shift));
+  const rgb24_t* colors = palette.colors();
+
+  palette_size_t index = PALETTE_NOT_FOUND;
+  uint32_t min_distance = UINT32_MAX;
+  for (palette_size_t i = offsets[cell]; i < offsets[cell + 1]; i++){
+    uint32_t distance = color_distance_sq(color, colors[candidates[i]]);
+    if (distance < min_distance){
+      min_distance = distance;
+      index = candidates[i];
+    }
+  }
+  return index;
+}
+
+// Heap memory owned by the grid (bytes)
+size_t palette_grid_t::memory_usage() const{
+  if (!ready()) return 0;
+  size_t cells_count = (size_t)1 << (3 * bits);
+  return (cells_count + 1 + offsets[cells_count]) * sizeof(palette_size_t);
+}
+
+// Average candidates per cell
+float palette_grid_t::average_candidates() const{
+  if (!ready()) return 0.0;
+  size_t cells_count = (size_t)1 << (3 * bits);
+  return (float)offsets[cells_count] / (float)cells_count;
+}
+
+/* K-D TREE */
+
+// Channel value of a color (0 red, 1 green, 2 blue)
+static inline uint8_t channel_value(rgb24_t color, uint8_t axis){
+  return axis == 0 ? color.red : (axis == 1 ? color.green : color.blue);
+}
+
+// Tree order of two palette indexes along axis (channel value, then index, so every key is unique)
+static inline bool kd_less(const rgb24_t* colors, uint8_t axis, palette_size_t index_1, palette_size_t index_2){
+  uint8_t value_1 = channel_value(colors[index_1], axis);
+  uint8_t value_2 = channel_value(colors[index_2], axis);
+  return value_1 < value_2 || (value_1 == value_2 && index_1 < index_2);
+}
+
+// Move the k-th index of order[low, high) along axis to position k, smaller ones before it and greater ones after it
+static void kd_select(const rgb24_t* colors, palette_size_t* order, palette_size_t low, palette_size_t high, palette_size_t k, uint8_t axis){
+  while (high - low > 1){
+    palette_size_t middle = low + (high - low) / 2;
+    palette_size_t pivot = order[middle];
+    order[middle] = order[high - 1];
+    order[high - 1] = pivot;
+    palette_size_t store = low;
+    for (palette_size_t i = low; i < high - 1; i++){
+      if (kd_less(colors, axis, order[i], pivot)){
+        palette_size_t swap = order[i];
+        order[i] = order[store];
+        order[store++] = swap;
+      }
+    }
+    order[high - 1] = order[store];
+    order[store] = pivot;
+    if (k == store) return;
+    if (k < store) high = store;
+    else low = store + 1;
+  }
+}
+
+// Build the subtree of order[low, high)
+static void kd_build(const rgb24_t* colors, palette_size_t* order, uint8_t* axes, palette_size_t low, palette_size_t high){
+  if (high <= low) return;
+  palette_size_t middle = low + (high - low) / 2;
+
+  // split on the channel with the largest spread
+  uint8_t minimum[3] = {255, 255, 255};
+  uint8_t maximum[3] = {0, 0, 0};
+  for (palette_size_t i = low; i < high; i++){
+    for (uint8_t axis = 0; axis < 3; axis++){
+      uint8_t value = channel_value(colors[order[i]], axis);
+      if (value < minimum[axis]) minimum[axis] = value;
+      if (value > maximum[axis]) maximum[axis] = value;
+    }
+  }
+  uint8_t axis = 0;
+  for (uint8_t i = 1; i < 3; i++){
+    if (maximum[i] - minimum[i] > maximum[axis] - minimum[axis]) axis = i;
+  }
+
+  kd_select(colors, order, low, high, middle, axis);
+  axes[middle] = axis;
+  kd_build(colors, order, axes, low, middle);
+  kd_build(colors, order, axes, middle + 1, high);
+}
+
+// State of a tree query
+struct kd_query_t{
+  const rgb24_t* colors;
+  const palette_size_t* order;
+  const uint8_t* axes;
+  rgb24_t color;
+  // nearest and k-nearest results, sorted by distance then index
+  palette_size_t* indexes;
+  uint32_t* distances;
+  palette_size_t capacity;
+  palette_size_t count;
+  // radius results
+  uint32_t radius_sq;
+};
+
+// Squared distance of the j-th result of a query
+static inline uint32_t kd_result_distance(const kd_query_t& query, palette_size_t j){
+  return query.distances != nullptr ? query.distances[j] : color_distance_sq(query.color, query.colors[query.indexes[j]]);
+}
+
+// Largest squared distance a new result can have (all distances while the results are not full)
+static inline uint32_t kd_result_bound(const kd_query_t& query){
+  return query.count < query.capacity ? UINT32_MAX : kd_result_distance(query, query.count - 1);
+}
+
+// Insert a palette index in the sorted results if it is one of the capacity nearest
+static void kd_insert(kd_query_t& query, palette_size_t index, uint32_t distance){
+  palette_size_t j = query.count < query.capacity ? query.count : query.capacity - 1;
+  if (query.count == query.capacity){
+    uint32_t worst = kd_result_distance(query, j);
+    if (distance > worst || (distance == worst && index > query.indexes[j])) return;
+  } else {
+    query.count++;
+  }
+  // shift the farther results one position
+  while (j > 0){
+    uint32_t previous = kd_result_distance(query, j - 1);
+    if (previous < distance || (previous == distance && query.indexes[j - 1] < index)) break;
+    query.indexes[j] = query.indexes[j - 1];
+    if (query.distances != nullptr) query.distances[j] = query.distances[j - 1];
+    j--;
+  }
+  query.indexes[j] = index;
+  if (query.distances != nullptr) query.distances[j] = distance;
+}
+
+// Nearest and k-nearest search of the subtree of order[low, high)
+static void kd_search_nearest(kd_query_t& query, palette_size_t low, palette_size_t high){
+  if (high <= low) return;
+  palette_size_t middle = low + (high - low) / 2;
+  palette_size_t index = query.order[middle];
+  kd_insert(query, index, color_distance_sq(query.color, query.colors[index]));
+
+  uint8_t axis = query.axes[middle];
+  int16_t difference = (int16_t)channel_value(query.color, axis) - channel_value(query.colors[index], axis);
+  if (difference < 0){
+    kd_search_nearest(query, low, middle);
+    if ((uint32_t)((int32_t)difference * difference) <= kd_result_bound(query)) kd_search_nearest(query, middle + 1, high);
+  } else {
+    kd_search_nearest(query, middle + 1, high);
+    if ((uint32_t)((int32_t)difference * difference) <= kd_result_bound(query)) kd_search_nearest(query, low, middle);
+  }
+}
+
+// Radius search of the subtree of order[low, high)
+static void kd_search_radius(kd_query_t& query, palette_size_t low, palette_size_t high){
+  if (high <= low) return;
+  palette_size_t middle = low + (high - low) / 2;
+  palette_size_t index = query.order[middle];
+  if (color_distance_sq(query.color, query.colors[index]) <= query.radius_sq){
+    if (query.count < query.capacity) query.indexes[query.count] = index;
+    query.count++;
+  }
+
+  uint8_t axis = query.axes[middle];
+  int16_t difference = (int16_t)channel_value(query.color, axis) - channel_value(query.colors[index], axis);
+  bool reaches_other_side = (uint32_t)((int32_t)difference * difference) <= query.radius_sq;
+  if (difference < 0 || reaches_other_side) kd_search_radius(query, low, middle);
+  if (difference >= 0 || reaches_other_side) kd_search_radius(query, middle + 1, high);
+}
+
+// Empty query over colors (order and axes are null for the linear fallbacks)
+static kd_query_t kd_make_query(const rgb24_t* colors, const palette_size_t* order, const uint8_t* axes, rgb24_t color){
+  kd_query_t query;
+  query.colors = colors;
+  query.order = order;
+  query.axes = axes;
+  query.color = color;
+  query.indexes = nullptr;
+  query.distances = nullptr;
+  query.capacity = 0;
+  query.count = 0;
+  query.radius_sq = 0;
+  return query;
+}
+
+palette_kdtree_t::palette_kdtree_t(){
+  order = nullptr;
+  axes = nullptr;
+  size = 0;
+  build_time = 0;
+}
+
+palette_kdtree_t::~palette_kdtree_t(){
+  clear();
+}
+
+// Build the tree
+bool palette_kdtree_t::build(const palette_t& palette){
+  uint32_t start = micros();
+  clear();
+  palette_size_t count = palette.size();
+  order = (palette_size_t*)malloc((count > 0 ? count : 1) * sizeof(palette_size_t));
+  axes = (uint8_t*)malloc(count > 0 ? count : 1);
+  if (order == nullptr || axes == nullptr){
+    clear();
+    return false;
+  }
+  for (palette_size_t i = 0; i < count; i++) order[i] = i;
+  kd_build(palette.colors(), order, axes, 0, count);
+  size = count;
+  build_time = micros() - start;
+  return true;
+}
+
+// Release the tree
+void palette_kdtree_t::clear(){
+  free(order);
+  free(axes);
+  order = nullptr;
+  axes = nullptr;
+  size = 0;
+  build_time = 0;
+}
+
+// Nearest palette index of a RGB888 color
+palette_size_t palette_kdtree_t::nearest_index(const palette_t& palette, rgb24_t color) const{
+  palette_size_t index = PALETTE_NOT_FOUND;
+  uint32_t distance = UINT32_MAX;
+  kd_query_t query = kd_make_query(palette.colors(), order, axes, color);
+  query.indexes = &index;
+  query.distances = &distance;
+  query.capacity = 1;
+  kd_search_nearest(query, 0, size);
+  return index;
+}
+
+// Up to k nearest palette indexes sorted by distance (then index)
+palette_size_t palette_kdtree_t::k_nearest(const palette_t& palette, rgb24_t color, palette_size_t k, palette_size_t* indexes, uint32_t* distances) const{
+  if (k == 0) return 0;
+  kd_query_t query = kd_make_query(palette.colors(), order, axes, color);
+  query.indexes = indexes;
+  query.distances = distances;
+  query.capacity = k;
+  kd_search_nearest(query, 0, size);
+  return query.count;
+}
+
+// Palette indexes within squared distance radius_sq
+palette_size_t palette_kdtree_t::radius_search(const palette_t& palette, rgb24_t color, uint32_t radius_sq, palette_size_t* indexes, palette_size_t max_count) const{
+  kd_query_t query = kd_make_query(palette.colors(), order, axes, color);
+  query.indexes = indexes;
+  query.capacity = max_count;
+  query.radius_sq = radius_sq;
+  kd_search_radius(query, 0, size);
+  return query.count;
+}
+
+/* PALETTE */
+
+// Cache reused (hit) or built on this call (miss)
+#define STATS_CACHE(cache) COLORS_STATS_COUNT(COLORS_STATS_PALETTE, (cache) != nullptr ? COLORS_STATS_HITS : COLORS_STATS_MISSES, 1)
+
+palette_t::palette_t(const rgb24_t* colors, palette_size_t size, uint8_t index_flags){
+  list = colors;
+  owned = nullptr;
+  count = size;
+  budget = PALETTE_BUDGET_UNLIMITED;
+  selected_index = index_flags;
+  pending_index = index_flags;
+  name_list = nullptr;
+  name_order = nullptr;
+  value_order = nullptr;
+  lab = nullptr;
+  oklab = nullptr;
+  packed565 = nullptr;
+  luminance_index = nullptr;
+}
+
+palette_t::~palette_t(){
+  clear_index();
+  free(owned);
+}
+
+// Change the color at index
+bool palette_t::set_color(palette_size_t index, rgb24_t color){
+  if (index >= count) return false;
+  if (list[index].value() == color.value()) return true;
+  // the caller list is never written, the colors are copied on the first change
+  if (owned == nullptr){
+    owned = (rgb24_t*)malloc((size_t)count * sizeof(rgb24_t));
+    if (owned == nullptr) return false;
+    memcpy(owned, list, (size_t)count * sizeof(rgb24_t));
+    list = owned;
+  }
+  owned[index] = color;
+  invalidate();
+  return true;
+}
+
+// The colors were changed in place by the caller
+void palette_t::invalidate(){
+  uint8_t index_flags = selected_index;
+  clear_index();
+  selected_index = index_flags;
+  pending_index = index_flags;
+}
+
+// Allocate a cache of count entries if it fits in the budget
+void* palette_t::allocate_cache(size_t entry_size) const{
+  size_t bytes = (size_t)count * entry_size;
+  if (count == 0 || !fits(bytes)) return nullptr;
+  return malloc(bytes);
+}
+
+// Build the structures selected in index_flags now
+bool palette_t::build_index(uint8_t index_flags){
+  COLORS_STATS_SCOPE(COLORS_STATS_PALETTE, count);
+  COLORS_STATS_COUNT(COLORS_STATS_PALETTE, COLORS_STATS_MISSES, ((index_flags & PALETTE_INDEX_LUT565) != 0) + ((index_flags & PALETTE_INDEX_GRID) != 0) + ((index_flags & PALETTE_INDEX_KDTREE) != 0));
+  bool built = true;
+  selected_index |= index_flags;
+  if (index_flags & PALETTE_INDEX_GRID){
+    cells.clear();
+    built = cells.build(*this) && built;
+    // the grid size is only known once built
+    if (cells.ready() && index_memory_usage() > budget){
+      cells.clear();
+      built = false;
+    }
+  }
+  if (index_flags & PALETTE_INDEX_LUT565){
+    lut.clear();
+    built = PALETTE_LUT565_ALLOCATABLE && fits((size_t)PALETTE_LUT565_SIZE) && lut.build(*this) && built;
+  }
+  if (index_flags & PALETTE_INDEX_KDTREE){
+    tree.clear();
+    built = fits((size_t)count * (sizeof(palette_size_t) + 1)) && tree.build(*this) && built;
+  }
+  pending_index &= (uint8_t)~index_flags;
+  return built;
+}
+
+// Release every search structure
+void palette_t::clear_index(){
+  lut.clear();
+  cells.clear();
+  tree.clear();
+  free(name_order);
+  free(value_order);
+  free(lab);
+  free(oklab);
+  free(packed565);
+  free(luminance_index);
+  name_order = nullptr;
+  value_order = nullptr;
+  lab = nullptr;
+  oklab = nullptr;
+  packed565 = nullptr;
+  luminance_index = nullptr;
+  selected_index = PALETTE_INDEX_NONE;
+  pending_index = PALETTE_INDEX_NONE;
+}
+
+// Limit the heap memory of the search structures and caches
+void palette_t::set_memory_budget(size_t bytes){
+  budget = bytes;
+  // the caches are built again within the new budget on next use
+  if (index_memory_usage() > budget) invalidate();
+}
+
+// Heap memory owned by the search structures and the color caches
+size_t palette_t::index_memory_usage() const{
+  size_t caches = (lab != nullptr ? count * sizeof(lab_t) : 0) + (oklab != nullptr ? count * sizeof(oklab_t) : 0)
+                + (packed565 != nullptr ? count * sizeof(uint16_t) : 0)
+                + ((name_order != nullptr) + (value_order != nullptr) + (luminance_index != nullptr)) * count * sizeof(palette_size_t);
+  return lut.memory_usage() + cells.memory_usage() + tree.memory_usage() + caches;
+}
+
+// Build the selected structures that are not built yet
+void palette_t::ensure_index() const{
+  if (pending_index == PALETTE_INDEX_NONE) return;
+  const_cast<palette_t*>(this)->build_index(pending_index);
+}
+
+// Index of the nearest color
+palette_size_t palette_t::nearest_index(rgb24_t color) const{
+  ensure_index();
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, cells.ready() || tree.ready() ? COLORS_STATS_HITS : COLORS_STATS_MISSES, 1);
+  if (cells.ready()) return cells.nearest_index(*this, color);
+  if (tree.ready()) return tree.nearest_index(*this, color);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, count);
+  return nearest_color_index(color, list, count);
+}
+
+// Index of the nearest color to a RGB565 color
+palette_size_t palette_t::nearest_index(rgb16_t color) const{
+  return nearest_index_rgb565(color);
+}
+
+// Nearest color index of each RGB565 color in src
+void palette_t::nearest_index(const uint16_t* src, uint8_t* dst, size_t n) const{
+  ensure_index();
+  if (lut.ready()){
+    COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, n);
+    COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_HITS, n);
+    lut.nearest_index(src, dst, n);
+    return;
+  }
+  for (size_t i = 0; i < n; i++) dst[i] = (uint8_t)nearest_index(rgb16_t(src[i]));
+}
+
+// Nearest color index of each RGB888 color in src
+void palette_t::nearest_index(const rgb24_t* src, uint8_t* dst, size_t n) const{
+  ensure_index();
+  for (size_t i = 0; i < n; i++) dst[i] = (uint8_t)nearest_index(src[i]);
+}
+
+// Up to k nearest color indexes sorted by distance (then index)
+palette_size_t palette_t::k_nearest(rgb24_t color, palette_size_t k, palette_size_t* indexes, uint32_t* distances) const{
+  ensure_index();
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, tree.ready() ? COLORS_STATS_HITS : COLORS_STATS_MISSES, 1);
+  if (tree.ready()) return tree.k_nearest(*this, color, k, indexes, distances);
+  if (k == 0) return 0;
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, count);
+  kd_query_t query = kd_make_query(list, nullptr, nullptr, color);
+  query.indexes = indexes;
+  query.distances = distances;
+  query.capacity = k;
+  for (palette_size_t i = 0; i < count; i++) kd_insert(query, i, color_distance_sq(color, list[i]));
+  return query.count;
+}
+
+// Color indexes within squared distance radius_sq
+palette_size_t palette_t::radius_search(rgb24_t color, uint32_t radius_sq, palette_size_t* indexes, palette_size_t max_count) const{
+  ensure_index();
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, tree.ready() ? COLORS_STATS_HITS : COLORS_STATS_MISSES, 1);
+  if (tree.ready()) return tree.radius_search(*this, color, radius_sq, indexes, max_count);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, count);
+  palette_size_t found = 0;
+  for (palette_size_t i = 0; i < count; i++){
+    if (color_distance_sq(color, list[i]) > radius_sq) continue;
+    if (found < max_count) indexes[found] = i;
+    found++;
+  }
+  return found;
+}
+
+/* LOOKUP INDEXES */
+
+// Sift the element at root down the heap of the first size elements
+template <typename LESS>
+static void sift_down(palette_size_t* order, palette_size_t root, palette_size_t size, LESS less){
+  while (true){
+    palette_size_t child = 2 * root + 1;
+    if (child >= size) return;
+    if (child + 1 < size && less(order[child], order[child + 1])) child++;
+    if (!less(order[root], order[child])) return;
+    palette_size_t swap = order[root];
+    order[root] = order[child];
+    order[child] = swap;
+    root = child;
+  }
+}
+
+// Sort color indexes with a strict order (heap sort, no recursion and no extra memory)
+template <typename LESS>
+static void sort_indexes(palette_size_t* order, palette_size_t size, LESS less){
+  for (palette_size_t i = 0; i < size; i++) order[i] = i;
+  for (palette_size_t i = size / 2; i > 0; i--) sift_down(order, i - 1, size, less);
+  for (palette_size_t end = size; end > 1; end--){
+    palette_size_t swap = order[0];
+    order[0] = order[end - 1];
+    order[end - 1] = swap;
+    sift_down(order, 0, end - 1, less);
+  }
+}
+
+// First position of order whose entry is not below the key (compare returns the sign of entry - key)
+template <typename COMPARE>
+static palette_size_t lower_bound_index(const palette_size_t* order, palette_size_t size, COMPARE compare){
+  palette_size_t low = 0;
+  palette_size_t high = size;
+  while (low < high){
+    palette_size_t middle = low + (high - low) / 2;
+    if (compare(order[middle]) < 0) low = middle + 1;
+    else high = middle;
+  }
+  return low;
+}
+
+// Name the colors
+void palette_t::set_names(const char* const* names){
+  name_list = names;
+  free(name_order);
+  name_order = nullptr;
+}
+
+// Index of a color by name
+palette_size_t palette_t::find_name(const char* name) const{
+  // the COLORS list has its names in the built-in sorted table
+  if (name_list == nullptr){
+    if (list != COLORS || count != COLORS_COUNT) return PALETTE_NOT_FOUND;
+    uint8_t index = find_color_by_name(name);
+    return index == COLOR_NOT_FOUND ? PALETTE_NOT_FOUND : index;
+  }
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  const char* const* names = name_list;
+  STATS_CACHE(name_order);
+  if (name_order == nullptr){
+    COLORS_STATS_SCOPE(COLORS_STATS_PALETTE, count);
+    name_order = (palette_size_t*)allocate_cache(sizeof(palette_size_t));
+    if (name_order != nullptr){
+      sort_indexes(name_order, count, [names](palette_size_t index_1, palette_size_t index_2){
+        int order = strcasecmp(names[index_1], names[index_2]);
+        return order < 0 || (order == 0 && index_1 < index_2);
+      });
+    }
+  }
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, name_order != nullptr ? COLORS_STATS_HITS : COLORS_STATS_MISSES, 1);
+  // linear search if the index cannot be allocated or does not fit in the budget
+  if (name_order == nullptr){
+    COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_ENTRIES, count);
+    for (palette_size_t i = 0; i < count; i++){
+      if (strcasecmp(names[i], name) == 0) return i;
+    }
+    return PALETTE_NOT_FOUND;
+  }
+  palette_size_t position = lower_bound_index(name_order, count, [names, name](palette_size_t index){ return strcasecmp(names[index], name); });
+  if (position < count && strcasecmp(names[name_order[position]], name) == 0) return name_order[position];
+  return PALETTE_NOT_FOUND;
+}
+
+// Index of a color by exact value
+palette_size_t palette_t::find_color(rgb24_t color) const{
+  if (list == COLORS && count == COLORS_COUNT){
+    uint8_t index = find_color_by_hex(color.value());
+    return index == COLOR_NOT_FOUND ? PALETTE_NOT_FOUND : index;
+  }
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  const rgb24_t* colors = list;
+  STATS_CACHE(value_order);
+  if (value_order == nullptr){
+    COLORS_STATS_SCOPE(COLORS_STATS_PALETTE, count);
+    value_order = (palette_size_t*)allocate_cache(sizeof(palette_size_t));
+    if (value_order != nullptr){
+      sort_indexes(value_order, count, [colors](palette_size_t index_1, palette_size_t index_2){
+        return colors[index_1].value() < colors[index_2].value() || (colors[index_1].value() == colors[index_2].value() && index_1 < index_2);
+      });
+    }
+  }
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, value_order != nullptr ? COLORS_STATS_HITS : COLORS_STATS_MISSES, 1);
+  // linear search if the index cannot be allocated or does not fit in the budget
+  if (value_order == nullptr){
+    COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_ENTRIES, count);
+    for (palette_size_t i = 0; i < count; i++){
+      if (colors[i].value() == color.value()) return i;
+    }
+    return PALETTE_NOT_FOUND;
+  }
+  uint32_t value = color.value();
+  palette_size_t position = lower_bound_index(value_order, count, [colors, value](palette_size_t index){ return colors[index].value() < value ? -1 : (colors[index].value() > value ? 1 : 0); });
+  if (position < count && colors[value_order[position]].value() == value) return value_order[position];
+  return PALETTE_NOT_FOUND;
+}
+
+/* PERCEPTUAL COLOR CACHES */
+
+// Colors converted to CIELAB on first use
+const lab_t* palette_t::lab_colors() const{
+  STATS_CACHE(lab);
+  if (lab == nullptr){
+    COLORS_STATS_SCOPE(COLORS_STATS_PALETTE, count);
+    lab = (lab_t*)allocate_cache(sizeof(lab_t));
+    if (lab != nullptr) convert_rgb888_to_lab(list, lab, count);
+  }
+  return lab;
+}
+
+// Colors converted to OKLab on first use
+const oklab_t* palette_t::oklab_colors() const{
+  STATS_CACHE(oklab);
+  if (oklab == nullptr){
+    COLORS_STATS_SCOPE(COLORS_STATS_PALETTE, count);
+    oklab = (oklab_t*)allocate_cache(sizeof(oklab_t));
+    if (oklab != nullptr) convert_rgb888_to_oklab(list, oklab, count);
+  }
+  return oklab;
+}
+
+/* RGB565 AND LUMINANCE CACHES */
+
+// Luminance of a color (Rec. 601 weights, 0 to 255)
+static inline uint8_t color_luminance(rgb24_t color){
+  return (uint8_t)((77 * (uint16_t)color.red + 150 * (uint16_t)color.green + 29 * (uint16_t)color.blue + 128) >> 8);
+}
+
+// Colors packed to RGB565 on first use
+const uint16_t* palette_t::rgb565_colors() const{
+  STATS_CACHE(packed565);
+  if (packed565 == nullptr){
+    COLORS_STATS_SCOPE(COLORS_STATS_PALETTE, count);
+    packed565 = (uint16_t*)allocate_cache(sizeof(uint16_t));
+    if (packed565 != nullptr) convert_rgb888_to_rgb565((const uint8_t*)list, packed565, count);
+  }
+  return packed565;
+}
+
+// Color indexes sorted by luminance then index on first use
+const palette_size_t* palette_t::luminance_order() const{
+  STATS_CACHE(luminance_index);
+  if (luminance_index == nullptr){
+    COLORS_STATS_SCOPE(COLORS_STATS_PALETTE, count);
+    luminance_index = (palette_size_t*)allocate_cache(sizeof(palette_size_t));
+    const rgb24_t* colors = list;
+    if (luminance_index != nullptr){
+      sort_indexes(luminance_index, count, [colors](palette_size_t index_1, palette_size_t index_2){
+        uint8_t luminance_1 = color_luminance(colors[index_1]);
+        uint8_t luminance_2 = color_luminance(colors[index_2]);
+        return luminance_1 < luminance_2 || (luminance_1 == luminance_2 && index_1 < index_2);
+      });
+    }
+  }
+  return luminance_index;
+}
+
+// Index of the nearest color to a RGB565 color compared in RGB565 space
+palette_size_t palette_t::nearest_index_rgb565(rgb16_t color) const{
+  ensure_index();
+  if (lut.ready()){
+    // a single load, counted without timing
+    COLORS_STATS_CALL(COLORS_STATS_SIMILARITY, 1);
+    COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_HITS, 1);
+    return lut.nearest_index(color);
+  }
+  const uint16_t* packed = rgb565_colors();
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_MISSES, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, count);
+  palette_size_t index = PALETTE_NOT_FOUND;
+  uint16_t min_distance = UINT16_MAX;
+  for (palette_size_t i = 0; i < count; i++){
+    rgb16_t entry = packed != nullptr ? rgb16_t(packed[i]) : rgb888_to_rgb565(list[i]);
+    uint16_t distance = color_distance_sq(color, entry);
+    if (index == PALETTE_NOT_FOUND || distance < min_distance){
+      min_distance = distance;
+      index = i;
+      if (distance == 0) break;
+    }
+  }
+  return index;
+}
+
+// Index of the color with the nearest luminance
+palette_size_t palette_t::nearest_luminance(uint8_t luminance) const{
+  const palette_size_t* order = luminance_order();
+  const rgb24_t* colors = list;
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, order != nullptr ? COLORS_STATS_HITS : COLORS_STATS_MISSES, 1);
+  // linear search if the order cannot be allocated or does not fit in the budget
+  if (order == nullptr){
+    COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_ENTRIES, count);
+    palette_size_t index = PALETTE_NOT_FOUND;
+    int16_t best_luminance = 0;
+    for (palette_size_t i = 0; i < count; i++){
+      int16_t entry = color_luminance(colors[i]);
+      if (index == PALETTE_NOT_FOUND || abs(entry - luminance) < abs(best_luminance - luminance)
+          || (abs(entry - luminance) == abs(best_luminance - luminance) && entry < best_luminance)){
+        best_luminance = entry;
+        index = i;
+      }
+    }
+    return index;
+  }
+  // first entry not below the luminance, or the first entry of the luminance just below it
+  palette_size_t position = lower_bound_index(order, count, [colors, luminance](palette_size_t index){ return (int16_t)color_luminance(colors[index]) - luminance; });
+  if (position > 0){
+    uint8_t below = color_luminance(colors[order[position - 1]]);
+    if (position == count || luminance - below <= color_luminance(colors[order[position]]) - luminance){
+      position = lower_bound_index(order, count, [colors, below](palette_size_t index){ return (int16_t)color_luminance(colors[index]) - below; });
+    }
+  }
+  return position < count ? order[position] : PALETTE_NOT_FOUND;
+}
+
+// RGB565 color of each palette index in src
+void palette_t::expand_rgb565(const uint8_t* src, uint16_t* dst, size_t n) const{
+  const uint16_t* packed = rgb565_colors();
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  if (packed != nullptr){
+    for (size_t i = 0; i < n; i++) dst[i] = packed[src[i]];
+    return;
+  }
+  for (size_t i = 0; i < n; i++) dst[i] = rgb888_to_rgb565(list[src[i]]).value;
+}
+
+// Perceptual distance of two CIELAB colors (COLOR_METRIC_CIE76 or COLOR_METRIC_CIEDE2000)
+static inline uint32_t perceptual_distance_sq(lab_t color_1, lab_t color_2, color_metric_t metric){
+  return metric == COLOR_METRIC_CIEDE2000 ? delta_e2000_sq(color_1, color_2) : delta_e76_sq(color_1, color_2);
+}
+
+// Perceptual distance of two OKLab colors
+static inline uint32_t perceptual_distance_sq(oklab_t color_1, oklab_t color_2, color_metric_t){
+  return oklab_distance_sq(color_1, color_2);
+}
+
+// Perceptual palette entry, from the cache or converted from the color when the cache does not fit in the budget
+static inline lab_t perceptual_entry(const lab_t* entries, const rgb24_t* colors, palette_size_t index){
+  return entries != nullptr ? entries[index] : rgb888_to_lab(colors[index]);
+}
+
+static inline oklab_t perceptual_entry(const oklab_t* entries, const rgb24_t* colors, palette_size_t index){
+  return entries != nullptr ? entries[index] : rgb888_to_oklab(colors[index]);
+}
+
+// Nearest entry of a perceptual color list (first index on ties, entries nullptr: converted from colors)
+template <typename T>
+static palette_size_t nearest_perceptual_index(T color, const T* entries, const rgb24_t* colors, palette_size_t size, color_metric_t metric){
+  palette_size_t index = PALETTE_NOT_FOUND;
+  uint32_t min_distance = UINT32_MAX;
+  for (palette_size_t i = 0; i < size; i++){
+    uint32_t distance = perceptual_distance_sq(color, perceptual_entry(entries, colors, i), metric);
+    if (distance < min_distance){
+      min_distance = distance;
+      index = i;
+      if (distance == 0) break;
+    }
+  }
+  return index;
+}
+
+// Index of the nearest color with a metric
+palette_size_t palette_t::nearest_index(rgb24_t color, color_metric_t metric, const color_weights_t& weights) const{
+  if (metric == COLOR_METRIC_EUCLIDEAN) return nearest_index(color);
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_MISSES, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, count);
+  switch (metric){
+    case COLOR_METRIC_CIE76:
+    case COLOR_METRIC_CIEDE2000: return nearest_perceptual_index(rgb888_to_lab(color), lab_colors(), list, count, metric);
+    case COLOR_METRIC_OKLAB: return nearest_perceptual_index(rgb888_to_oklab(color), oklab_colors(), list, count, metric);
+    default: break;
+  }
+  palette_size_t index = PALETTE_NOT_FOUND;
+  uint32_t min_distance = UINT32_MAX;
+  for (palette_size_t i = 0; i < count; i++){
+    uint32_t distance = color_distance_sq(color, list[i], metric, weights);
+    if (distance < min_distance){
+      min_distance = distance;
+      index = i;
+    }
+  }
+  return index;
+}
+
+/* BATCHED TOP-K */
+
+// Number of queries sharing each pass over the palette
+#define TOP_K_BLOCK 16
+
+// One pass over the palette for the distinct queries of a block (the metric is a template argument so the inner loop has no switch)
+template <color_metric_t METRIC>
+static void top_k_pass(kd_query_t* block, uint8_t block_size, const uint8_t* source, const palette_t& palette, const color_weights_t& weights){
+  const rgb24_t* colors = palette.colors();
+  for (palette_size_t i = 0; i < palette.size(); i++){
+    rgb24_t color = colors[i];
+    for (uint8_t q = 0; q < block_size; q++){
+      if (source[q] != q) continue;
+      uint32_t distance = color_distance_sq(block[q].color, color, METRIC, weights);
+      // most entries are rejected here without entering the insertion
+      if (block[q].count == block[q].capacity && distance > block[q].distances[block[q].capacity - 1]) continue;
+      kd_insert(block[q], i, distance);
+    }
+  }
+}
+
+// One pass over the perceptual palette colors for the distinct queries of a block (queries already converted, entries nullptr: converted from colors)
+template <typename T>
+static void top_k_pass_perceptual(kd_query_t* block, uint8_t block_size, const uint8_t* source, const T* converted, const T* entries, const rgb24_t* colors, palette_size_t size, color_metric_t metric){
+  for (palette_size_t i = 0; i < size; i++){
+    T entry = perceptual_entry(entries, colors, i);
+    for (uint8_t q = 0; q < block_size; q++){
+      if (source[q] != q) continue;
+      uint32_t distance = perceptual_distance_sq(converted[q], entry, metric);
+      if (block[q].count == block[q].capacity && distance > block[q].distances[block[q].capacity - 1]) continue;
+      kd_insert(block[q], i, distance);
+    }
+  }
+}
+
+// k nearest palette indexes of each query
+palette_size_t top_k(const rgb24_t* queries, size_t n, const palette_t& palette, palette_size_t k, palette_size_t* indexes, uint32_t* distances, color_metric_t metric, const color_weights_t& weights){
+  palette_size_t found = k < palette.size() ? k : palette.size();
+  if (found == 0 || n == 0) return found;
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, n);
+
+  // perceptual metrics compare against the palette caches (or convert the palette colors in each pass)
+  const lab_t* lab = nullptr;
+  const oklab_t* oklab = nullptr;
+  if (metric == COLOR_METRIC_CIE76 || metric == COLOR_METRIC_CIEDE2000) lab = palette.lab_colors();
+  else if (metric == COLOR_METRIC_OKLAB) oklab = palette.oklab_colors();
+
+  // distances of the results are needed to rank them, keep them in a scratch buffer if the caller does not want them
+  // (found results per query, k is only the stride of the caller arrays)
+  uint32_t* scratch = nullptr;
+  if (distances == nullptr){
+    if (found > (size_t)-1 / (TOP_K_BLOCK * sizeof(uint32_t))) return 0;
+    scratch = (uint32_t*)malloc((size_t)TOP_K_BLOCK * found * sizeof(uint32_t));
+    if (scratch == nullptr) return 0;
+  }
+
+  kd_query_t block[TOP_K_BLOCK];
+  uint8_t source[TOP_K_BLOCK]; // query of the block that computes the results of each query
+  for (size_t first = 0; first < n; first += TOP_K_BLOCK){
+    uint8_t block_size = (uint8_t)(n - first < TOP_K_BLOCK ? n - first : TOP_K_BLOCK);
+    for (uint8_t q = 0; q < block_size; q++){
+      block[q] = kd_make_query(palette.colors(), nullptr, nullptr, queries[first + q]);
+      block[q].indexes = indexes + (first + q) * k;
+      block[q].distances = scratch != nullptr ? scratch + (size_t)q * found : distances + (first + q) * k;
+      block[q].capacity = found;
+      // repeated queries (flat image areas, idle sensors) reuse the results of their first occurrence
+      source[q] = q;
+      for (uint8_t p = 0; p < q; p++){
+        if (block[p].color.value() == block[q].color.value()){
+          source[q] = p;
+          break;
+        }
+      }
+    }
+
+#if COLORSUTILS_STATS
+    // distinct queries scan the palette (misses), repeated queries reuse their results (hits)
+    uint8_t distinct = 0;
+    for (uint8_t q = 0; q < block_size; q++) distinct += source[q] == q;
+    COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_MISSES, distinct);
+    COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_HITS, block_size - distinct);
+    COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, (colors_stats_count_t)distinct * palette.size());
+#endif
+
+    switch (metric){
+      case COLOR_METRIC_WEIGHTED: top_k_pass<COLOR_METRIC_WEIGHTED>(block, block_size, source, palette, weights); break;
+      case COLOR_METRIC_REDMEAN: top_k_pass<COLOR_METRIC_REDMEAN>(block, block_size, source, palette, weights); break;
+      case COLOR_METRIC_CIE76:
+      case COLOR_METRIC_CIEDE2000: {
+        lab_t converted[TOP_K_BLOCK];
+        for (uint8_t q = 0; q < block_size; q++) converted[q] = rgb888_to_lab(block[q].color);
+        top_k_pass_perceptual(block, block_size, source, converted, lab, palette.colors(), palette.size(), metric);
+        break;
+      }
+      case COLOR_METRIC_OKLAB: {
+        oklab_t converted[TOP_K_BLOCK];
+        for (uint8_t q = 0; q < block_size; q++) converted[q] = rgb888_to_oklab(block[q].color);
+        top_k_pass_perceptual(block, block_size, source, converted, oklab, palette.colors(), palette.size(), metric);
+        break;
+      }
+      default: top_k_pass<COLOR_METRIC_EUCLIDEAN>(block, block_size, source, palette, weights); break;
+    }
+
+    for (uint8_t q = 0; q < block_size; q++){
+      if (source[q] == q) continue;
+      memcpy(block[q].indexes, block[source[q]].indexes, found * sizeof(palette_size_t));
+      memcpy(block[q].distances, block[source[q]].distances, found * sizeof(uint32_t));
+    }
+  }
+
+  free(scratch);
+  return found;
+}
+
+/* PALETTE COLOR LIST FUNCTIONS */
+
+// Palette color as a named color struct (named if the palette is over the COLORS list or has names)
+static rgb888_t get_palette_color(const palette_t& palette, palette_size_t index){
+  if (palette.colors() == COLORS && index < COLORS_COUNT) return get_named_color((uint8_t)index);
+  if (palette.names() != nullptr) return rgb888_t(palette.names()[index], palette[index].value());
+  return rgb888_t(palette[index]);
+}
+
+// Most similar palette color with a metric
+rgb888_t get_similar_color888(const rgb888_t& rgb888, const palette_t& palette, color_metric_t metric){
+  palette_size_t index = palette.nearest_index(rgb24_t(rgb888), metric);
+  if (index == PALETTE_NOT_FOUND) return rgb888_t();
+  return get_palette_color(palette, index);
+}
+
+// Most similar palette color to a RGB565 color with a metric
+rgb565_t get_similar_color565(const rgb565_t& rgb565, const palette_t& palette, color_metric_t metric){
+  // Euclidean compares in RGB565 space like get_similar_color565 over a list (inverse colormap if built), the other metrics in RGB888
+  palette_size_t index = metric == COLOR_METRIC_EUCLIDEAN ? palette.nearest_index(rgb16_t(rgb565)) : palette.nearest_index(rgb565_to_rgb888(rgb16_t(rgb565)), metric);
+  if (index == PALETTE_NOT_FOUND) return rgb565_t();
+  return rgb888_to_rgb565(get_palette_color(palette, index));
+}
+
+// Palette color by name
+rgb888_t get_color_by_name(const char* name, const palette_t& palette){
+  palette_size_t index = palette.find_name(name);
+  if (index == PALETTE_NOT_FOUND) return rgb888_t();
+  return get_palette_color(palette, index);
+}
+
+// Palette color by hex color code
+rgb888_t get_color_by_hex(int hex_color_code, const palette_t& palette){
+  palette_size_t index = palette.find_color(rgb24_t((uint32_t)hex_color_code));
+  if (index == PALETTE_NOT_FOUND) return rgb888_t();
+  return get_palette_color(palette, index);
+}
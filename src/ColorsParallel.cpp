@@ -0,0 +1,280 @@
+// ColorsParallel.cpp
+
+// Creator: JDFraire-P
+
+// Description: Multi-threaded tiled image conversion engine for host tooling (RGB888 to RGB565 or packed palette indexes)
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsParallel.h>
+
+#if !defined(ARDUINO)
+
+#include <thread>
+#include <mutex>
+
+/* ENGINE STATE */
+
+// Rows [first, last) of an image
+struct image_converter_t::task_t{
+  const image_job_t* job;
+  size_t first;
+  size_t last;
+};
+
+// Task range and scratch buffers of a worker
+struct image_converter_t::worker_t{
+  std::mutex lock;
+  size_t begin; // next task of the range
+  size_t end; // end of the range
+  const task_t* tasks;
+  rgb24_t* row; // gamma corrected source row
+  uint8_t* indexes; // palette indexes of a row before packing
+  size_t steals;
+  bool ok;
+};
+
+image_converter_t::image_converter_t(unsigned threads){
+  workers = threads != 0 ? threads : std::thread::hardware_concurrency();
+  if (workers == 0) workers = 1;
+  gamma = nullptr;
+  palette = nullptr;
+  index_bits = 8;
+  big_endian = false;
+  method = DITHER_NONE;
+  tile_bytes = IMAGE_TILE_BYTES;
+  task_count = 0;
+  steal_count = 0;
+}
+
+image_converter_t::~image_converter_t(){
+  free(gamma);
+}
+
+/* PIPELINE SETTINGS */
+
+// Apply a channel table of 256 entries before quantization
+void image_converter_t::set_gamma_lut(const uint8_t* lut){
+  if (lut == nullptr){
+    free(gamma);
+    gamma = nullptr;
+    return;
+  }
+  if (gamma == nullptr) gamma = (uint8_t*)malloc(256);
+  if (gamma != nullptr) memcpy(gamma, lut, 256);
+}
+
+// Apply a power law to the channels before quantization
+void image_converter_t::set_gamma(float value){
+  if (value == 1.0f || value <= 0.0f){
+    set_gamma_lut(nullptr);
+    return;
+  }
+  uint8_t lut[256];
+  for (uint16_t c = 0; c < 256; c++) lut[c] = (uint8_t)(255.0 * pow(c / 255.0, (double)value) + 0.5);
+  set_gamma_lut(lut);
+}
+
+// Quantize to RGB565 words
+void image_converter_t::set_rgb565(bool big_endian){
+  palette = nullptr;
+  index_bits = 8;
+  this->big_endian = big_endian;
+}
+
+// Map to palette indexes
+void image_converter_t::set_palette(const palette_t* palette, uint8_t index_bits){
+  this->palette = palette;
+  this->index_bits = index_bits;
+}
+
+// Dithering method
+void image_converter_t::set_dither(dither_method_t method){
+  this->method = method;
+}
+
+// Source bytes of a band
+void image_converter_t::set_tile_bytes(size_t bytes){
+  tile_bytes = bytes;
+}
+
+// Rows of a band, a multiple of 8 so the Bayer rows of each band start where the single-threaded pass is
+size_t image_converter_t::band_rows(size_t width) const{
+  size_t rows = tile_bytes / (width * sizeof(rgb24_t));
+  rows &= ~(size_t)7;
+  return rows < 8 ? 8 : rows;
+}
+
+/* PIPELINE */
+
+// Pack 8-bit indexes to bits per index, first pixel in the high bits
+static void pack_indexes(const uint8_t* indexes, uint8_t* dst, size_t n, uint8_t bits){
+  uint8_t per_byte = 8 / bits;
+  for (size_t i = 0; i < n; i += per_byte){
+    uint8_t byte = 0;
+    for (uint8_t k = 0; k < per_byte; k++){
+      byte = (uint8_t)(byte << bits);
+      if (i + k < n) byte |= indexes[i + k];
+    }
+    *dst++ = byte;
+  }
+}
+
+// Run the pipeline on rows [first, last) of a job
+bool image_converter_t::run_task(const task_t& task, worker_t& worker) const{
+  const image_job_t& job = *task.job;
+  size_t src_stride = job.src_stride != 0 ? job.src_stride : job.width;
+  size_t row_bytes = palette != nullptr ? (job.width * index_bits + 7) / 8 : job.width * sizeof(uint16_t);
+  size_t dst_stride = job.dst_stride != 0 ? job.dst_stride : row_bytes;
+
+  // a new ditherer starts at row 0, bands start at a multiple of 8 rows and diffusion tasks at the first row of the image
+  dither_t dither(method, job.width);
+  if (!dither.ready()) return false;
+
+  for (size_t y = task.first; y < task.last; y++){
+    const rgb24_t* src = job.src + y * src_stride;
+    uint8_t* dst = (uint8_t*)job.dst + y * dst_stride;
+
+    // gamma
+    if (gamma != nullptr){
+      for (size_t x = 0; x < job.width; x++) worker.row[x] = rgb24_t(gamma[src[x].red], gamma[src[x].green], gamma[src[x].blue]);
+      src = worker.row;
+    }
+
+    // dithering or palette mapping and packing
+    if (palette == nullptr){
+      if (method == DITHER_NONE) convert_rgb888_to_rgb565((const uint8_t*)src, (uint16_t*)dst, job.width, big_endian);
+      else dither.row_to_rgb565(src, (uint16_t*)dst, big_endian);
+    }
+    else{
+      uint8_t* indexes = index_bits == 8 ? dst : worker.indexes;
+      if (method == DITHER_NONE) palette->nearest_index(src, indexes, job.width);
+      else dither.row_to_palette(src, *palette, indexes);
+      if (index_bits != 8) pack_indexes(indexes, dst, job.width, index_bits);
+    }
+  }
+  return true;
+}
+
+// Take the next task of a worker
+bool image_converter_t::next_task(worker_t* all, unsigned index, size_t& task){
+  worker_t& own = all[index];
+  while (true){
+    {
+      std::lock_guard<std::mutex> guard(own.lock);
+      if (own.begin < own.end){
+        task = own.begin++;
+        return true;
+      }
+    }
+
+    // steal the back half of the largest range left
+    unsigned victim = index;
+    size_t largest = 0;
+    for (unsigned i = 0; i < workers; i++){
+      if (i == index) continue;
+      std::lock_guard<std::mutex> guard(all[i].lock);
+      if (all[i].end - all[i].begin > largest){
+        largest = all[i].end - all[i].begin;
+        victim = i;
+      }
+    }
+    if (victim == index) return false;
+
+    size_t begin;
+    size_t end;
+    {
+      std::lock_guard<std::mutex> guard(all[victim].lock);
+      size_t remaining = all[victim].end - all[victim].begin;
+      if (remaining == 0) continue;
+      end = all[victim].end;
+      begin = end - (remaining + 1) / 2;
+      all[victim].end = begin;
+    }
+    // only the owner fills its range, thieves only shrink it
+    std::lock_guard<std::mutex> guard(own.lock);
+    own.begin = begin;
+    own.end = end;
+    own.steals++;
+  }
+}
+
+/* CONVERSION */
+
+// Convert count images
+bool image_converter_t::convert(const image_job_t* jobs, size_t count){
+  task_count = 0;
+  steal_count = 0;
+  if (palette != nullptr){
+    if (index_bits != 1 && index_bits != 2 && index_bits != 4 && index_bits != 8) return false;
+    if (palette->size() == 0 || palette->size() > ((palette_size_t)1 << index_bits)) return false;
+    // build the search structures selected for first use now, queries from the workers only read them
+    palette->nearest_index(rgb24_t(0, 0, 0));
+  }
+
+  // tasks: bands of rows, whole images for error diffusion
+  bool diffusion = method == DITHER_FLOYD_STEINBERG || method == DITHER_ATKINSON;
+  size_t max_width = 0;
+  for (size_t j = 0; j < count; j++){
+    if (jobs[j].width == 0 || jobs[j].height == 0) continue;
+    if (jobs[j].width > max_width) max_width = jobs[j].width;
+    size_t rows = diffusion ? jobs[j].height : band_rows(jobs[j].width);
+    task_count += (jobs[j].height + rows - 1) / rows;
+  }
+  if (task_count == 0) return true;
+
+  task_t* tasks = (task_t*)malloc(task_count * sizeof(task_t));
+  if (tasks == nullptr) return false;
+  size_t t = 0;
+  for (size_t j = 0; j < count; j++){
+    if (jobs[j].width == 0 || jobs[j].height == 0) continue;
+    size_t rows = diffusion ? jobs[j].height : band_rows(jobs[j].width);
+    for (size_t first = 0; first < jobs[j].height; first += rows){
+      tasks[t].job = jobs + j;
+      tasks[t].first = first;
+      tasks[t].last = first + rows < jobs[j].height ? first + rows : jobs[j].height;
+      t++;
+    }
+  }
+
+  // contiguous ranges of tasks, one per worker
+  unsigned active = task_count < workers ? (unsigned)task_count : workers;
+  worker_t* all = new worker_t[workers];
+  bool ok = true;
+  for (unsigned w = 0; w < workers; w++){
+    all[w].begin = w < active ? task_count * w / active : 0;
+    all[w].end = w < active ? task_count * (w + 1) / active : 0;
+    all[w].tasks = tasks;
+    all[w].row = w < active ? (rgb24_t*)malloc(max_width * sizeof(rgb24_t)) : nullptr;
+    all[w].indexes = w < active ? (uint8_t*)malloc(max_width) : nullptr;
+    all[w].steals = 0;
+    all[w].ok = true;
+    if (w < active && (all[w].row == nullptr || all[w].indexes == nullptr)) ok = false;
+  }
+
+  if (ok){
+    auto work = [this, all](unsigned index){
+      size_t task;
+      while (next_task(all, index, task)){
+        if (!run_task(all[index].tasks[task], all[index])) all[index].ok = false;
+      }
+    };
+    std::thread* threads = new std::thread[active > 0 ? active - 1 : 0];
+    for (unsigned w = 1; w < active; w++) threads[w - 1] = std::thread(work, w);
+    work(0);
+    for (unsigned w = 1; w < active; w++) threads[w - 1].join();
+    delete[] threads;
+  }
+
+  for (unsigned w = 0; w < workers; w++){
+    ok = ok && all[w].ok;
+    steal_count += all[w].steals;
+    free(all[w].row);
+    free(all[w].indexes);
+  }
+  delete[] all;
+  free(tasks);
+  return ok;
+}
+
+#endif
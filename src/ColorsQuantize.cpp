@@ -0,0 +1,233 @@
+// ColorsQuantize.cpp
+
+// Creator: JDFraire-P
+
+// Description: Palette generation from streamed pixels (histogram, median cut and k-means refinement)
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsQuantize.h>
+
+/* QUANTIZER */
+
+// Median cut box, a range of the non-empty bucket list
+struct quantizer_box_t{
+  uint32_t first;
+  uint32_t size;
+  uint32_t pixels;
+  uint8_t low[3];
+  uint8_t high[3];
+};
+
+quantizer_t::quantizer_t(uint8_t red_bits, uint8_t green_bits, uint8_t blue_bits){
+  bits[0] = red_bits < 1 ? 1 : (red_bits > 6 ? 6 : red_bits);
+  bits[1] = green_bits < 1 ? 1 : (green_bits > 6 ? 6 : green_bits);
+  bits[2] = blue_bits < 1 ? 1 : (blue_bits > 6 ? 6 : blue_bits);
+  // histograms larger than size_t (over 13 bits with a 16-bit size_t) are refused, ready() is false
+  counts = bucket_count() <= (size_t)-1 / sizeof(uint32_t) ? (uint32_t*)malloc((size_t)bucket_count() * sizeof(uint32_t)) : nullptr;
+  clear();
+}
+
+quantizer_t::~quantizer_t(){
+  free(counts);
+}
+
+// Remove every pixel
+void quantizer_t::clear(){
+  pixels_added = 0;
+  if (counts != nullptr) memset(counts, 0, (size_t)bucket_count() * sizeof(uint32_t));
+}
+
+// Bucket of a RGB888 color
+uint32_t quantizer_t::bucket(rgb24_t color) const{
+  return ((uint32_t)(color.red >> (8 - bits[0])) << (bits[1] + bits[2]))
+       | ((uint32_t)(color.green >> (8 - bits[1])) << bits[2])
+       | (uint32_t)(color.blue >> (8 - bits[2]));
+}
+
+// Channel value of a bucket (the bucket range is scaled so the first and last buckets are 0 and 255)
+uint8_t quantizer_t::bucket_channel(uint32_t bucket, uint8_t channel) const{
+  uint8_t shift = channel == 0 ? bits[1] + bits[2] : (channel == 1 ? bits[2] : 0);
+  uint16_t max = (uint16_t)((1 << bits[channel]) - 1);
+  uint16_t value = (uint16_t)((bucket >> shift) & max);
+  return (uint8_t)((value * 255 + max / 2) / max);
+}
+
+// Add n RGB888 pixels
+void quantizer_t::add(const rgb24_t* pixels, size_t n){
+  if (counts == nullptr) return;
+  for (size_t i = 0; i < n; i++) counts[bucket(pixels[i])]++;
+  pixels_added += n;
+}
+
+// Add n RGB565 pixels
+void quantizer_t::add(const uint16_t* pixels, size_t n, bool big_endian){
+  if (counts == nullptr) return;
+  // a 5/6/5 histogram is indexed by the RGB565 value itself
+  bool direct = bits[0] == 5 && bits[1] == 6 && bits[2] == 5;
+  for (size_t i = 0; i < n; i++){
+    uint16_t value = big_endian ? (uint16_t)((pixels[i] << 8) | (pixels[i] >> 8)) : pixels[i];
+    counts[direct ? value : bucket(rgb565_to_rgb888(rgb16_t(value)))]++;
+  }
+  pixels_added += n;
+}
+
+// Buckets with at least one pixel
+uint32_t quantizer_t::color_count() const{
+  if (counts == nullptr) return 0;
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < bucket_count(); i++) found += counts[i] != 0;
+  return found;
+}
+
+// Pixel count and channel ranges of a box
+void quantizer_t::measure_box(quantizer_box_t& box, const uint32_t* buckets) const{
+  box.pixels = 0;
+  for (uint8_t c = 0; c < 3; c++){
+    box.low[c] = 255;
+    box.high[c] = 0;
+  }
+  for (uint32_t i = box.first; i < box.first + box.size; i++){
+    box.pixels += counts[buckets[i]];
+    for (uint8_t c = 0; c < 3; c++){
+      uint8_t value = bucket_channel(buckets[i], c);
+      if (value < box.low[c]) box.low[c] = value;
+      if (value > box.high[c]) box.high[c] = value;
+    }
+  }
+}
+
+// Longest channel of a box
+static inline uint8_t longest_channel(const quantizer_box_t& box){
+  uint8_t channel = 0;
+  for (uint8_t c = 1; c < 3; c++){
+    if (box.high[c] - box.low[c] > box.high[channel] - box.low[channel]) channel = c;
+  }
+  return channel;
+}
+
+// Build a palette of up to max_colors colors
+palette_size_t quantizer_t::build(rgb24_t* colors, palette_size_t max_colors, uint8_t kmeans_iterations) const{
+  uint32_t size = color_count();
+  if (size == 0 || max_colors == 0 || size > (size_t)-1 / (2 * sizeof(uint32_t))) return 0;
+  palette_size_t limit = (uint32_t)max_colors < size ? max_colors : (palette_size_t)size;
+
+  // non-empty buckets and a scratch list for the splits
+  uint32_t* buckets = (uint32_t*)malloc((size_t)size * 2 * sizeof(uint32_t));
+  quantizer_box_t* boxes = (quantizer_box_t*)malloc((size_t)limit * sizeof(quantizer_box_t));
+  if (buckets == nullptr || boxes == nullptr){
+    free(buckets);
+    free(boxes);
+    return 0;
+  }
+  uint32_t* scratch = buckets + size;
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < bucket_count(); i++){
+    if (counts[i] != 0) buckets[found++] = i;
+  }
+
+  boxes[0].first = 0;
+  boxes[0].size = size;
+  measure_box(boxes[0], buckets);
+  palette_size_t count = 1;
+
+  while (count < limit){
+    // box with the largest pixels times longest range
+    palette_size_t best = count;
+    uint64_t best_score = 0;
+    for (palette_size_t i = 0; i < count; i++){
+      if (boxes[i].size < 2) continue;
+      uint8_t channel = longest_channel(boxes[i]);
+      uint64_t score = (uint64_t)boxes[i].pixels * (uint32_t)(boxes[i].high[channel] - boxes[i].low[channel]);
+      if (best == count || score > best_score){
+        best = i;
+        best_score = score;
+      }
+    }
+    if (best == count) break;
+
+    // sort the box by the longest channel (counting sort, at most 64 channel values)
+    quantizer_box_t& box = boxes[best];
+    uint8_t channel = longest_channel(box);
+    uint8_t shift = channel == 0 ? bits[1] + bits[2] : (channel == 1 ? bits[2] : 0);
+    uint32_t mask = ((uint32_t)1 << bits[channel]) - 1;
+    uint32_t offsets[65] = {0};
+    for (uint32_t i = box.first; i < box.first + box.size; i++) offsets[((buckets[i] >> shift) & mask) + 1]++;
+    for (uint8_t v = 0; v < 64; v++) offsets[v + 1] += offsets[v];
+    for (uint32_t i = box.first; i < box.first + box.size; i++) scratch[offsets[(buckets[i] >> shift) & mask]++] = buckets[i];
+    memcpy(buckets + box.first, scratch, box.size * sizeof(uint32_t));
+
+    // split after the bucket that reaches half of the pixels, both halves keep at least one bucket
+    uint32_t half = box.pixels / 2;
+    uint32_t accumulated = 0;
+    uint32_t split = 1;
+    for (uint32_t i = 0; i < box.size - 1; i++){
+      accumulated += counts[buckets[box.first + i]];
+      split = i + 1;
+      if (accumulated >= half) break;
+    }
+
+    quantizer_box_t& other = boxes[count++];
+    other.first = box.first + split;
+    other.size = box.size - split;
+    box.size = split;
+    measure_box(box, buckets);
+    measure_box(other, buckets);
+  }
+
+  // pixel weighted mean of each box
+  for (palette_size_t i = 0; i < count; i++){
+    uint64_t sums[3] = {0, 0, 0};
+    for (uint32_t j = boxes[i].first; j < boxes[i].first + boxes[i].size; j++){
+      rgb24_t color = bucket_color(buckets[j]);
+      uint32_t weight = counts[buckets[j]];
+      sums[0] += (uint64_t)color.red * weight;
+      sums[1] += (uint64_t)color.green * weight;
+      sums[2] += (uint64_t)color.blue * weight;
+    }
+    uint32_t pixels = boxes[i].pixels;
+    colors[i] = rgb24_t((uint8_t)((sums[0] + pixels / 2) / pixels), (uint8_t)((sums[1] + pixels / 2) / pixels), (uint8_t)((sums[2] + pixels / 2) / pixels));
+  }
+  free(boxes);
+
+  for (uint8_t i = 0; i < kmeans_iterations; i++){
+    if (!kmeans_step(buckets, size, colors, count)) break;
+  }
+
+  free(buckets);
+  return count;
+}
+
+// Move each color to the weighted mean of its nearest buckets
+bool quantizer_t::kmeans_step(const uint32_t* buckets, uint32_t size, rgb24_t* colors, palette_size_t count) const{
+  if (count > (size_t)-1 / (4 * sizeof(uint64_t))) return false;
+  uint64_t* sums = (uint64_t*)malloc((size_t)count * 4 * sizeof(uint64_t));
+  if (sums == nullptr) return false;
+  memset(sums, 0, (size_t)count * 4 * sizeof(uint64_t));
+
+  {
+    palette_t palette(colors, count, PALETTE_INDEX_GRID);
+    for (uint32_t i = 0; i < size; i++){
+      rgb24_t color = bucket_color(buckets[i]);
+      uint32_t weight = counts[buckets[i]];
+      uint64_t* sum = sums + 4 * palette.nearest_index(color);
+      sum[0] += (uint64_t)color.red * weight;
+      sum[1] += (uint64_t)color.green * weight;
+      sum[2] += (uint64_t)color.blue * weight;
+      sum[3] += weight;
+    }
+  }
+
+  bool moved = false;
+  for (palette_size_t i = 0; i < count; i++){
+    uint64_t* sum = sums + 4 * i;
+    if (sum[3] == 0) continue;
+    rgb24_t mean((uint8_t)((sum[0] + sum[3] / 2) / sum[3]), (uint8_t)((sum[1] + sum[3] / 2) / sum[3]), (uint8_t)((sum[2] + sum[3] / 2) / sum[3]));
+    if (mean.value() != colors[i].value()){
+      colors[i] = mean;
+      moved = true;
+    }
+  }
+  free(sums);
+  return moved;
+}
@@ -0,0 +1,525 @@
+// ColorsSimd.cpp
+
+// Creator: JDFraire-P
+
+// Description: Vector backends of the bulk conversion and color string parsing functions
+
+/*  Vector RGB888 to RGB565
+1. Load 8 (SSE2), 16 (AVX2 and NEON) pixels and split them into red, green and blue 16-bit lanes.
+2. Scale the channels with the same multiply-shift forms used by channel8_to_5 and channel8_to_6, every intermediate fits in 16 bits.
+3. Shift and merge the channels into RGB565 words, byte swap them if big endian output is requested and store them.
+The RGB565 to RGB888 kernels run the same steps backwards with channel5_to_8 and channel6_to_8.
+*/
+
+/*  Vector hex color parsing
+1. Load 16 characters, two compact "#rrggbb" entries with their separators.
+2. Classify every byte as a decimal digit or a hex letter with compares, any other character in a digit position ends the run.
+3. Turn the characters into nibbles, shift the vector by one byte so each digit pair shares a 16-bit lane, and merge each pair into a channel byte.
+Entries in other layouts (spaces, #rgb, rgb(), names) are left to the scalar parser.
+*/
+
+#include "ColorsSimd.h"
+
+#if COLORSUTILS_SIMD
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COLORSUTILS_AVX2 1
+#endif
+#else
+#include <arm_neon.h>
+#endif
+
+/* SSE2 KERNELS */
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+// Scale 16-bit lanes of 8-bit channels to RGB565 and merge them
+static inline __m128i sse2_pack565(__m128i red, __m128i green, __m128i blue, bool big_endian){
+  red = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(249)), _mm_set1_epi16(1014)), 11);
+  green = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(green, _mm_set1_epi16(253)), _mm_set1_epi16(505)), 10);
+  blue = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(blue, _mm_set1_epi16(249)), _mm_set1_epi16(1014)), 11);
+  __m128i rgb565 = _mm_or_si128(_mm_slli_epi16(red, 11), _mm_or_si128(_mm_slli_epi16(green, 5), blue));
+  if (big_endian) rgb565 = _mm_or_si128(_mm_slli_epi16(rgb565, 8), _mm_srli_epi16(rgb565, 8));
+  return rgb565;
+}
+
+// Convert two vectors of 4 pixels in 32-bit lanes (channels at bit RS, GS and BS) to 8 RGB565 words
+template <int RS, int GS, int BS>
+static inline __m128i sse2_lanes_to_565(__m128i lo, __m128i hi, bool big_endian){
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  __m128i red = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, RS), mask), _mm_and_si128(_mm_srli_epi32(hi, RS), mask));
+  __m128i green = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, GS), mask), _mm_and_si128(_mm_srli_epi32(hi, GS), mask));
+  __m128i blue = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, BS), mask), _mm_and_si128(_mm_srli_epi32(hi, BS), mask));
+  return sse2_pack565(red, green, blue, big_endian);
+}
+
+// Spread 4 interleaved RGB888 pixels (reads 16 bytes) into 32-bit lanes 0xXXBBGGRR
+static inline __m128i sse2_load_rgb888x4(const uint8_t* src){
+  __m128i v = _mm_loadu_si128((const __m128i*)src);
+  __m128i p01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+  __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+  return _mm_unpacklo_epi64(p01, p23);
+}
+
+// Expand 8 RGB565 words to 8-bit channels in 16-bit lanes
+static inline void sse2_unpack565(__m128i rgb565, bool big_endian, __m128i& red, __m128i& green, __m128i& blue){
+  if (big_endian) rgb565 = _mm_or_si128(_mm_slli_epi16(rgb565, 8), _mm_srli_epi16(rgb565, 8));
+  red = _mm_srli_epi16(rgb565, 11);
+  green = _mm_and_si128(_mm_srli_epi16(rgb565, 5), _mm_set1_epi16(0x3F));
+  blue = _mm_and_si128(rgb565, _mm_set1_epi16(0x1F));
+  red = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(527)), _mm_set1_epi16(23)), 6);
+  green = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(green, _mm_set1_epi16(259)), _mm_set1_epi16(33)), 6);
+  blue = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(blue, _mm_set1_epi16(527)), _mm_set1_epi16(23)), 6);
+}
+
+// Store the low 3 bytes of each 32-bit lane, writes one byte past the 12 pixel bytes
+static inline void sse2_store_rgb888x4(uint8_t* dst, __m128i pixels){
+  for (int k = 0; k < 4; k++){
+    uint32_t pixel = (uint32_t)_mm_cvtsi128_si32(pixels);
+    memcpy(dst + 3 * k, &pixel, 4);
+    pixels = _mm_srli_si128(pixels, 4);
+  }
+}
+
+static size_t sse2_rgb888_to_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  // the second load reads 16 bytes from pixel 4, keep 10 pixels of input ahead
+  for (; i + 10 <= n; i += 8){
+    __m128i lo = sse2_load_rgb888x4(src + 3 * i);
+    __m128i hi = sse2_load_rgb888x4(src + 3 * i + 12);
+    _mm_storeu_si128((__m128i*)(dst + i), sse2_lanes_to_565<0, 8, 16>(lo, hi, big_endian));
+  }
+  return i;
+}
+
+static size_t sse2_rgbx_to_rgb565(const uint32_t* src, uint16_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8){
+    __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 4));
+    _mm_storeu_si128((__m128i*)(dst + i), sse2_lanes_to_565<16, 8, 0>(lo, hi, big_endian));
+  }
+  return i;
+}
+
+static size_t sse2_rgb565_to_rgb888(const uint16_t* src, uint8_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  // the last 32-bit store writes one byte of the next pixel, keep one pixel of output ahead
+  for (; i + 9 <= n; i += 8){
+    __m128i red, green, blue;
+    sse2_unpack565(_mm_loadu_si128((const __m128i*)(src + i)), big_endian, red, green, blue);
+    __m128i red_green = _mm_or_si128(red, _mm_slli_epi16(green, 8));
+    sse2_store_rgb888x4(dst + 3 * i, _mm_unpacklo_epi16(red_green, blue));
+    sse2_store_rgb888x4(dst + 3 * i + 12, _mm_unpackhi_epi16(red_green, blue));
+  }
+  return i;
+}
+
+static size_t sse2_rgb565_to_rgbx(const uint16_t* src, uint32_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8){
+    __m128i red, green, blue;
+    sse2_unpack565(_mm_loadu_si128((const __m128i*)(src + i)), big_endian, red, green, blue);
+    __m128i green_blue = _mm_or_si128(_mm_slli_epi16(green, 8), blue);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(green_blue, red));
+    _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(green_blue, red));
+  }
+  return i;
+}
+
+// Two compact entries "#rrggbb,#rrggbb," have the marks and separators at bytes 0, 7, 8 and 15
+static inline bool hex_entries_layout(const char* text){
+  return text[0] == '#' && text[8] == '#' && (text[7] == ',' || text[7] == '\n') && (text[15] == ',' || text[15] == '\n');
+}
+
+// Decode two compact "#rrggbb" entries (16 bytes), false if a digit is not hexadecimal
+static inline bool sse2_parse_hex_entries(const char* text, uint8_t* colors){
+  __m128i v = _mm_loadu_si128((const __m128i*)text);
+  __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+  __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+  // digits are bytes 1 to 6 and 9 to 14
+  if ((_mm_movemask_epi8(_mm_or_si128(digit, letter)) & 0x7E7E) != 0x7E7E) return false;
+  __m128i nibbles = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+                                 _mm_andnot_si128(digit, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+  // 16-bit lane k holds the high nibble (low byte) and low nibble (high byte) of byte k
+  nibbles = _mm_srli_si128(nibbles, 1);
+  __m128i bytes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0xFF)), 4), _mm_srli_epi16(nibbles, 8));
+  uint8_t packed[16];
+  _mm_storeu_si128((__m128i*)packed, _mm_packus_epi16(bytes, bytes));
+  memcpy(colors, packed, 3);
+  memcpy(colors + 3, packed + 4, 3);
+  return true;
+}
+
+static size_t sse2_parse_hex_colors(const char* text, size_t length, uint8_t* colors, size_t max_count, size_t& count){
+  size_t i = 0;
+  size_t parsed = 0;
+  for (; i + 16 <= length && parsed + 2 <= max_count && hex_entries_layout(text + i); i += 16, parsed += 2){
+    if (!sse2_parse_hex_entries(text + i, colors + 3 * parsed)) break;
+  }
+  count += parsed;
+  return i;
+}
+
+#endif
+
+/* AVX2 KERNELS */
+
+#if defined(COLORSUTILS_AVX2)
+
+#define COLORSUTILS_TARGET_AVX2 __attribute__((target("avx2")))
+
+// Scale 16-bit lanes of 8-bit channels to RGB565 and merge them
+COLORSUTILS_TARGET_AVX2 static inline __m256i avx2_pack565(__m256i red, __m256i green, __m256i blue, bool big_endian){
+  red = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(red, _mm256_set1_epi16(249)), _mm256_set1_epi16(1014)), 11);
+  green = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(green, _mm256_set1_epi16(253)), _mm256_set1_epi16(505)), 10);
+  blue = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(blue, _mm256_set1_epi16(249)), _mm256_set1_epi16(1014)), 11);
+  __m256i rgb565 = _mm256_or_si256(_mm256_slli_epi16(red, 11), _mm256_or_si256(_mm256_slli_epi16(green, 5), blue));
+  if (big_endian) rgb565 = _mm256_or_si256(_mm256_slli_epi16(rgb565, 8), _mm256_srli_epi16(rgb565, 8));
+  return rgb565;
+}
+
+// Convert two vectors of 8 pixels in 32-bit lanes (channels at bit RS, GS and BS) to 16 RGB565 words
+template <int RS, int GS, int BS>
+COLORSUTILS_TARGET_AVX2 static inline __m256i avx2_lanes_to_565(__m256i lo, __m256i hi, bool big_endian){
+  const __m256i mask = _mm256_set1_epi32(0xFF);
+  // packus works per 128-bit lane, the pixel order is fixed once on the merged words
+  __m256i red = _mm256_packus_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, RS), mask), _mm256_and_si256(_mm256_srli_epi32(hi, RS), mask));
+  __m256i green = _mm256_packus_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, GS), mask), _mm256_and_si256(_mm256_srli_epi32(hi, GS), mask));
+  __m256i blue = _mm256_packus_epi32(_mm256_and_si256(_mm256_srli_epi32(lo, BS), mask), _mm256_and_si256(_mm256_srli_epi32(hi, BS), mask));
+  return _mm256_permute4x64_epi64(avx2_pack565(red, green, blue, big_endian), 0xD8);
+}
+
+// Spread 8 interleaved RGB888 pixels (reads 28 bytes) into 32-bit lanes 0xXXBBGGRR
+COLORSUTILS_TARGET_AVX2 static inline __m256i avx2_load_rgb888x8(const uint8_t* src){
+  const __m256i spread = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                          0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)src)), _mm_loadu_si128((const __m128i*)(src + 12)), 1);
+  return _mm256_shuffle_epi8(v, spread);
+}
+
+// Expand 16 RGB565 words to 8-bit channels in 16-bit lanes
+COLORSUTILS_TARGET_AVX2 static inline void avx2_unpack565(__m256i rgb565, bool big_endian, __m256i& red, __m256i& green, __m256i& blue){
+  if (big_endian) rgb565 = _mm256_or_si256(_mm256_slli_epi16(rgb565, 8), _mm256_srli_epi16(rgb565, 8));
+  red = _mm256_srli_epi16(rgb565, 11);
+  green = _mm256_and_si256(_mm256_srli_epi16(rgb565, 5), _mm256_set1_epi16(0x3F));
+  blue = _mm256_and_si256(rgb565, _mm256_set1_epi16(0x1F));
+  red = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(red, _mm256_set1_epi16(527)), _mm256_set1_epi16(23)), 6);
+  green = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(green, _mm256_set1_epi16(259)), _mm256_set1_epi16(33)), 6);
+  blue = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(blue, _mm256_set1_epi16(527)), _mm256_set1_epi16(23)), 6);
+}
+
+// Merge 16 pixels of 8-bit channels into two vectors of 8 pixels in 32-bit lanes (red at bit 0 when RED_LOW, else at bit 16)
+template <bool RED_LOW>
+COLORSUTILS_TARGET_AVX2 static inline void avx2_merge_lanes(__m256i red, __m256i green, __m256i blue, __m256i& lo, __m256i& hi){
+  __m256i low = RED_LOW ? _mm256_or_si256(red, _mm256_slli_epi16(green, 8)) : _mm256_or_si256(blue, _mm256_slli_epi16(green, 8));
+  __m256i high = RED_LOW ? blue : red;
+  // unpack works per 128-bit lane, reorder the halves back to pixel order
+  __m256i a = _mm256_unpacklo_epi16(low, high);
+  __m256i b = _mm256_unpackhi_epi16(low, high);
+  lo = _mm256_permute2x128_si256(a, b, 0x20);
+  hi = _mm256_permute2x128_si256(a, b, 0x31);
+}
+
+// Store the low 3 bytes of each 32-bit lane, writes 4 bytes past the 24 pixel bytes
+COLORSUTILS_TARGET_AVX2 static inline void avx2_store_rgb888x8(uint8_t* dst, __m256i pixels){
+  const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  pixels = _mm256_shuffle_epi8(pixels, pack);
+  _mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(pixels));
+  _mm_storeu_si128((__m128i*)(dst + 12), _mm256_extracti128_si256(pixels, 1));
+}
+
+COLORSUTILS_TARGET_AVX2 static size_t avx2_rgb888_to_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  // the last load reads 28 bytes from pixel 8, keep 18 pixels of input ahead
+  for (; i + 18 <= n; i += 16){
+    __m256i lo = avx2_load_rgb888x8(src + 3 * i);
+    __m256i hi = avx2_load_rgb888x8(src + 3 * i + 24);
+    _mm256_storeu_si256((__m256i*)(dst + i), avx2_lanes_to_565<0, 8, 16>(lo, hi, big_endian));
+  }
+  return i;
+}
+
+COLORSUTILS_TARGET_AVX2 static size_t avx2_rgbx_to_rgb565(const uint32_t* src, uint16_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16){
+    __m256i lo = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(src + i + 8));
+    _mm256_storeu_si256((__m256i*)(dst + i), avx2_lanes_to_565<16, 8, 0>(lo, hi, big_endian));
+  }
+  return i;
+}
+
+COLORSUTILS_TARGET_AVX2 static size_t avx2_rgb565_to_rgb888(const uint16_t* src, uint8_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  // the last store writes 4 bytes past the pixels, keep two pixels of output ahead
+  for (; i + 18 <= n; i += 16){
+    __m256i red, green, blue, lo, hi;
+    avx2_unpack565(_mm256_loadu_si256((const __m256i*)(src + i)), big_endian, red, green, blue);
+    avx2_merge_lanes<true>(red, green, blue, lo, hi);
+    avx2_store_rgb888x8(dst + 3 * i, lo);
+    avx2_store_rgb888x8(dst + 3 * i + 24, hi);
+  }
+  return i;
+}
+
+COLORSUTILS_TARGET_AVX2 static size_t avx2_rgb565_to_rgbx(const uint16_t* src, uint32_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16){
+    __m256i red, green, blue, lo, hi;
+    avx2_unpack565(_mm256_loadu_si256((const __m256i*)(src + i)), big_endian, red, green, blue);
+    avx2_merge_lanes<false>(red, green, blue, lo, hi);
+    _mm256_storeu_si256((__m256i*)(dst + i), lo);
+    _mm256_storeu_si256((__m256i*)(dst + i + 8), hi);
+  }
+  return i;
+}
+
+#endif
+
+/* NEON KERNELS */
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+// Scale 16-bit lanes of 8-bit channels to RGB565 and merge them
+static inline uint16x8_t neon_pack565(uint16x8_t red, uint16x8_t green, uint16x8_t blue){
+  red = vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(1014), red, 249), 11);
+  green = vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(505), green, 253), 10);
+  blue = vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(1014), blue, 249), 11);
+  return vorrq_u16(vshlq_n_u16(red, 11), vorrq_u16(vshlq_n_u16(green, 5), blue));
+}
+
+// Convert 16 pixels of 8-bit channels to RGB565 and store them
+static inline void neon_store565x16(uint16_t* dst, uint8x16_t red, uint8x16_t green, uint8x16_t blue, bool big_endian){
+  uint16x8_t lo = neon_pack565(vmovl_u8(vget_low_u8(red)), vmovl_u8(vget_low_u8(green)), vmovl_u8(vget_low_u8(blue)));
+  uint16x8_t hi = neon_pack565(vmovl_u8(vget_high_u8(red)), vmovl_u8(vget_high_u8(green)), vmovl_u8(vget_high_u8(blue)));
+  if (big_endian){
+    lo = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(lo)));
+    hi = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(hi)));
+  }
+  vst1q_u16(dst, lo);
+  vst1q_u16(dst + 8, hi);
+}
+
+// Expand 8 RGB565 words to 8-bit channels
+static inline void neon_unpack565(uint16x8_t rgb565, uint8x8_t& red, uint8x8_t& green, uint8x8_t& blue){
+  uint16x8_t r = vshrq_n_u16(rgb565, 11);
+  uint16x8_t g = vandq_u16(vshrq_n_u16(rgb565, 5), vdupq_n_u16(0x3F));
+  uint16x8_t b = vandq_u16(rgb565, vdupq_n_u16(0x1F));
+  red = vmovn_u16(vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(23), r, 527), 6));
+  green = vmovn_u16(vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(33), g, 259), 6));
+  blue = vmovn_u16(vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(23), b, 527), 6));
+}
+
+// Load 16 RGB565 words and expand them to 8-bit channels
+static inline void neon_load565x16(const uint16_t* src, bool big_endian, uint8x16_t& red, uint8x16_t& green, uint8x16_t& blue){
+  uint16x8_t lo = vld1q_u16(src);
+  uint16x8_t hi = vld1q_u16(src + 8);
+  if (big_endian){
+    lo = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(lo)));
+    hi = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(hi)));
+  }
+  uint8x8_t red_lo, green_lo, blue_lo, red_hi, green_hi, blue_hi;
+  neon_unpack565(lo, red_lo, green_lo, blue_lo);
+  neon_unpack565(hi, red_hi, green_hi, blue_hi);
+  red = vcombine_u8(red_lo, red_hi);
+  green = vcombine_u8(green_lo, green_hi);
+  blue = vcombine_u8(blue_lo, blue_hi);
+}
+
+static size_t neon_rgb888_to_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16){
+    uint8x16x3_t rgb = vld3q_u8(src + 3 * i);
+    neon_store565x16(dst + i, rgb.val[0], rgb.val[1], rgb.val[2], big_endian);
+  }
+  return i;
+}
+
+static size_t neon_rgbx_to_rgb565(const uint32_t* src, uint16_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+#if !defined(__ARM_BIG_ENDIAN)
+  // 0x00RRGGBB words are stored as B, G, R, X bytes
+  for (; i + 16 <= n; i += 16){
+    uint8x16x4_t bgrx = vld4q_u8((const uint8_t*)(src + i));
+    neon_store565x16(dst + i, bgrx.val[2], bgrx.val[1], bgrx.val[0], big_endian);
+  }
+#endif
+  return i;
+}
+
+static size_t neon_rgb565_to_rgb888(const uint16_t* src, uint8_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16){
+    uint8x16x3_t rgb;
+    neon_load565x16(src + i, big_endian, rgb.val[0], rgb.val[1], rgb.val[2]);
+    vst3q_u8(dst + 3 * i, rgb);
+  }
+  return i;
+}
+
+static size_t neon_rgb565_to_rgbx(const uint16_t* src, uint32_t* dst, size_t n, bool big_endian){
+  size_t i = 0;
+#if !defined(__ARM_BIG_ENDIAN)
+  for (; i + 16 <= n; i += 16){
+    uint8x16x4_t bgrx;
+    neon_load565x16(src + i, big_endian, bgrx.val[2], bgrx.val[1], bgrx.val[0]);
+    bgrx.val[3] = vdupq_n_u8(0);
+    vst4q_u8((uint8_t*)(dst + i), bgrx);
+  }
+#endif
+  return i;
+}
+
+// Two compact entries "#rrggbb,#rrggbb," have the marks and separators at bytes 0, 7, 8 and 15
+static inline bool hex_entries_layout(const char* text){
+  return text[0] == '#' && text[8] == '#' && (text[7] == ',' || text[7] == '\n') && (text[15] == ',' || text[15] == '\n');
+}
+
+// Decode two compact "#rrggbb" entries (16 bytes), false if a digit is not hexadecimal
+static inline bool neon_parse_hex_entries(const char* text, uint8_t* colors){
+  uint8x16_t v = vld1q_u8((const uint8_t*)text);
+  uint8x16_t lower = vorrq_u8(v, vdupq_n_u8(0x20));
+  uint8x16_t digit = vcleq_u8(vsubq_u8(v, vdupq_n_u8('0')), vdupq_n_u8(9));
+  uint8x16_t letter = vcleq_u8(vsubq_u8(lower, vdupq_n_u8('a')), vdupq_n_u8(5));
+  // digits are bytes 1 to 6 and 9 to 14
+  static const uint8_t digit_bytes[16] = {0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0};
+  uint8x16_t missing = vbicq_u8(vld1q_u8(digit_bytes), vorrq_u8(digit, letter));
+  uint64x2_t missing64 = vreinterpretq_u64_u8(missing);
+  if ((vgetq_lane_u64(missing64, 0) | vgetq_lane_u64(missing64, 1)) != 0) return false;
+  uint8x16_t nibbles = vbslq_u8(digit, vsubq_u8(v, vdupq_n_u8('0')), vsubq_u8(lower, vdupq_n_u8('a' - 10)));
+  // 16-bit lane k holds the high nibble (low byte) and low nibble (high byte) of byte k
+  uint16x8_t pairs = vreinterpretq_u16_u8(vextq_u8(nibbles, vdupq_n_u8(0), 1));
+  uint8x8_t bytes = vmovn_u16(vorrq_u16(vshlq_n_u16(vandq_u16(pairs, vdupq_n_u16(0xFF)), 4), vshrq_n_u16(pairs, 8)));
+  uint8_t packed[8];
+  vst1_u8(packed, bytes);
+  memcpy(colors, packed, 3);
+  memcpy(colors + 3, packed + 4, 3);
+  return true;
+}
+
+static size_t neon_parse_hex_colors(const char* text, size_t length, uint8_t* colors, size_t max_count, size_t& count){
+  size_t i = 0;
+  size_t parsed = 0;
+#if !defined(__ARM_BIG_ENDIAN)
+  for (; i + 16 <= length && parsed + 2 <= max_count && hex_entries_layout(text + i); i += 16, parsed += 2){
+    if (!neon_parse_hex_entries(text + i, colors + 3 * parsed)) break;
+  }
+#endif
+  count += parsed;
+  return i;
+}
+
+#endif
+
+/* RUNTIME DISPATCH */
+
+// Kernels of one backend
+struct simd_kernels_t{
+  const char* name;
+  size_t (*rgb888_to_rgb565)(const uint8_t*, uint16_t*, size_t, bool);
+  size_t (*rgbx_to_rgb565)(const uint32_t*, uint16_t*, size_t, bool);
+  size_t (*rgb565_to_rgb888)(const uint16_t*, uint8_t*, size_t, bool);
+  size_t (*rgb565_to_rgbx)(const uint16_t*, uint32_t*, size_t, bool);
+};
+
+// Scalar backend, converts nothing so the callers convert every pixel with their scalar loops
+static size_t scalar_rgb888_to_rgb565(const uint8_t*, uint16_t*, size_t, bool){ return 0; }
+static size_t scalar_rgbx_to_rgb565(const uint32_t*, uint16_t*, size_t, bool){ return 0; }
+static size_t scalar_rgb565_to_rgb888(const uint16_t*, uint8_t*, size_t, bool){ return 0; }
+static size_t scalar_rgb565_to_rgbx(const uint16_t*, uint32_t*, size_t, bool){ return 0; }
+
+// Backends supported by the running CPU, widest first
+static size_t supported_kernels(simd_kernels_t* list){
+  size_t count = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+#if defined(COLORSUTILS_AVX2)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")){
+    list[count++] = {"avx2", avx2_rgb888_to_rgb565, avx2_rgbx_to_rgb565, avx2_rgb565_to_rgb888, avx2_rgb565_to_rgbx};
+  }
+#endif
+  list[count++] = {"sse2", sse2_rgb888_to_rgb565, sse2_rgbx_to_rgb565, sse2_rgb565_to_rgb888, sse2_rgb565_to_rgbx};
+#else
+  list[count++] = {"neon", neon_rgb888_to_rgb565, neon_rgbx_to_rgb565, neon_rgb565_to_rgb888, neon_rgb565_to_rgbx};
+#endif
+  list[count++] = {"scalar", scalar_rgb888_to_rgb565, scalar_rgbx_to_rgb565, scalar_rgb565_to_rgb888, scalar_rgb565_to_rgbx};
+  return count;
+}
+
+// Maximum number of backends
+#define SIMD_MAX_BACKENDS 4
+
+// Selected backend, the widest one until a test selects another
+static simd_kernels_t& kernels(){
+  static simd_kernels_t selected = [](){
+    simd_kernels_t list[SIMD_MAX_BACKENDS];
+    supported_kernels(list);
+    return list[0];
+  }();
+  return selected;
+}
+
+// Name of the selected backend ("sse2", "avx2", "neon" or "scalar")
+const char* simd_backend_name(){
+  return kernels().name;
+}
+
+// Names of the backends supported by the running CPU
+size_t simd_backend_names(const char** names, size_t max_count){
+  simd_kernels_t list[SIMD_MAX_BACKENDS];
+  size_t count = supported_kernels(list);
+  for (size_t i = 0; i < count && i < max_count; i++) names[i] = list[i].name;
+  return count;
+}
+
+// Use a backend by name for the following calls
+bool simd_select_backend(const char* name){
+  simd_kernels_t list[SIMD_MAX_BACKENDS];
+  size_t count = supported_kernels(list);
+  for (size_t i = 0; i < count; i++){
+    if (strcmp(list[i].name, name) == 0){
+      kernels() = list[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+// Interleaved RGB888 (3 bytes per pixel) to RGB565
+size_t simd_rgb888_to_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian){
+  return kernels().rgb888_to_rgb565(src, dst, n, big_endian);
+}
+
+// Packed RGB888 (0x00RRGGBB) to RGB565
+size_t simd_rgbx_to_rgb565(const uint32_t* src, uint16_t* dst, size_t n, bool big_endian){
+  return kernels().rgbx_to_rgb565(src, dst, n, big_endian);
+}
+
+// RGB565 to interleaved RGB888 (3 bytes per pixel)
+size_t simd_rgb565_to_rgb888(const uint16_t* src, uint8_t* dst, size_t n, bool big_endian){
+  return kernels().rgb565_to_rgb888(src, dst, n, big_endian);
+}
+
+// RGB565 to packed RGB888 (0x00RRGGBB)
+size_t simd_rgb565_to_rgbx(const uint16_t* src, uint32_t* dst, size_t n, bool big_endian){
+  return kernels().rgb565_to_rgbx(src, dst, n, big_endian);
+}
+
+// Compact "#rrggbb" entries to RGB888 (the AVX2 backend uses the SSE2 kernel, entries are 8 bytes)
+size_t simd_parse_hex_colors(const char* text, size_t length, uint8_t* colors, size_t max_count, size_t& count){
+#if defined(__SSE2__) || defined(_M_X64)
+  return sse2_parse_hex_colors(text, length, colors, max_count, count);
+#else
+  return neon_parse_hex_colors(text, length, colors, max_count, count);
+#endif
+}
+
+#endif
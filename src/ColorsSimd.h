@@ -0,0 +1,59 @@
+// ColorsSimd.h
+
+// Creator: JDFraire-P
+
+// Description: Vector backends of the bulk conversion and color string parsing functions (internal header)
+
+// Each kernel converts a prefix of the span and returns how many pixels it converted,
+// the caller converts the remaining pixels with the scalar loop.
+// Results are bit-identical to rgb888_to_rgb565 and rgb565_to_rgb888.
+
+#ifndef COLORSSIMD_H
+#define COLORSSIMD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Vector backends are built for x86 (SSE2 baseline, AVX2 selected at runtime) and ARM NEON,
+// define COLORSUTILS_NO_SIMD to build only the scalar kernels
+#if !defined(COLORSUTILS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define COLORSUTILS_SIMD 1
+#else
+#define COLORSUTILS_SIMD 0
+#endif
+
+#if COLORSUTILS_SIMD
+
+// Name of the selected backend ("sse2", "avx2", "neon" or "scalar")
+const char* simd_backend_name();
+// Names of the backends supported by the running CPU, widest first and "scalar" last, returns the count (test hook)
+size_t simd_backend_names(const char** names, size_t max_count);
+// Use a backend by name for the following calls (not thread safe), false if the CPU does not support it (test hook)
+bool simd_select_backend(const char* name);
+
+// Interleaved RGB888 (3 bytes per pixel) to RGB565
+size_t simd_rgb888_to_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian);
+// Packed RGB888 (0x00RRGGBB) to RGB565
+size_t simd_rgbx_to_rgb565(const uint32_t* src, uint16_t* dst, size_t n, bool big_endian);
+// RGB565 to interleaved RGB888 (3 bytes per pixel)
+size_t simd_rgb565_to_rgb888(const uint16_t* src, uint8_t* dst, size_t n, bool big_endian);
+// RGB565 to packed RGB888 (0x00RRGGBB)
+size_t simd_rgb565_to_rgbx(const uint16_t* src, uint32_t* dst, size_t n, bool big_endian);
+// Compact "#rrggbb" entries followed by ',' or '\n' to RGB888 (3 bytes per color), adds the colors parsed to count and returns the characters consumed
+size_t simd_parse_hex_colors(const char* text, size_t length, uint8_t* colors, size_t max_count, size_t& count);
+
+#else
+
+inline const char* simd_backend_name(){ return "scalar"; }
+inline size_t simd_backend_names(const char** names, size_t max_count){ if (max_count > 0) names[0] = "scalar"; return 1; }
+inline bool simd_select_backend(const char* name){ return strcmp(name, "scalar") == 0; }
+inline size_t simd_rgb888_to_rgb565(const uint8_t*, uint16_t*, size_t, bool){ return 0; }
+inline size_t simd_rgbx_to_rgb565(const uint32_t*, uint16_t*, size_t, bool){ return 0; }
+inline size_t simd_rgb565_to_rgb888(const uint16_t*, uint8_t*, size_t, bool){ return 0; }
+inline size_t simd_rgb565_to_rgbx(const uint16_t*, uint32_t*, size_t, bool){ return 0; }
+inline size_t simd_parse_hex_colors(const char*, size_t, uint8_t*, size_t, size_t&){ return 0; }
+
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+// ColorsStats.cpp
+
+// Creator: JDFraire-P
+
+// Description: Opt-in instrumentation of the library hot paths (calls, elements, entries scanned, cache hits and misses, String allocations, time)
+
+// Libraries
+#include <Arduino.h>
+#include <ColorsStats.h>
+
+/* FAMILY NAMES */
+
+static const char* const FAMILY_NAMES[COLORS_STATS_FAMILIES] = {"conversion", "similarity", "lookup", "string", "palette"};
+
+// Name of a family
+const char* colors_stats_family_name(colors_stats_family_t family){
+  return family < COLORS_STATS_FAMILIES ? FAMILY_NAMES[family] : "unknown";
+}
+
+/* COUNTERS */
+
+#if COLORSUTILS_STATS
+
+static colors_stats_count_t counters[COLORS_STATS_FAMILIES][COLORS_STATS_COUNTERS];
+
+// Instrumented calls in progress on this thread (only the outermost one is timed), one counter on single core boards
+#if defined(ARDUINO) && !defined(ESP32)
+static uint8_t depth = 0;
+#else
+static thread_local uint8_t depth = 0;
+#endif
+
+// Clock of the time counters
+static inline uint32_t stats_clock(){
+#if defined(COLORSUTILS_STATS_CYCLES) && (defined(ESP32) || defined(ESP8266))
+  return ESP.getCycleCount();
+#else
+  return (uint32_t)micros();
+#endif
+}
+
+// Add n to a counter of a family
+void colors_stats_add(colors_stats_family_t family, colors_stats_counter_t counter, colors_stats_count_t n){
+#if defined(__GNUC__) && !defined(__AVR__)
+  __atomic_fetch_add(&counters[family][counter], n, __ATOMIC_RELAXED);
+#else
+  counters[family][counter] += n;
+#endif
+}
+
+colors_stats_scope_t::colors_stats_scope_t(colors_stats_family_t family, colors_stats_count_t elements){
+  this->family = family;
+  colors_stats_add(family, COLORS_STATS_CALLS, 1);
+  colors_stats_add(family, COLORS_STATS_ELEMENTS, elements);
+  outermost = depth++ == 0;
+  start = outermost ? stats_clock() : 0;
+}
+
+colors_stats_scope_t::~colors_stats_scope_t(){
+  depth--;
+  // unsigned difference, correct across one clock wrap
+  if (outermost) colors_stats_add(family, COLORS_STATS_TIME, (uint32_t)(stats_clock() - start));
+}
+
+// Counters of a family
+colors_stats_t colors_stats(colors_stats_family_t family){
+  colors_stats_t stats = {};
+  if (family >= COLORS_STATS_FAMILIES) return stats;
+  const colors_stats_count_t* values = counters[family];
+  stats.calls = values[COLORS_STATS_CALLS];
+  stats.elements = values[COLORS_STATS_ELEMENTS];
+  stats.entries = values[COLORS_STATS_ENTRIES];
+  stats.hits = values[COLORS_STATS_HITS];
+  stats.misses = values[COLORS_STATS_MISSES];
+  stats.allocations = values[COLORS_STATS_ALLOCATIONS];
+  stats.time = values[COLORS_STATS_TIME];
+  return stats;
+}
+
+// Clear every counter
+void colors_stats_reset(){
+  memset(counters, 0, sizeof(counters));
+}
+
+#else
+
+// Counters of a family
+colors_stats_t colors_stats(colors_stats_family_t){
+  colors_stats_t stats = {};
+  return stats;
+}
+
+// Clear every counter
+void colors_stats_reset(){}
+
+#endif
+
+// Unit of the time counters
+const char* colors_stats_time_unit(){
+#if defined(COLORSUTILS_STATS_CYCLES) && (defined(ESP32) || defined(ESP8266))
+  return "cycles";
+#else
+  return "us";
+#endif
+}
+
+/* DUMP */
+
+// Append text to a line
+static void append_text(char* line, size_t size, size_t& length, const char* text){
+  while (*text != '\0' && length + 1 < size) line[length++] = *text++;
+  line[length] = '\0';
+}
+
+// Append " label=value" to a line
+static void append_counter(char* line, size_t size, size_t& length, const char* label, colors_stats_count_t value){
+  char digits[21];
+  uint8_t count = 0;
+  do{
+    digits[count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  append_text(line, size, length, " ");
+  append_text(line, size, length, label);
+  append_text(line, size, length, "=");
+  while (count > 0 && length + 1 < size) line[length++] = digits[--count];
+  line[length] = '\0';
+}
+
+// Write the counters of the families with calls
+void colors_stats_dump(colors_stats_writer_t writer, void* context){
+  if (!colors_stats_enabled()){
+    writer("ColorsUtils stats: disabled (build with COLORSUTILS_STATS=1)", context);
+    return;
+  }
+  char line[160];
+  for (uint8_t family = 0; family < COLORS_STATS_FAMILIES; family++){
+    colors_stats_t stats = colors_stats((colors_stats_family_t)family);
+    if (stats.calls == 0) continue;
+    size_t length = 0;
+    append_text(line, sizeof(line), length, colors_stats_family_name((colors_stats_family_t)family));
+    append_text(line, sizeof(line), length, ":");
+    append_counter(line, sizeof(line), length, "calls", stats.calls);
+    append_counter(line, sizeof(line), length, "elements", stats.elements);
+    append_counter(line, sizeof(line), length, "entries", stats.entries);
+    append_counter(line, sizeof(line), length, "hits", stats.hits);
+    append_counter(line, sizeof(line), length, "misses", stats.misses);
+    append_counter(line, sizeof(line), length, "allocations", stats.allocations);
+    append_counter(line, sizeof(line), length, colors_stats_time_unit(), stats.time);
+    writer(line, context);
+  }
+}
+
+// Write the counters to a Print output
+void colors_stats_dump(Print& out){
+  colors_stats_dump([](const char* line, void* context){ ((Print*)context)->println(line); }, &out);
+}
@@ -28,12 +28,75 @@
 // Libraries
 #include <Arduino.h>
 #include <ColorsUtils.h>
+#include <ColorsFormat.h>
+#include <ColorsStats.h>
+#include "ColorsSimd.h"
+
+/* BULK CONVERSION FUNCTIONS */
+
+// Swap the bytes of a RGB565 word
+static inline uint16_t swap_bytes(uint16_t value){
+  return (uint16_t)((value << 8) | (value >> 8));
+}
+
+// Pack 8-bit channels to a RGB565 word
+static inline uint16_t pack_rgb565(uint8_t red, uint8_t green, uint8_t blue){
+  return format_rgb565::pack(rgb24_t(red, green, blue));
+}
+
+// Name of the vector backend used by the bulk conversion functions
+const char* get_conversion_backend(){
+  return simd_backend_name();
+}
+
+// Convert interleaved RGB888 pixels (3 bytes per pixel, red first) to RGB565
+void convert_rgb888_to_rgb565(const uint8_t* src, uint16_t* dst, size_t n, bool big_endian){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  size_t i = simd_rgb888_to_rgb565(src, dst, n, big_endian);
+  for (src += 3 * i; i < n; i++, src += 3){
+    uint16_t value = pack_rgb565(src[0], src[1], src[2]);
+    dst[i] = big_endian ? swap_bytes(value) : value;
+  }
+}
+
+// Convert packed RGB888 pixels (0x00RRGGBB, upper byte ignored) to RGB565
+void convert_rgb888_to_rgb565(const uint32_t* src, uint16_t* dst, size_t n, bool big_endian){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = simd_rgbx_to_rgb565(src, dst, n, big_endian); i < n; i++){
+    uint16_t value = pack_rgb565((uint8_t)(src[i] >> 16), (uint8_t)(src[i] >> 8), (uint8_t)src[i]);
+    dst[i] = big_endian ? swap_bytes(value) : value;
+  }
+}
+
+// Convert RGB565 pixels to interleaved RGB888 (3 bytes per pixel, red first)
+void convert_rgb565_to_rgb888(const uint16_t* src, uint8_t* dst, size_t n, bool big_endian){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  size_t i = simd_rgb565_to_rgb888(src, dst, n, big_endian);
+  for (dst += 3 * i; i < n; i++, dst += 3){
+    rgb24_t color = format_rgb565::unpack(big_endian ? swap_bytes(src[i]) : src[i]);
+    dst[0] = color.red;
+    dst[1] = color.green;
+    dst[2] = color.blue;
+  }
+}
+
+// Convert RGB565 pixels to packed RGB888 (0x00RRGGBB)
+void convert_rgb565_to_rgb888(const uint16_t* src, uint32_t* dst, size_t n, bool big_endian){
+  COLORS_STATS_SCOPE(COLORS_STATS_CONVERSION, n);
+  for (size_t i = simd_rgb565_to_rgbx(src, dst, n, big_endian); i < n; i++){
+    dst[i] = format_rgb565::unpack(big_endian ? swap_bytes(src[i]) : src[i]).value();
+  }
+}
 
 /* COLORS STRUCTS CONSTRUCTORS */
 
+// Color struct built with a String name (one heap allocation)
+#define STATS_NAMED_STRUCT() (COLORS_STATS_CALL(COLORS_STATS_STRING, 1), COLORS_STATS_COUNT(COLORS_STATS_STRING, COLORS_STATS_ALLOCATIONS, 1))
+
 // 24-bit RGB888 color type
 // default constructor
 rgb888_t::rgb888_t(){
+  STATS_NAMED_STRUCT();
   value = 0;
   red = 0;
   green = 0;
@@ -43,16 +106,18 @@ rgb888_t::rgb888_t(){
 
 // Constructor with 6 digits hex color code as argument ((int)0x000000 to (int)0xFFFFFF)
 rgb888_t::rgb888_t(int hex_color_code){
+  STATS_NAMED_STRUCT();
   value = hex_color_code & 0xFFFFFF;
-  red = (uint8_t)(hex_color_code >> 16) & 0xFF;
-  green = (uint8_t)(hex_color_code >> 8) & 0xFF;
-  blue = (uint8_t)(hex_color_code) & 0xFF;
+  red = format_rgb888::red::get(value);
+  green = format_rgb888::green::get(value);
+  blue = format_rgb888::blue::get(value);
   name = "Unknown";
 }
 
 // Constructor with 3 arguments (red, green, blue) as arguments (0 to 255)
 rgb888_t::rgb888_t(uint8_t red, uint8_t green, uint8_t blue){
-  value = ((uint32_t)red << 16) | ((uint32_t)green << 8) | ((uint32_t)blue);
+  STATS_NAMED_STRUCT();
+  value = format_rgb888::place(red, green, blue);
   this->red = red;
   this->green = green;
   this->blue = blue;
@@ -61,26 +126,39 @@ rgb888_t::rgb888_t(uint8_t red, uint8_t green, uint8_t blue){
 
 // Constructor with 2 arguments (name, int hex_color_code) as arguments
 rgb888_t::rgb888_t(const char* name, uint32_t hex_color_code){
+  STATS_NAMED_STRUCT();
   // Serial.println("hex_color_code: " + String(hex_color_code, HEX));
   value = hex_color_code & 0xFFFFFF;
-  red = (uint8_t)(hex_color_code >> 16) & 0xFF;
-  green = (uint8_t)(hex_color_code >> 8) & 0xFF;
-  blue = (uint8_t)(hex_color_code) & 0xFF;
+  red = format_rgb888::red::get(value);
+  green = format_rgb888::green::get(value);
+  blue = format_rgb888::blue::get(value);
   this->name = name;
 }
 
 // Constructor with 4 arguments (name, red, green, blue) as arguments
 rgb888_t::rgb888_t(const char* name, uint8_t red, uint8_t green, uint8_t blue){
-  value = ((uint32_t)red << 16) | ((uint32_t)green << 8) | ((uint32_t)blue);
+  STATS_NAMED_STRUCT();
+  value = format_rgb888::place(red, green, blue);
   this->red = red;
   this->green = green;
   this->blue = blue;
   this->name = name;
 }
 
+// Constructor with packed color as argument
+rgb888_t::rgb888_t(rgb24_t color){
+  STATS_NAMED_STRUCT();
+  value = color.value();
+  red = color.red;
+  green = color.green;
+  blue = color.blue;
+  name = "Unknown";
+}
+
 // 16-bit RGB565 color type
 // default constructor
 rgb565_t::rgb565_t(){
+  STATS_NAMED_STRUCT();
   value = 0;
   red = 0;
   green = 0;
@@ -90,98 +168,287 @@ rgb565_t::rgb565_t(){
 
 // Constructor with 4 digits hex color code as argument ((int)0x0000 to (int)0xFFFF)
 rgb565_t::rgb565_t(int hex_color_code){
+  STATS_NAMED_STRUCT();
   value = hex_color_code & 0xFFFF;
-  red = (uint8_t)(hex_color_code >> 11) & 0x1F;
-  green = (uint8_t)(hex_color_code >> 5) & 0x3F;
-  blue = (uint8_t)(hex_color_code) & 0x1F;
+  red = format_rgb565::red::get(value);
+  green = format_rgb565::green::get(value);
+  blue = format_rgb565::blue::get(value);
   name = "Unknown";
 }
 
 // Constructor with 3 arguments (red, green, blue) as arguments (0 to 255)
 rgb565_t::rgb565_t(uint8_t red, uint8_t green, uint8_t blue){
-  value = ((uint16_t)red << 11) | ((uint16_t)green << 5) | ((uint16_t)blue);
-  this->red = red & 0x1F;
-  this->green = green & 0x3F;
-  this->blue = blue & 0x1F;
+  STATS_NAMED_STRUCT();
+  value = format_rgb565::place(red, green, blue);
+  this->red = format_rgb565::red::get(value);
+  this->green = format_rgb565::green::get(value);
+  this->blue = format_rgb565::blue::get(value);
   name = "Unknown";
 }
 
 // Constructor with 2 arguments (name, int hex_color_code) as arguments
 rgb565_t::rgb565_t(const char* name, uint16_t hex_color_code){
+  STATS_NAMED_STRUCT();
   value = hex_color_code & 0xFFFF;
-  red = (uint8_t)(hex_color_code >> 11) & 0x1F;
-  green = (uint8_t)(hex_color_code >> 5) & 0x3F;
-  blue = (uint8_t)(hex_color_code) & 0x1F;
+  red = format_rgb565::red::get(value);
+  green = format_rgb565::green::get(value);
+  blue = format_rgb565::blue::get(value);
   this->name = name;
 }
 
 // Constructor with 4 arguments (name, red, green, blue) as arguments
 rgb565_t::rgb565_t(const char* name, uint8_t red, uint8_t green, uint8_t blue){
-  value = ((uint16_t)red << 11) | ((uint16_t)green << 5) | ((uint16_t)blue);
-  this->red = red & 0x1F;
-  this->green = green & 0x3F;
-  this->blue = blue & 0x1F;
+  STATS_NAMED_STRUCT();
+  value = format_rgb565::place(red, green, blue);
+  this->red = format_rgb565::red::get(value);
+  this->green = format_rgb565::green::get(value);
+  this->blue = format_rgb565::blue::get(value);
   this->name = name;
 }
 
+// Constructor with packed color as argument
+rgb565_t::rgb565_t(rgb16_t color){
+  STATS_NAMED_STRUCT();
+  value = color.value;
+  red = color.red();
+  green = color.green();
+  blue = color.blue();
+  name = "Unknown";
+}
+
 /* COLOR CONVERSION FUNCTIONS */
 
 // Convert 24-bit RGB888 to 16-bit RGB565
-rgb565_t rgb888_to_rgb565(rgb888_t rgb888){
-  rgb565_t rgb565;
-  rgb565.red = (uint8_t)round((float)rgb888.red / 255.0 * 31.0) & 0x1F;
-  rgb565.green = (uint8_t)round((float)rgb888.green / 255.0 * 63.0) & 0x3F;
-  rgb565.blue = (uint8_t)round((float)rgb888.blue / 255.0 * 31.0) & 0x1F;
-  rgb565.value = ((uint16_t)rgb565.red << 11) | ((uint16_t)rgb565.green << 5) | ((uint16_t)rgb565.blue);
+rgb565_t rgb888_to_rgb565(const rgb888_t& rgb888){
+  COLORS_STATS_CALL(COLORS_STATS_CONVERSION, 1);
+  rgb565_t rgb565 = rgb888_to_rgb565((rgb24_t)rgb888);
   rgb565.name = rgb888.name;
   return rgb565;
 }
 // Convert 16-bit RGB565 to 24-bit RGB888
-rgb888_t rgb565_to_rgb888(rgb565_t rgb565){
-  rgb888_t rgb888;
-  rgb888.red = (uint8_t)round((float)rgb565.red / 31.0 * 255.0) & 0xFF;
-  rgb888.green = (uint8_t)round((float)rgb565.green / 63.0 * 255.0) & 0xFF;
-  rgb888.blue = (uint8_t)round((float)rgb565.blue / 31.0 * 255.0) & 0xFF;
-  rgb888.value = ((uint32_t)rgb888.red << 16) | ((uint32_t)rgb888.green << 8) | ((uint32_t)rgb888.blue);
+rgb888_t rgb565_to_rgb888(const rgb565_t& rgb565){
+  COLORS_STATS_CALL(COLORS_STATS_CONVERSION, 1);
+  rgb888_t rgb888 = rgb565_to_rgb888((rgb16_t)rgb565);
   rgb888.name = rgb565.name;
   return rgb888;
 }
 // Convert 24-bit RGB888 to String hex color code
-String rgb888_to_String(rgb888_t rgb888){
-  String hex_color_code = "0x";
-  if (rgb888.red < 16) hex_color_code += "0";
-  hex_color_code += String(rgb888.red, HEX);
-  if (rgb888.green < 16) hex_color_code += "0";
-  hex_color_code += String(rgb888.green, HEX);
-  if (rgb888.blue < 16) hex_color_code += "0";
-  hex_color_code += String(rgb888.blue, HEX);
-  return hex_color_code;
+String rgb888_to_String(const rgb888_t& rgb888){
+  COLORS_STATS_SCOPE(COLORS_STATS_STRING, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_STRING, COLORS_STATS_ALLOCATIONS, 1);
+  char hex_color_code[COLOR_STRING_SIZE];
+  format_color((rgb24_t)rgb888, hex_color_code, sizeof(hex_color_code), COLOR_FORMAT_HEX);
+  return String(hex_color_code);
 }
 // Convert 16-bit RGB565 to String hex color code, consider the 16-bit RGB565 as a 4 digits hex color code RRRRR GGGGGG BBBBB more significant byte is RRRRRGGG less significant byte is GGGBBBBB
-String rgb565_to_String(rgb565_t rgb565){
-  String hex_color_code = "0x";
-  // more significant byte is RRRRRGGG
-  uint8_t more_significant_byte = (rgb565.red << 3) | (rgb565.green >> 3);
-  if (more_significant_byte < 16) hex_color_code += "0";
-  hex_color_code += String(more_significant_byte, HEX);
+String rgb565_to_String(const rgb565_t& rgb565){
+  COLORS_STATS_SCOPE(COLORS_STATS_STRING, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_STRING, COLORS_STATS_ALLOCATIONS, 1);
+  char hex_color_code[COLOR_STRING_SIZE];
+  format_color((rgb16_t)rgb565, hex_color_code, sizeof(hex_color_code));
+  return String(hex_color_code);
+}
 
-  // less significant byte is GGGBBBBB
-  uint8_t less_significant_byte = ((rgb565.green & 0x07) << 5) | rgb565.blue;
-  if (less_significant_byte < 16) hex_color_code += "0";
-  hex_color_code += String(less_significant_byte, HEX);
-  return hex_color_code;
+/* COLOR STRING FUNCTIONS */
+
+// Lower case hex digits
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Write the 2 hex digits of a byte
+static inline char* write_hex_byte(char* text, uint8_t value){
+  text[0] = HEX_DIGITS[value >> 4];
+  text[1] = HEX_DIGITS[value & 0x0F];
+  return text + 2;
+}
+
+// Round an 8-bit channel to the nearest multiple of 17 and return the multiplier (0 to 15, same result as (c + 8) / 17)
+static inline uint8_t channel8_to_4(uint8_t channel){
+  return (uint8_t)(((uint16_t)channel + 8) * 241 >> 12);
+}
+
+// Write a RGB888 color into buffer
+size_t format_color(rgb24_t color, char* buffer, size_t size, color_format_t format){
+  size_t length = format == COLOR_FORMAT_CSS_SHORT ? 4 : (format == COLOR_FORMAT_CSS ? 7 : 8);
+  if (size <= length){
+    if (size > 0) buffer[0] = '\0';
+    return 0;
+  }
+  char* text = buffer;
+  if (format == COLOR_FORMAT_CSS_SHORT){
+    *text++ = '#';
+    *text++ = HEX_DIGITS[channel8_to_4(color.red)];
+    *text++ = HEX_DIGITS[channel8_to_4(color.green)];
+    *text++ = HEX_DIGITS[channel8_to_4(color.blue)];
+  }
+  else{
+    if (format == COLOR_FORMAT_CSS) *text++ = '#';
+    else{
+      *text++ = '0';
+      *text++ = 'x';
+    }
+    text = write_hex_byte(text, color.red);
+    text = write_hex_byte(text, color.green);
+    text = write_hex_byte(text, color.blue);
+  }
+  *text = '\0';
+  return length;
+}
+
+// Write a RGB565 color as its 4 digits word into buffer
+size_t format_color(rgb16_t color, char* buffer, size_t size){
+  if (size <= 6){
+    if (size > 0) buffer[0] = '\0';
+    return 0;
+  }
+  buffer[0] = '0';
+  buffer[1] = 'x';
+  write_hex_byte(write_hex_byte(buffer + 2, (uint8_t)(color.value >> 8)), (uint8_t)color.value);
+  buffer[6] = '\0';
+  return 6;
+}
+
+// Value of a hex digit, 0xFF if c is not a hex digit
+static inline uint8_t hex_digit(char c){
+  if (c >= '0' && c <= '9') return (uint8_t)(c - '0');
+  c = (char)(c | 0x20);
+  if (c >= 'a' && c <= 'f') return (uint8_t)(c - 'a' + 10);
+  return 0xFF;
+}
+
+// Value of count hex digits, false if one of them is not a hex digit
+static bool parse_hex(const char* text, uint8_t count, uint32_t* value){
+  uint32_t result = 0;
+  for (uint8_t i = 0; i < count; i++){
+    uint8_t digit = hex_digit(text[i]);
+    if (digit == 0xFF) return false;
+    result = (result << 4) | digit;
+  }
+  *value = result;
+  return true;
+}
+
+// Space, tab or line end
+static inline bool is_space(char c){
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Remove the spaces around text
+static void trim(const char** text, size_t* length){
+  while (*length > 0 && is_space(**text)){
+    (*text)++;
+    (*length)--;
+  }
+  while (*length > 0 && is_space((*text)[*length - 1])) (*length)--;
+}
+
+// Parse a decimal channel (0 to 255) of rgb(r, g, b) and the spaces around it, false if invalid
+static bool parse_channel(const char** text, const char* end, uint8_t* channel){
+  while (*text < end && is_space(**text)) (*text)++;
+  uint16_t value = 0;
+  uint8_t digits = 0;
+  while (*text < end && **text >= '0' && **text <= '9'){
+    value = (uint16_t)(value * 10 + (**text - '0'));
+    if (++digits > 3 || value > 255) return false;
+    (*text)++;
+  }
+  while (*text < end && is_space(**text)) (*text)++;
+  *channel = (uint8_t)value;
+  return digits > 0;
+}
+
+// Parse a color string of length characters
+bool parse_color(const char* text, size_t length, rgb24_t* color){
+  trim(&text, &length);
+  uint32_t value;
+  if (length == 4 && text[0] == '#' && parse_hex(text + 1, 3, &value)){
+    *color = rgb24_t((uint8_t)((value >> 8) * 17), (uint8_t)(((value >> 4) & 0x0F) * 17), (uint8_t)((value & 0x0F) * 17));
+    return true;
+  }
+  if ((length == 7 && text[0] == '#' && parse_hex(text + 1, 6, &value))
+   || (length == 8 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X') && parse_hex(text + 2, 6, &value))){
+    *color = rgb24_t(value);
+    return true;
+  }
+  if (length > 4 && strncasecmp(text, "rgb(", 4) == 0 && text[length - 1] == ')'){
+    const char* end = text + length - 1;
+    text += 4;
+    uint8_t red, green, blue;
+    if (!parse_channel(&text, end, &red) || text == end || *text++ != ',') return false;
+    if (!parse_channel(&text, end, &green) || text == end || *text++ != ',') return false;
+    if (!parse_channel(&text, end, &blue) || text != end) return false;
+    *color = rgb24_t(red, green, blue);
+    return true;
+  }
+  if (length > 0 && length < COLOR_NAME_SIZE){
+    char name[COLOR_NAME_SIZE];
+    memcpy(name, text, length);
+    name[length] = '\0';
+    uint8_t index = find_color_by_name(name);
+    if (index != COLOR_NOT_FOUND){
+      *color = COLORS[index];
+      return true;
+    }
+  }
+  return false;
+}
+
+// Parse a null terminated color string
+bool parse_color(const char* text, rgb24_t* color){
+  return parse_color(text, strlen(text), color);
+}
+
+// Parse a RGB565 word string of length characters
+bool parse_color(const char* text, size_t length, rgb16_t* color){
+  trim(&text, &length);
+  uint32_t value;
+  if (length != 6 || text[0] != '0' || (text[1] != 'x' && text[1] != 'X') || !parse_hex(text + 2, 4, &value)) return false;
+  *color = rgb16_t((uint16_t)value);
+  return true;
+}
+
+// Parse a buffer of color strings separated by commas or new lines
+size_t parse_colors(const char* text, size_t length, rgb24_t* colors, size_t max_count, size_t* invalid){
+  size_t count = 0;
+  size_t invalid_count = 0;
+  size_t position = 0;
+  while (position < length && count < max_count){
+    // runs of compact #rrggbb entries (rgb24_t is 3 bytes, red first)
+    position += simd_parse_hex_colors(text + position, length - position, (uint8_t*)(colors + count), max_count - count, count);
+    if (position >= length || count >= max_count) break;
+
+    // next entry, commas inside parentheses belong to it
+    size_t end = position;
+    uint8_t depth = 0;
+    for (; end < length; end++){
+      char c = text[end];
+      if (c == '(') depth++;
+      else if (c == ')' && depth > 0) depth--;
+      else if (c == '\n' || (c == ',' && depth == 0)) break;
+    }
+
+    const char* entry = text + position;
+    size_t entry_length = end - position;
+    trim(&entry, &entry_length);
+    if (entry_length > 0){
+      if (!parse_color(entry, entry_length, colors + count)){
+        colors[count] = rgb24_t(0, 0, 0);
+        invalid_count++;
+      }
+      count++;
+    }
+    position = end + 1;
+  }
+  if (invalid != nullptr) *invalid = invalid_count;
+  return count;
 }
 
 
 /* COMPARE COLORS FUNCTIONS */
 
 // Compare 24-bit RGB888 colors
-float color_similarity(rgb888_t rgb888_1, rgb888_t rgb888_2){
-  float similarity = 0.0;
-  similarity += pow((float)rgb888_1.red - (float)rgb888_2.red, 2);
-  similarity += pow((float)rgb888_1.green - (float)rgb888_2.green, 2);
-  similarity += pow((float)rgb888_1.blue - (float)rgb888_2.blue, 2);
-  similarity = sqrt(similarity);
+float color_similarity(const rgb888_t& rgb888_1, const rgb888_t& rgb888_2){
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  float similarity = sqrt((float)color_distance_sq((rgb24_t)rgb888_1, (rgb24_t)rgb888_2));
 
   // normalize the similarity
   similarity = 1.0 - (similarity / (sqrt(pow(255.0, 2) * 3.0)));
@@ -190,12 +457,9 @@ float color_similarity(rgb888_t rgb888_1, rgb888_t rgb888_2){
 }
 
 // Compare 16-bit RGB565 colors
-float color_similarity(rgb565_t rgb565_1, rgb565_t rgb565_2){
-  float similarity = 0.0;
-  similarity += pow((float)rgb565_1.red - (float)rgb565_2.red, 2);
-  similarity += pow((float)rgb565_1.green - (float)rgb565_2.green, 2);
-  similarity += pow((float)rgb565_1.blue - (float)rgb565_2.blue, 2);
-  similarity = sqrt(similarity);
+float color_similarity(const rgb565_t& rgb565_1, const rgb565_t& rgb565_2){
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  float similarity = sqrt((float)color_distance_sq((rgb16_t)rgb565_1, (rgb16_t)rgb565_2));
 
   // normalize the similarity
   similarity = 1.0 - (similarity / (sqrt(pow(31.0, 2) * 3.0)));
@@ -204,16 +468,12 @@ float color_similarity(rgb565_t rgb565_1, rgb565_t rgb565_2){
 }
 
 // Compare 24-bit RGB888 and 16-bit RGB565 colors
-float color_similarity(rgb888_t rgb888, rgb565_t rgb565){
-  float similarity = 0.0;
-
+float color_similarity(const rgb888_t& rgb888, const rgb565_t& rgb565){
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
   // convert rgb888 to rgb565
-  rgb565_t rgb565_2 = rgb888_to_rgb565(rgb888);
+  rgb16_t rgb565_2 = rgb888_to_rgb565((rgb24_t)rgb888);
 
-  similarity += pow((float)rgb565.red - (float)rgb565_2.red, 2);
-  similarity += pow((float)rgb565.green - (float)rgb565_2.green, 2);
-  similarity += pow((float)rgb565.blue - (float)rgb565_2.blue, 2);
-  similarity = sqrt(similarity);
+  float similarity = sqrt((float)color_distance_sq((rgb16_t)rgb565, rgb565_2));
 
   // normalize the similarity
   similarity = 1.0 - (similarity / (sqrt(pow(255.0, 2) * 3.0)));
@@ -222,17 +482,13 @@ float color_similarity(rgb888_t rgb888, rgb565_t rgb565){
 }
 
 // Compare 16-bit RGB565 and 24-bit RGB888 colors
-float color_similarity(rgb565_t rgb565, rgb888_t rgb888){
-  float similarity = 0.0;
-
+float color_similarity(const rgb565_t& rgb565, const rgb888_t& rgb888){
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
   // convert rgb888 to rgb565
-  rgb565_t rgb565_2 = rgb888_to_rgb565(rgb888);
+  rgb16_t rgb565_2 = rgb888_to_rgb565((rgb24_t)rgb888);
 
   // calculate the similarity between the colors in rgb565 with method euclidean distance
-  similarity += pow((float)rgb565.red - (float)rgb565_2.red, 2);
-  similarity += pow((float)rgb565.green - (float)rgb565_2.green, 2);
-  similarity += pow((float)rgb565.blue - (float)rgb565_2.blue, 2);
-  similarity = sqrt(similarity);
+  float similarity = sqrt((float)color_distance_sq((rgb16_t)rgb565, rgb565_2));
 
   // normalize the similarity
   similarity = 1.0 - (similarity / (sqrt(pow(31.0,2.0)+pow(63.0,2.0)+pow(31.0,2.0))));
@@ -245,132 +501,340 @@ float color_similarity(rgb565_t rgb565, rgb888_t rgb888){
 
 /* COLOR LIST FUNCTIONS */
 
-// Get color from color list by name
-rgb888_t get_color_by_name(const char* name, const rgb888_t* colors_list){
+// Get color from color list by name (case insensitive)
+rgb888_t get_color_by_name(const char* name, const rgb888_t* colors_list, size_t size){
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_MISSES, 1);
   rgb888_t color;
-  // size of the list
-  int size = sizeof(colors_list) / sizeof(colors_list[0]);
-
-  for (int i = 0; i < size; i++){
-    if (name == colors_list[i].name){
+  size_t i = 0;
+  for (; i < size; i++){
+    if (strcasecmp(name, colors_list[i].name.c_str()) == 0){
       color = colors_list[i];
       break;
     }
   }
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_ENTRIES, i < size ? i + 1 : size);
   return color;
 }
 
 // Get color from color list by hex color code
-rgb888_t get_color_by_hex_color_code(int hex_color_code, const rgb888_t* colors_list){
+rgb888_t get_color_by_hex(int hex_color_code, const rgb888_t* colors_list, size_t size){
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_MISSES, 1);
   rgb888_t color;
-  // size of the list
-  int size = sizeof(colors_list) / sizeof(colors_list[0]);
-
-  for (int i = 0; i < size; i++){
-    if (hex_color_code == colors_list[i].value){
+  size_t i = 0;
+  for (; i < size; i++){
+    if ((uint32_t)hex_color_code == colors_list[i].value){
       color = colors_list[i];
       break;
     }
   }
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_ENTRIES, i < size ? i + 1 : size);
   return color;
 }
 
-// Get most similar color from color list
-rgb888_t get_similar_color888(rgb888_t rgb888, const rgb888_t* colors_list){
-  rgb888_t color;
-  // size of the list
-  int size = sizeof(colors_list) / sizeof(colors_list[0]);
-
-  float _similarity = 0.0;
-  float max_similarity = 0.0;
-  int index = 0;
+// Get most similar color from color list (ranked by squared euclidean distance, same order as color_similarity)
+rgb888_t get_similar_color888(const rgb888_t& rgb888, const rgb888_t* colors_list, size_t size){
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_MISSES, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, size);
+  if (size == 0) return rgb888_t();
+  uint32_t min_distance = UINT32_MAX;
+  size_t index = 0;
+
+  rgb24_t color = rgb888;
+  for (size_t i = 0; i < size; i++){
+    uint32_t distance = color_distance_sq(color, rgb24_t(colors_list[i]));
+    if (distance < min_distance){
+      min_distance = distance;
+      index = i;
+    }
+  }
+  return colors_list[index];
+}
 
-  for (int i = 0; i < size; i++){
-    _similarity = color_similarity(rgb888, colors_list[i]);
-    if (_similarity > max_similarity){
-      max_similarity = _similarity;
+// Get most similar color from color list (compared in RGB565 space, same order as color_similarity)
+rgb565_t get_similar_color565(const rgb565_t& rgb565, const rgb888_t* colors_list, size_t size){
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_MISSES, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, size);
+  if (size == 0) return rgb565_t();
+  uint16_t min_distance = UINT16_MAX;
+  size_t index = 0;
+
+  rgb16_t color = rgb565;
+  for (size_t i = 0; i < size; i++){
+    uint16_t distance = color_distance_sq(color, rgb888_to_rgb565(rgb24_t(colors_list[i])));
+    if (distance < min_distance){
+      min_distance = distance;
       index = i;
     }
   }
-  color = colors_list[index];
-  return color;
+  return rgb888_to_rgb565(colors_list[index]);
 }
 
-// Get most similar color from color list
-rgb565_t get_similar_color565(rgb565_t rgb565, const rgb888_t colors_list[]){
-  rgb565_t color;
-  // size of the list
-  // int size = sizeof(colors_list) / sizeof(colors_list[0]);
-  int size = 50;
-  // Serial.println("Size: " + String(size));
+/* PACKED COLOR LIST FUNCTIONS */
 
-  float _similarity = 0.0;
-  float max_similarity = 0.0;
-  int index = 0;
+// Get a color from a packed color list, named if the list is the named colors list
+static rgb888_t get_list_color(const rgb24_t* colors_list, size_t index){
+  if (colors_list == COLORS) return get_named_color(index);
+  return rgb888_t(colors_list[index]);
+}
 
+// Get color from the named colors list by name (case insensitive)
+rgb888_t get_color_by_name(const char* name){
+  return get_named_color(find_color_by_name(name));
+}
 
-  for (int i = 0; i < size; i++){
-    _similarity = color_similarity(rgb565, colors_list[i]);
-    if (_similarity > max_similarity){
-      max_similarity = _similarity;
+// Get color from packed color list by hex color code
+rgb888_t get_color_by_hex(int hex_color_code, const rgb24_t* colors_list, size_t size){
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  if (colors_list == COLORS && size == COLORS_COUNT) return get_named_color(find_color_by_hex((uint32_t)hex_color_code));
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_MISSES, 1);
+  for (size_t i = 0; i < size; i++){
+    if ((uint32_t)hex_color_code == colors_list[i].value()){
+      COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_ENTRIES, i + 1);
+      return get_list_color(colors_list, i);
+    }
+  }
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_ENTRIES, size);
+  return rgb888_t();
+}
+
+// Get most similar color from packed color list (ranked by squared euclidean distance, same order as color_similarity)
+rgb888_t get_similar_color888(const rgb888_t& rgb888, const rgb24_t* colors_list, size_t size){
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_MISSES, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, size);
+  if (size == 0) return rgb888_t();
+  uint32_t min_distance = UINT32_MAX;
+  size_t index = 0;
+
+  rgb24_t color = rgb888;
+  for (size_t i = 0; i < size; i++){
+    uint32_t distance = color_distance_sq(color, colors_list[i]);
+    if (distance < min_distance){
+      min_distance = distance;
       index = i;
     }
-    // Serial.println("Index: " + String(i) + " Similarity: " + String(_similarity) + " Max similarity: " + String(max_similarity) + " Color1: " + rgb565_to_String(rgb565) + " Color2: " + rgb888_to_String(colors_list[i]));
   }
-  color = rgb888_to_rgb565(colors_list[index]);
-  return color;
+  return get_list_color(colors_list, index);
+}
+
+// Get most similar color from packed color list (compared in RGB565 space, same order as color_similarity)
+rgb565_t get_similar_color565(const rgb565_t& rgb565, const rgb24_t* colors_list, size_t size){
+  COLORS_STATS_SCOPE(COLORS_STATS_SIMILARITY, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_MISSES, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_SIMILARITY, COLORS_STATS_ENTRIES, size);
+  if (size == 0) return rgb565_t();
+  uint16_t min_distance = UINT16_MAX;
+  size_t index = 0;
+
+  rgb16_t color = rgb565;
+  for (size_t i = 0; i < size; i++){
+    uint16_t distance = color_distance_sq(color, rgb888_to_rgb565(colors_list[i]));
+    if (distance < min_distance){
+      min_distance = distance;
+      index = i;
+    }
+  }
+  return rgb888_to_rgb565(get_list_color(colors_list, index));
 }
 
 /* NAMED COLORS LIST */
-extern const rgb888_t COLORS[] = {
-  {"Aqua", 0x00FFFF},
-  {"Aquamarine", 0x7FFFD4},
-  {"Azure", 0xF0FFFF},
-  {"Beige", 0xF5F5DC},
-  {"Bisque", 0xFFE4C4},
-  {"Black", 0x000000},
-  {"Blue", 0x0000FF},
-  {"Brown", 0xA52A2A},
-  {"Chartreuse", 0x7FFF00},
-  {"Chocolate", 0xD2691E},
-  {"Coral", 0xFF7F50},
-  {"Cornsilk", 0xFFF8DC},
-  {"Crimson", 0xDC143C},
-  {"Cyan", 0x00FFFF},
-  {"Fuchsia", 0xFF00FF},
-  {"Gainsboro", 0xDCDCDC},
-  {"Gold", 0xFFD700},
-  {"Gray", 0x808080},
-  {"Green", 0x008000},
-  {"Indigo", 0x4B0082},
-  {"Ivory", 0xFFFFF0},
-  {"Khaki", 0xF0E68C},
-  {"Lavender", 0xE6E6FA},
-  {"Lime", 0x00FF00},
-  {"Linen", 0xFAF0E6},
-  {"Magenta", 0xFF00FF},
-  {"Maroon", 0x800000},
-  {"Moccasin", 0xFFE4B5},
-  {"Navy", 0x000080},
-  {"Olive", 0x808000},
-  {"Orange", 0xFFA500},
-  {"Orchid", 0xDA70D6},
-  {"Peru", 0xCD853F},
-  {"Pink", 0xFFC0CB},
-  {"Plum", 0xDDA0DD},
-  {"Purple", 0x800080},
-  {"Red", 0xFF0000},
-  {"Salmon", 0xFA8072},
-  {"Sienna", 0xA0522D},
-  {"Silver", 0xC0C0C0},
-  {"Snow", 0xFFFAFA},
-  {"Tan", 0xD2B48C},
-  {"Teal", 0x008080},
-  {"Thistle", 0xD8BFD8},
-  {"Tomato", 0xFF6347},
-  {"Turquoise", 0x40E0D0},
-  {"Violet", 0xEE82EE},
-  {"Wheat", 0xF5DEB3},
-  {"White", 0xFFFFFF},
-  {"Yellow", 0xFFFF00}
+constexpr rgb24_t COLORS[COLORS_COUNT] = {
+  rgb24_t(0x00FFFF),
+  rgb24_t(0x7FFFD4),
+  rgb24_t(0xF0FFFF),
+  rgb24_t(0xF5F5DC),
+  rgb24_t(0xFFE4C4),
+  rgb24_t(0x000000),
+  rgb24_t(0x0000FF),
+  rgb24_t(0xA52A2A),
+  rgb24_t(0x7FFF00),
+  rgb24_t(0xD2691E),
+  rgb24_t(0xFF7F50),
+  rgb24_t(0xFFF8DC),
+  rgb24_t(0xDC143C),
+  rgb24_t(0x00FFFF),
+  rgb24_t(0xFF00FF),
+  rgb24_t(0xDCDCDC),
+  rgb24_t(0xFFD700),
+  rgb24_t(0x808080),
+  rgb24_t(0x008000),
+  rgb24_t(0x4B0082),
+  rgb24_t(0xFFFFF0),
+  rgb24_t(0xF0E68C),
+  rgb24_t(0xE6E6FA),
+  rgb24_t(0x00FF00),
+  rgb24_t(0xFAF0E6),
+  rgb24_t(0xFF00FF),
+  rgb24_t(0x800000),
+  rgb24_t(0xFFE4B5),
+  rgb24_t(0x000080),
+  rgb24_t(0x808000),
+  rgb24_t(0xFFA500),
+  rgb24_t(0xDA70D6),
+  rgb24_t(0xCD853F),
+  rgb24_t(0xFFC0CB),
+  rgb24_t(0xDDA0DD),
+  rgb24_t(0x800080),
+  rgb24_t(0xFF0000),
+  rgb24_t(0xFA8072),
+  rgb24_t(0xA0522D),
+  rgb24_t(0xC0C0C0),
+  rgb24_t(0xFFFAFA),
+  rgb24_t(0xD2B48C),
+  rgb24_t(0x008080),
+  rgb24_t(0xD8BFD8),
+  rgb24_t(0xFF6347),
+  rgb24_t(0x40E0D0),
+  rgb24_t(0xEE82EE),
+  rgb24_t(0xF5DEB3),
+  rgb24_t(0xFFFFFF),
+  rgb24_t(0xFFFF00)
+};
+
+constexpr char COLOR_NAMES[COLORS_COUNT][COLOR_NAME_SIZE] PROGMEM = {
+  "Aqua",
+  "Aquamarine",
+  "Azure",
+  "Beige",
+  "Bisque",
+  "Black",
+  "Blue",
+  "Brown",
+  "Chartreuse",
+  "Chocolate",
+  "Coral",
+  "Cornsilk",
+  "Crimson",
+  "Cyan",
+  "Fuchsia",
+  "Gainsboro",
+  "Gold",
+  "Gray",
+  "Green",
+  "Indigo",
+  "Ivory",
+  "Khaki",
+  "Lavender",
+  "Lime",
+  "Linen",
+  "Magenta",
+  "Maroon",
+  "Moccasin",
+  "Navy",
+  "Olive",
+  "Orange",
+  "Orchid",
+  "Peru",
+  "Pink",
+  "Plum",
+  "Purple",
+  "Red",
+  "Salmon",
+  "Sienna",
+  "Silver",
+  "Snow",
+  "Tan",
+  "Teal",
+  "Thistle",
+  "Tomato",
+  "Turquoise",
+  "Violet",
+  "Wheat",
+  "White",
+  "Yellow"
 };
+
+// Indexes of COLORS sorted by value (then index), for the hex lookup
+static constexpr uint8_t COLOR_VALUE_ORDER[COLORS_COUNT] PROGMEM = {
+  5, 28, 6, 18, 42, 23, 0, 13, 45, 19, 8, 1, 26, 35, 29, 17, 38, 7, 39, 32, 9, 41, 43, 31, 12,
+  15, 34, 22, 46, 21, 2, 47, 3, 37, 24, 36, 14, 25, 44, 10, 30, 33, 16, 27, 4, 11, 40, 49, 20, 48
+};
+
+// Lower case of an ASCII character
+constexpr char lower_case(char c){
+  return c >= 'A' && c <= 'Z' ? (char)(c + ('a' - 'A')) : c;
+}
+
+// Case insensitive comparison of two names (same sign as strcasecmp)
+constexpr int compare_names(const char* name_1, const char* name_2){
+  return lower_case(*name_1) != lower_case(*name_2) || *name_1 == '\0'
+       ? lower_case(*name_1) - lower_case(*name_2)
+       : compare_names(name_1 + 1, name_2 + 1);
+}
+
+// COLOR_NAMES is sorted from index onwards (checked at compile time, the name lookup is a binary search)
+constexpr bool names_sorted(uint8_t index){
+  return index + 1 >= COLORS_COUNT || (compare_names(COLOR_NAMES[index], COLOR_NAMES[index + 1]) < 0 && names_sorted(index + 1));
+}
+
+// COLOR_VALUE_ORDER is sorted by value then index from position onwards (checked at compile time, so it is a permutation of COLORS)
+constexpr bool values_sorted(uint8_t position){
+  return position + 1 >= COLORS_COUNT
+      || ((COLORS[COLOR_VALUE_ORDER[position]].value() < COLORS[COLOR_VALUE_ORDER[position + 1]].value()
+          || (COLORS[COLOR_VALUE_ORDER[position]].value() == COLORS[COLOR_VALUE_ORDER[position + 1]].value() && COLOR_VALUE_ORDER[position] < COLOR_VALUE_ORDER[position + 1]))
+        && values_sorted(position + 1));
+}
+
+static_assert(names_sorted(0), "COLOR_NAMES must be sorted case insensitive");
+static_assert(values_sorted(0), "COLOR_VALUE_ORDER must sort COLORS by value");
+
+// Copy the name of COLORS[index] into buffer, returns the name length (0 if index is out of range)
+size_t get_color_name(uint8_t index, char* buffer, size_t size){
+  if (size == 0) return 0;
+  size_t length = 0;
+  if (index < COLORS_COUNT){
+    const char* name = COLOR_NAMES[index];
+    char c;
+    while (length + 1 < size && (c = (char)pgm_read_byte(name + length)) != '\0'){
+      buffer[length++] = c;
+    }
+  }
+  buffer[length] = '\0';
+  return length;
+}
+
+// Get COLORS[index] as a named rgb888_t
+rgb888_t get_named_color(uint8_t index){
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  if (index >= COLORS_COUNT) return rgb888_t();
+  char name[COLOR_NAME_SIZE];
+  get_color_name(index, name, sizeof(name));
+  return rgb888_t(name, COLORS[index].value());
+}
+
+// Index of a named color by name (case insensitive binary search over the sorted names)
+uint8_t find_color_by_name(const char* name){
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_HITS, 1);
+  uint8_t low = 0;
+  uint8_t high = COLORS_COUNT;
+  while (low < high){
+    uint8_t middle = (low + high) >> 1;
+    int order = strcasecmp_P(name, COLOR_NAMES[middle]);
+    if (order == 0) return middle;
+    if (order < 0) high = middle;
+    else low = middle + 1;
+  }
+  return COLOR_NOT_FOUND;
+}
+
+// Index of a named color by 24-bit value (binary search over the sorted index, lowest index on duplicates)
+uint8_t find_color_by_hex(uint32_t hex_color_code){
+  COLORS_STATS_SCOPE(COLORS_STATS_LOOKUP, 1);
+  COLORS_STATS_COUNT(COLORS_STATS_LOOKUP, COLORS_STATS_HITS, 1);
+  // first position whose value is not below the searched value
+  uint8_t low = 0;
+  uint8_t high = COLORS_COUNT;
+  while (low < high){
+    uint8_t middle = (low + high) >> 1;
+    if (COLORS[pgm_read_byte(COLOR_VALUE_ORDER + middle)].value() < hex_color_code) low = middle + 1;
+    else high = middle;
+  }
+  if (low == COLORS_COUNT) return COLOR_NOT_FOUND;
+  uint8_t index = pgm_read_byte(COLOR_VALUE_ORDER + low);
+  return COLORS[index].value() == hex_color_code ? index : COLOR_NOT_FOUND;
+}